@@ -6,6 +6,12 @@
 /* @(#) $Id$ */
 
 #include "zutil.h"
+#ifdef Z_X86_SIMD
+#  include <immintrin.h>
+#endif
+#ifdef Z_ARM_SIMD
+#  include <arm_neon.h>
+#endif
 
 local uLong adler32_combine_ OF((uLong adler1, uLong adler2, z_off64_t len2));
 
@@ -60,7 +66,7 @@ local uLong adler32_combine_ OF((uLong adler1, uLong adler2, z_off64_t len2));
 #endif
 
 /* ========================================================================= */
-uLong ZEXPORT adler32_z(adler, buf, len)
+uLong ZLIB_INTERNAL adler32_base(adler, buf, len)
     uLong adler;
     const Bytef *buf;
     z_size_t len;
@@ -130,6 +136,245 @@ uLong ZEXPORT adler32_z(adler, buf, len)
     return adler | (sum2 << 16);
 }
 
+#if defined(Z_X86_SIMD) || defined(Z_ARM_SIMD)
+/* =========================================================================
+ * The vectorized versions take VBLOCK bytes at a time. Over n such pieces,
+ * adler advances by the sum of all of the bytes, and sum2 by VBLOCK times n
+ * times the initial adler, plus VBLOCK times the sum of the advances of adler
+ * before each piece, plus each piece's bytes weighted VBLOCK down to 1. Those
+ * are accumulated in vector lanes with multiply-adds, and reduced modulo BASE
+ * after each run of VPIECES pieces, which is no more than NMAX bytes. The
+ * last len % VBLOCK bytes are left to adler32_base().
+ */
+#define VBLOCK 32
+#define VPIECES (NMAX / VBLOCK)
+#endif
+
+#ifdef Z_X86_SIMD
+/* Return the sum of the four 32-bit lanes of v. */
+local unsigned hsum128 OF((__m128i v));
+local unsigned hsum128(v)
+    __m128i v;
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0x4e));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0xb1));
+    return (unsigned)_mm_cvtsi128_si32(v);
+}
+
+/* ========================================================================= */
+Z_TARGET("ssse3") uLong ZLIB_INTERNAL adler32_ssse3(adler, buf, len)
+    uLong adler;
+    const Bytef *buf;
+    z_size_t len;
+{
+    unsigned long sum2;
+    unsigned n;
+    __m128i b1, b2, vs1, vs2, vps;
+    __m128i zero = _mm_setzero_si128();
+    __m128i ones = _mm_set1_epi16(1);
+    __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                 24, 23, 22, 21, 20, 19, 18, 17);
+    __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                                 8, 7, 6, 5, 4, 3, 2, 1);
+
+    /* initial Adler-32 value */
+    if (buf == Z_NULL)
+        return 1L;
+    if (len < VBLOCK)
+        return adler32_base(adler, buf, len);
+
+    /* split Adler-32 into component sums */
+    sum2 = (adler >> 16) & 0xffff;
+    adler &= 0xffff;
+
+    /* do runs of up to VPIECES pieces -- each requires one modulo */
+    while (len >= VBLOCK) {
+        n = len / VBLOCK < VPIECES ? (unsigned)(len / VBLOCK) : VPIECES;
+        len -= (z_size_t)n * VBLOCK;
+        vps = _mm_cvtsi32_si128((int)(adler * n));
+        vs1 = zero;
+        vs2 = zero;
+        do {
+            b1 = _mm_loadu_si128((const __m128i *)buf);
+            b2 = _mm_loadu_si128((const __m128i *)(buf + 16));
+            vps = _mm_add_epi32(vps, vs1);
+            vs1 = _mm_add_epi32(vs1, _mm_sad_epu8(b1, zero));
+            vs1 = _mm_add_epi32(vs1, _mm_sad_epu8(b2, zero));
+            vs2 = _mm_add_epi32(vs2,
+                          _mm_madd_epi16(_mm_maddubs_epi16(b1, tap1), ones));
+            vs2 = _mm_add_epi32(vs2,
+                          _mm_madd_epi16(_mm_maddubs_epi16(b2, tap2), ones));
+            buf += VBLOCK;
+        } while (--n);
+        vs2 = _mm_add_epi32(vs2, _mm_slli_epi32(vps, 5));
+        adler += hsum128(vs1);
+        sum2 += hsum128(vs2);
+        MOD(adler);
+        MOD(sum2);
+    }
+
+    /* do the remaining bytes */
+    return adler32_base(adler | (sum2 << 16), buf, len);
+}
+
+/* ========================================================================= */
+Z_TARGET("avx2") uLong ZLIB_INTERNAL adler32_avx2(adler, buf, len)
+    uLong adler;
+    const Bytef *buf;
+    z_size_t len;
+{
+    unsigned long sum2;
+    unsigned n;
+    __m256i b, vs1, vs2, vps;
+    __m256i zero = _mm256_setzero_si256();
+    __m256i ones = _mm256_set1_epi16(1);
+    __m256i tap = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                   24, 23, 22, 21, 20, 19, 18, 17,
+                                   16, 15, 14, 13, 12, 11, 10, 9,
+                                   8, 7, 6, 5, 4, 3, 2, 1);
+
+    /* initial Adler-32 value */
+    if (buf == Z_NULL)
+        return 1L;
+    if (len < VBLOCK)
+        return adler32_base(adler, buf, len);
+
+    /* split Adler-32 into component sums */
+    sum2 = (adler >> 16) & 0xffff;
+    adler &= 0xffff;
+
+    /* do runs of up to VPIECES pieces -- each requires one modulo */
+    while (len >= VBLOCK) {
+        n = len / VBLOCK < VPIECES ? (unsigned)(len / VBLOCK) : VPIECES;
+        len -= (z_size_t)n * VBLOCK;
+        vps = _mm256_setr_epi32((int)(adler * n), 0, 0, 0, 0, 0, 0, 0);
+        vs1 = zero;
+        vs2 = zero;
+        do {
+            b = _mm256_loadu_si256((const __m256i *)buf);
+            vps = _mm256_add_epi32(vps, vs1);
+            vs1 = _mm256_add_epi32(vs1, _mm256_sad_epu8(b, zero));
+            vs2 = _mm256_add_epi32(vs2,
+                       _mm256_madd_epi16(_mm256_maddubs_epi16(b, tap), ones));
+            buf += VBLOCK;
+        } while (--n);
+        vs2 = _mm256_add_epi32(vs2, _mm256_slli_epi32(vps, 5));
+        adler += hsum128(_mm_add_epi32(_mm256_castsi256_si128(vs1),
+                                       _mm256_extracti128_si256(vs1, 1)));
+        sum2 += hsum128(_mm_add_epi32(_mm256_castsi256_si128(vs2),
+                                      _mm256_extracti128_si256(vs2, 1)));
+        MOD(adler);
+        MOD(sum2);
+    }
+
+    /* do the remaining bytes */
+    return adler32_base(adler | (sum2 << 16), buf, len);
+}
+#endif /* Z_X86_SIMD */
+
+#ifdef Z_ARM_SIMD
+/* =========================================================================
+ * NEON has no byte multiply-add into 32 bits, so the bytes in each position
+ * of the piece are summed in 16-bit columns instead, which VPIECES pieces
+ * cannot overflow, and weighted once at the end of the run.
+ */
+uLong ZLIB_INTERNAL adler32_neon(adler, buf, len)
+    uLong adler;
+    const Bytef *buf;
+    z_size_t len;
+{
+    static const uint16_t tap[VBLOCK] = {
+        32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+        16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1
+    };
+    unsigned long sum2;
+    unsigned n;
+    uint8x16_t b1, b2;
+    uint16x8_t c0, c1, c2, c3, t;
+    uint32x4_t vs1, vs2, vps;
+
+    /* initial Adler-32 value */
+    if (buf == Z_NULL)
+        return 1L;
+    if (len < VBLOCK)
+        return adler32_base(adler, buf, len);
+
+    /* split Adler-32 into component sums */
+    sum2 = (adler >> 16) & 0xffff;
+    adler &= 0xffff;
+
+    /* do runs of up to VPIECES pieces -- each requires one modulo */
+    while (len >= VBLOCK) {
+        n = len / VBLOCK < VPIECES ? (unsigned)(len / VBLOCK) : VPIECES;
+        len -= (z_size_t)n * VBLOCK;
+        vps = vsetq_lane_u32((uint32_t)(adler * n), vdupq_n_u32(0), 0);
+        vs1 = vdupq_n_u32(0);
+        c0 = c1 = c2 = c3 = vdupq_n_u16(0);
+        do {
+            b1 = vld1q_u8(buf);
+            b2 = vld1q_u8(buf + 16);
+            vps = vaddq_u32(vps, vs1);
+            vs1 = vpadalq_u16(vs1, vpadalq_u8(vpaddlq_u8(b1), b2));
+            c0 = vaddw_u8(c0, vget_low_u8(b1));
+            c1 = vaddw_u8(c1, vget_high_u8(b1));
+            c2 = vaddw_u8(c2, vget_low_u8(b2));
+            c3 = vaddw_u8(c3, vget_high_u8(b2));
+            buf += VBLOCK;
+        } while (--n);
+        vs2 = vshlq_n_u32(vps, 5);
+        t = vld1q_u16(tap);
+        vs2 = vmlal_u16(vs2, vget_low_u16(c0), vget_low_u16(t));
+        vs2 = vmlal_u16(vs2, vget_high_u16(c0), vget_high_u16(t));
+        t = vld1q_u16(tap + 8);
+        vs2 = vmlal_u16(vs2, vget_low_u16(c1), vget_low_u16(t));
+        vs2 = vmlal_u16(vs2, vget_high_u16(c1), vget_high_u16(t));
+        t = vld1q_u16(tap + 16);
+        vs2 = vmlal_u16(vs2, vget_low_u16(c2), vget_low_u16(t));
+        vs2 = vmlal_u16(vs2, vget_high_u16(c2), vget_high_u16(t));
+        t = vld1q_u16(tap + 24);
+        vs2 = vmlal_u16(vs2, vget_low_u16(c3), vget_low_u16(t));
+        vs2 = vmlal_u16(vs2, vget_high_u16(c3), vget_high_u16(t));
+        adler += vaddvq_u32(vs1);
+        sum2 += vaddvq_u32(vs2);
+        MOD(adler);
+        MOD(sum2);
+    }
+
+    /* do the remaining bytes */
+    return adler32_base(adler | (sum2 << 16), buf, len);
+}
+#endif /* Z_ARM_SIMD */
+
+/* The adler32_z() version for this processor, chosen the first time through
+   by adler32_choose(). */
+local uLong (*adler32_kern) OF((uLong adler, const Bytef *buf, z_size_t len));
+local z_once_t adler32_chosen = Z_ONCE_INIT;
+
+local void adler32_choose OF((void));
+local void adler32_choose()
+{
+    adler32_kern = adler32_base;
+#ifdef Z_X86_SIMD
+    if (z_cpu_features() & Z_CPU_AVX2)
+        adler32_kern = adler32_avx2;
+    else if (z_cpu_features() & Z_CPU_SSSE3)
+        adler32_kern = adler32_ssse3;
+#endif
+#ifdef Z_ARM_SIMD
+    adler32_kern = adler32_neon;
+#endif
+}
+
+/* ========================================================================= */
+uLong ZEXPORT adler32_z(adler, buf, len)
+    uLong adler;
+    const Bytef *buf;
+    z_size_t len;
+{
+    z_once(&adler32_chosen, adler32_choose);
+    return adler32_kern(adler, buf, len);
+}
+
 /* ========================================================================= */
 uLong ZEXPORT adler32(adler, buf, len)
     uLong adler;
@@ -139,6 +384,28 @@ uLong ZEXPORT adler32(adler, buf, len)
     return adler32_z(adler, buf, len);
 }
 
+/* ========================================================================= */
+uLong ZEXPORT adler32_copy(adler, dst, src, len)
+    uLong adler;
+    Bytef *dst;
+    const Bytef *src;
+    z_size_t len;
+{
+    z_size_t n;
+
+    if (src == Z_NULL)
+        return adler32_z(adler, src, len);
+    while (len) {
+        n = len < Z_COPY_CHUNK ? len : Z_COPY_CHUNK;
+        adler = adler32_z(adler, src, n);
+        zmemcpy(dst, src, (uInt)n);
+        dst += n;
+        src += n;
+        len -= n;
+    }
+    return adler;
+}
+
 /* ========================================================================= */
 local uLong adler32_combine_(adler1, adler2, len2)
     uLong adler1;
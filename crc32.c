@@ -28,6 +28,9 @@
 #endif /* MAKECRCH */
 
 #include "zutil.h"      /* for Z_U4, Z_U8, z_crc_t, and FAR definitions */
+#ifdef Z_X86_SIMD
+#  include <immintrin.h>
+#endif
 
  /*
   A CRC of a message is computed on N braids of words in the message, where
@@ -99,15 +102,23 @@
 #endif
 
 /* Local functions. */
-local z_crc_t multmodp OF((z_crc_t a, z_crc_t b));
-local z_crc_t x2nmodp OF((z_off64_t n, unsigned k));
+local z_crc_t multmod OF((z_crc_t a, z_crc_t b, z_crc_t poly));
+local z_crc_t x2nmod OF((z_off64_t n, unsigned k, const z_crc_t FAR *x2n,
+                         z_crc_t poly));
 
 /* If available, use the ARM processor CRC32 instruction. */
 #if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32) && W == 8
 #  define ARMCRC32
 #endif
 
+/* The braid tables are made at run time for CRC-32C, and for CRC-32 if
+   DYNAMIC_CRC_TABLE is defined. Neither is needed if the ARM CRC32
+   instructions are used. */
 #if defined(W) && (!defined(ARMCRC32) || defined(DYNAMIC_CRC_TABLE))
+#  define MAKE_BRAID
+#endif
+
+#ifdef MAKE_BRAID
 /*
   Swap the bytes in a z_word_t to convert between little and big endian. Any
   self-respecting compiler will optimize this to a single machine byte-swap
@@ -137,8 +148,18 @@ local z_word_t byte_swap(word)
 }
 #endif
 
-/* CRC polynomial. */
+/* CRC polynomials. */
 #define POLY 0xedb88320         /* p(x) reflected, with x^32 implied */
+#define POLYC 0x82f63b78        /* Castagnoli's p(x) for CRC-32C, likewise */
+
+/* Multiplication and powers of x modulo POLY, for CRC-32 */
+#define multmodp(a, b) multmod(a, b, POLY)
+#define x2nmodp(n, k) x2nmod(n, k, x2n_table, POLY)
+
+#ifdef MAKE_BRAID
+local void braid OF((z_crc_t [][256], z_word_t [][256], int, int,
+                     const z_crc_t FAR *, z_crc_t));
+#endif
 
 #ifdef DYNAMIC_CRC_TABLE
 
@@ -149,7 +170,6 @@ local void make_crc_table OF((void));
    local z_word_t FAR crc_big_table[256];
    local z_crc_t FAR crc_braid_table[W][256];
    local z_word_t FAR crc_braid_big_table[W][256];
-   local void braid OF((z_crc_t [][256], z_word_t [][256], int, int));
 #endif
 #ifdef MAKECRCH
    local void write_table OF((FILE *, const z_crc_t FAR *, int));
@@ -158,92 +178,24 @@ local void make_crc_table OF((void));
 #endif /* MAKECRCH */
 
 /*
-  Define a once() function depending on the availability of atomics. If this is
-  compiled with DYNAMIC_CRC_TABLE defined, and if CRCs will be computed in
-  multiple threads, and if atomics are not available, then get_crc_table() must
-  be called to initialize the tables and must return before any threads are
-  allowed to compute or combine CRCs.
+  The tables are made with z_once(). If this is compiled with DYNAMIC_CRC_TABLE
+  defined, and if CRCs will be computed in multiple threads, and if atomics are
+  not available, then get_crc_table() must be called to initialize the tables
+  and must return before any threads are allowed to compute or combine CRCs.
  */
-
-/* Definition of once functionality. */
-typedef struct once_s once_t;
-local void once OF((once_t *, void (*)(void)));
-
-/* Check for the availability of atomics. */
-#if defined(__STDC__) && __STDC_VERSION__ >= 201112L && \
-    !defined(__STDC_NO_ATOMICS__)
-
-#include <stdatomic.h>
-
-/* Structure for once(), which must be initialized with ONCE_INIT. */
-struct once_s {
-    atomic_flag begun;
-    atomic_int done;
-};
-#define ONCE_INIT {ATOMIC_FLAG_INIT, 0}
-
-/*
-  Run the provided init() function exactly once, even if multiple threads
-  invoke once() at the same time. The state must be a once_t initialized with
-  ONCE_INIT.
- */
-local void once(state, init)
-    once_t *state;
-    void (*init)(void);
-{
-    if (!atomic_load(&state->done)) {
-        if (atomic_flag_test_and_set(&state->begun))
-            while (!atomic_load(&state->done))
-                ;
-        else {
-            init();
-            atomic_store(&state->done, 1);
-        }
-    }
-}
-
-#else   /* no atomics */
-
-/* Structure for once(), which must be initialized with ONCE_INIT. */
-struct once_s {
-    volatile int begun;
-    volatile int done;
-};
-#define ONCE_INIT {0, 0}
-
-/* Test and set. Alas, not atomic, but tries to minimize the period of
-   vulnerability. */
-local int test_and_set OF((int volatile *));
-local int test_and_set(flag)
-    int volatile *flag;
-{
-    int was;
-
-    was = *flag;
-    *flag = 1;
-    return was;
-}
-
-/* Run the provided init() function once. This is not thread-safe. */
-local void once(state, init)
-    once_t *state;
-    void (*init)(void);
-{
-    if (!state->done) {
-        if (test_and_set(&state->begun))
-            while (!state->done)
-                ;
-        else {
-            init();
-            state->done = 1;
-        }
-    }
-}
-
+#ifdef MAKECRCH
+/* This is compiled alone, without zutil.c, to run in one thread. */
+#  define z_once(state, init) \
+    do { \
+        if (!(state)->done) { \
+            (state)->done = 1; \
+            init(); \
+        } \
+    } while (0)
 #endif
 
-/* State for once(). */
-local once_t made = ONCE_INIT;
+/* State for z_once(). */
+local z_once_t made = Z_ONCE_INIT;
 
 /*
   Generate tables for a byte-wise 32-bit CRC calculation on the polynomial:
@@ -294,7 +246,7 @@ local void make_crc_table()
 
 #ifdef W
     /* initialize the braiding tables -- needs x2n_table[] */
-    braid(crc_braid_table, crc_braid_big_table, N, W);
+    braid(crc_braid_table, crc_braid_big_table, N, W, x2n_table, POLY);
 #endif
 
 #ifdef MAKECRCH
@@ -360,7 +312,7 @@ local void make_crc_table()
             "#if N == %d\n", n);
 
             /* compute braid tables for this N and 64-bit word_t */
-            braid(ltl, big, n, 8);
+            braid(ltl, big, n, 8, x2n_table, POLY);
 
             /* write out braid tables for 64-bit z_word_t to crc32.h */
             fprintf(out,
@@ -386,7 +338,7 @@ local void make_crc_table()
             "};\n");
 
             /* compute braid tables for this N and 32-bit word_t */
-            braid(ltl, big, n, 4);
+            braid(ltl, big, n, 4, x2n_table, POLY);
 
             /* write out braid tables for 32-bit z_word_t to crc32.h */
             fprintf(out,
@@ -497,38 +449,85 @@ int main()
 
 #endif /* MAKECRCH */
 
-#ifdef W
+#else /* !DYNAMIC_CRC_TABLE */
+/* ========================================================================
+ * Tables for byte-wise and braided CRC-32 calculations, and a table of powers
+ * of x for combining CRC-32s, all made by make_crc_table().
+ */
+#include "crc32.h"
+#endif /* DYNAMIC_CRC_TABLE */
+
+#ifdef MAKE_BRAID
 /*
   Generate the little and big-endian braid tables for the given n and z_word_t
-  size w. Each array must have room for w blocks of 256 elements.
+  size w, for the CRC with polynomial poly and powers of x x2n[]. Each array
+  must have room for w blocks of 256 elements.
  */
-local void braid(ltl, big, n, w)
+local void braid(ltl, big, n, w, x2n, poly)
     z_crc_t ltl[][256];
     z_word_t big[][256];
     int n;
     int w;
+    const z_crc_t FAR *x2n;
+    z_crc_t poly;
 {
     int k;
     z_crc_t i, p, q;
     for (k = 0; k < w; k++) {
-        p = x2nmodp((n * w + 3 - k) << 3, 0);
+        p = x2nmod((n * w + 3 - k) << 3, 0, x2n, poly);
         ltl[k][0] = 0;
         big[w - 1 - k][0] = 0;
         for (i = 1; i < 256; i++) {
-            ltl[k][i] = q = multmodp(i << 24, p);
+            ltl[k][i] = q = multmod(i << 24, p, poly);
             big[w - 1 - k][i] = byte_swap(q);
         }
     }
 }
 #endif
 
-#else /* !DYNAMIC_CRC_TABLE */
 /* ========================================================================
- * Tables for byte-wise and braided CRC-32 calculations, and a table of powers
- * of x for combining CRC-32s, all made by make_crc_table().
+ * Tables for CRC-32C, always made at run time by make_crc32c_table(), with
+ * the same generators as for CRC-32. The ARM CRC32 instructions include
+ * CRC-32C, in which case no braid tables are needed.
  */
-#include "crc32.h"
-#endif /* DYNAMIC_CRC_TABLE */
+local z_crc_t FAR crc32c_table[256];
+local z_crc_t FAR x2nc_table[32];
+#if defined(W) && !defined(ARMCRC32)
+   local z_word_t FAR crc32c_big_table[256];
+   local z_crc_t FAR crc32c_braid_table[W][256];
+   local z_word_t FAR crc32c_braid_big_table[W][256];
+#endif
+local z_once_t madec = Z_ONCE_INIT;
+
+local void make_crc32c_table OF((void));
+local void make_crc32c_table()
+{
+    unsigned i, j;
+    z_crc_t p;
+
+    /* initialize the CRC of bytes tables */
+    for (i = 0; i < 256; i++) {
+        p = i;
+        for (j = 0; j < 8; j++)
+            p = p & 1 ? (p >> 1) ^ POLYC : p >> 1;
+        crc32c_table[i] = p;
+#if defined(W) && !defined(ARMCRC32)
+        crc32c_big_table[i] = byte_swap(p);
+#endif
+    }
+
+    /* initialize the x^2^n mod p(x) table */
+    p = (z_crc_t)1 << 30;         /* x^1 */
+    x2nc_table[0] = p;
+    for (i = 1; i < 32; i++)
+        x2nc_table[i] = p = multmod(p, p, POLYC);
+
+#if defined(W) && !defined(ARMCRC32)
+    /* initialize the braiding tables */
+    braid(crc32c_braid_table, crc32c_braid_big_table, N, W, x2nc_table,
+          POLYC);
+#endif
+}
 
 /* ========================================================================
  * Routines used for CRC calculation. Some are also required for the table
@@ -536,12 +535,13 @@ local void braid(ltl, big, n, w)
  */
 
 /*
-  Return a(x) multiplied by b(x) modulo p(x), where p(x) is the CRC polynomial,
-  reflected. For speed, this requires that a not be zero.
+  Return a(x) multiplied by b(x) modulo p(x), where p(x) is the CRC polynomial
+  poly, reflected. For speed, this requires that a not be zero.
  */
-local z_crc_t multmodp(a, b)
+local z_crc_t multmod(a, b, poly)
     z_crc_t a;
     z_crc_t b;
+    z_crc_t poly;
 {
     z_crc_t m, p;
 
@@ -554,25 +554,27 @@ local z_crc_t multmodp(a, b)
                 break;
         }
         m >>= 1;
-        b = b & 1 ? (b >> 1) ^ POLY : b >> 1;
+        b = b & 1 ? (b >> 1) ^ poly : b >> 1;
     }
     return p;
 }
 
 /*
-  Return x^(n * 2^k) modulo p(x). Requires that x2n_table[] has been
-  initialized.
+  Return x^(n * 2^k) modulo p(x), where p(x) is the CRC polynomial poly, and
+  x2n[] is its table of x^2^n modulo p(x), which must have been initialized.
  */
-local z_crc_t x2nmodp(n, k)
+local z_crc_t x2nmod(n, k, x2n, poly)
     z_off64_t n;
     unsigned k;
+    const z_crc_t FAR *x2n;
+    z_crc_t poly;
 {
     z_crc_t p;
 
     p = (z_crc_t)1 << 31;           /* x^0 == 1 */
     while (n) {
         if (n & 1)
-            p = multmodp(x2n_table[k & 31], p);
+            p = multmod(x2n[k & 31], p, poly);
         n >>= 1;
         k++;
     }
@@ -586,7 +588,7 @@ local z_crc_t x2nmodp(n, k)
 const z_crc_t FAR * ZEXPORT get_crc_table()
 {
 #ifdef DYNAMIC_CRC_TABLE
-    once(&made, make_crc_table);
+    z_once(&made, make_crc_table);
 #endif /* DYNAMIC_CRC_TABLE */
     return (const z_crc_t FAR *)crc_table;
 }
@@ -610,7 +612,7 @@ const z_crc_t FAR * ZEXPORT get_crc_table()
 #define Z_BATCH_ZEROS 0xa10d3d0c    /* computed from Z_BATCH = 3990 */
 #define Z_BATCH_MIN 800             /* fewest words in a final batch */
 
-unsigned long ZEXPORT crc32_z(crc, buf, len)
+unsigned long ZLIB_INTERNAL crc32_base(crc, buf, len)
     unsigned long crc;
     const unsigned char FAR *buf;
     z_size_t len;
@@ -626,7 +628,7 @@ unsigned long ZEXPORT crc32_z(crc, buf, len)
     if (buf == Z_NULL) return 0;
 
 #ifdef DYNAMIC_CRC_TABLE
-    once(&made, make_crc_table);
+    z_once(&made, make_crc_table);
 #endif /* DYNAMIC_CRC_TABLE */
 
     /* Pre-condition the CRC */
@@ -707,46 +709,60 @@ unsigned long ZEXPORT crc32_z(crc, buf, len)
 
 #else
 
+/*
+  The tables for a byte-wise and braided calculation of one CRC. The braid
+  tables are W tables of 256 entries each, one after the other.
+ */
+typedef struct {
+    const z_crc_t FAR *ltl;         /* CRC of each byte value */
+#ifdef W
+    const z_word_t FAR *big;        /* the same, byte-swapped */
+    const z_crc_t FAR *braid;       /* braid tables, little endian */
+    const z_word_t FAR *braid_big;  /* braid tables, big endian */
+#endif
+} crc_tables;
+
 #ifdef W
 
 /*
   Return the CRC of the W bytes in the word_t data, taking the
   least-significant byte of the word as the first byte of data, without any pre
-  or post conditioning. This is used to combine the CRCs of each braid.
+  or post conditioning, using the byte table ltl[]. This is used to combine the
+  CRCs of each braid.
  */
-local z_crc_t crc_word(data)
+local z_crc_t crc_word(data, ltl)
     z_word_t data;
+    const z_crc_t FAR *ltl;
 {
     int k;
     for (k = 0; k < W; k++)
-        data = (data >> 8) ^ crc_table[data & 0xff];
+        data = (data >> 8) ^ ltl[data & 0xff];
     return (z_crc_t)data;
 }
 
-local z_word_t crc_word_big(data)
+local z_word_t crc_word_big(data, big)
     z_word_t data;
+    const z_word_t FAR *big;
 {
     int k;
     for (k = 0; k < W; k++)
         data = (data << 8) ^
-            crc_big_table[(data >> ((W - 1) << 3)) & 0xff];
+            big[(data >> ((W - 1) << 3)) & 0xff];
     return data;
 }
 
 #endif
 
-/* ========================================================================= */
-unsigned long ZEXPORT crc32_z(crc, buf, len)
+/* =========================================================================
+ * The braided CRC with the tables tab, for a buf that is not Z_NULL.
+ */
+local unsigned long crc_braid(crc, buf, len, tab)
     unsigned long crc;
     const unsigned char FAR *buf;
     z_size_t len;
+    const crc_tables *tab;
 {
-    /* Return initial CRC, if requested. */
-    if (buf == Z_NULL) return 0;
-
-#ifdef DYNAMIC_CRC_TABLE
-    once(&made, make_crc_table);
-#endif /* DYNAMIC_CRC_TABLE */
+    const z_crc_t FAR *ltl = tab->ltl;
 
     /* Pre-condition the CRC */
     crc ^= 0xffffffff;
@@ -763,7 +779,7 @@ unsigned long ZEXPORT crc32_z(crc, buf, len)
         /* Compute the CRC up to a z_word_t boundary. */
         while (len && ((z_size_t)buf & (W - 1)) != 0) {
             len--;
-            crc = (crc >> 8) ^ crc_table[(crc ^ *buf++) & 0xff];
+            crc = (crc >> 8) ^ ltl[(crc ^ *buf++) & 0xff];
         }
 
         /* Compute the CRC on as many N z_word_t blocks as are available. */
@@ -781,6 +797,7 @@ unsigned long ZEXPORT crc32_z(crc, buf, len)
 
             z_crc_t crc0;
             z_word_t word0;
+            const z_crc_t FAR *brd = tab->braid;
 #if N > 1
             z_crc_t crc1;
             z_word_t word1;
@@ -846,34 +863,34 @@ unsigned long ZEXPORT crc32_z(crc, buf, len)
 
                 /* Compute and update the CRC for each word. The loop should
                    get unrolled. */
-                crc0 = crc_braid_table[0][word0 & 0xff];
+                crc0 = brd[word0 & 0xff];
 #if N > 1
-                crc1 = crc_braid_table[0][word1 & 0xff];
+                crc1 = brd[word1 & 0xff];
 #if N > 2
-                crc2 = crc_braid_table[0][word2 & 0xff];
+                crc2 = brd[word2 & 0xff];
 #if N > 3
-                crc3 = crc_braid_table[0][word3 & 0xff];
+                crc3 = brd[word3 & 0xff];
 #if N > 4
-                crc4 = crc_braid_table[0][word4 & 0xff];
+                crc4 = brd[word4 & 0xff];
 #if N > 5
-                crc5 = crc_braid_table[0][word5 & 0xff];
+                crc5 = brd[word5 & 0xff];
 #endif
 #endif
 #endif
 #endif
 #endif
                 for (k = 1; k < W; k++) {
-                    crc0 ^= crc_braid_table[k][(word0 >> (k << 3)) & 0xff];
+                    crc0 ^= brd[(k << 8) + ((word0 >> (k << 3)) & 0xff)];
 #if N > 1
-                    crc1 ^= crc_braid_table[k][(word1 >> (k << 3)) & 0xff];
+                    crc1 ^= brd[(k << 8) + ((word1 >> (k << 3)) & 0xff)];
 #if N > 2
-                    crc2 ^= crc_braid_table[k][(word2 >> (k << 3)) & 0xff];
+                    crc2 ^= brd[(k << 8) + ((word2 >> (k << 3)) & 0xff)];
 #if N > 3
-                    crc3 ^= crc_braid_table[k][(word3 >> (k << 3)) & 0xff];
+                    crc3 ^= brd[(k << 8) + ((word3 >> (k << 3)) & 0xff)];
 #if N > 4
-                    crc4 ^= crc_braid_table[k][(word4 >> (k << 3)) & 0xff];
+                    crc4 ^= brd[(k << 8) + ((word4 >> (k << 3)) & 0xff)];
 #if N > 5
-                    crc5 ^= crc_braid_table[k][(word5 >> (k << 3)) & 0xff];
+                    crc5 ^= brd[(k << 8) + ((word5 >> (k << 3)) & 0xff)];
 #endif
 #endif
 #endif
@@ -886,17 +903,17 @@ unsigned long ZEXPORT crc32_z(crc, buf, len)
               Process the last block, combining the CRCs of the N braids at the
               same time.
              */
-            crc = crc_word(crc0 ^ words[0]);
+            crc = crc_word(crc0 ^ words[0], ltl);
 #if N > 1
-            crc = crc_word(crc1 ^ words[1] ^ crc);
+            crc = crc_word(crc1 ^ words[1] ^ crc, ltl);
 #if N > 2
-            crc = crc_word(crc2 ^ words[2] ^ crc);
+            crc = crc_word(crc2 ^ words[2] ^ crc, ltl);
 #if N > 3
-            crc = crc_word(crc3 ^ words[3] ^ crc);
+            crc = crc_word(crc3 ^ words[3] ^ crc, ltl);
 #if N > 4
-            crc = crc_word(crc4 ^ words[4] ^ crc);
+            crc = crc_word(crc4 ^ words[4] ^ crc, ltl);
 #if N > 5
-            crc = crc_word(crc5 ^ words[5] ^ crc);
+            crc = crc_word(crc5 ^ words[5] ^ crc, ltl);
 #endif
 #endif
 #endif
@@ -908,6 +925,7 @@ unsigned long ZEXPORT crc32_z(crc, buf, len)
             /* Big endian. */
 
             z_word_t crc0, word0, comb;
+            const z_word_t FAR *brd = tab->braid_big;
 #if N > 1
             z_word_t crc1, word1;
 #if N > 2
@@ -968,34 +986,34 @@ unsigned long ZEXPORT crc32_z(crc, buf, len)
 
                 /* Compute and update the CRC for each word. The loop should
                    get unrolled. */
-                crc0 = crc_braid_big_table[0][word0 & 0xff];
+                crc0 = brd[word0 & 0xff];
 #if N > 1
-                crc1 = crc_braid_big_table[0][word1 & 0xff];
+                crc1 = brd[word1 & 0xff];
 #if N > 2
-                crc2 = crc_braid_big_table[0][word2 & 0xff];
+                crc2 = brd[word2 & 0xff];
 #if N > 3
-                crc3 = crc_braid_big_table[0][word3 & 0xff];
+                crc3 = brd[word3 & 0xff];
 #if N > 4
-                crc4 = crc_braid_big_table[0][word4 & 0xff];
+                crc4 = brd[word4 & 0xff];
 #if N > 5
-                crc5 = crc_braid_big_table[0][word5 & 0xff];
+                crc5 = brd[word5 & 0xff];
 #endif
 #endif
 #endif
 #endif
 #endif
                 for (k = 1; k < W; k++) {
-                    crc0 ^= crc_braid_big_table[k][(word0 >> (k << 3)) & 0xff];
+                    crc0 ^= brd[(k << 8) + ((word0 >> (k << 3)) & 0xff)];
 #if N > 1
-                    crc1 ^= crc_braid_big_table[k][(word1 >> (k << 3)) & 0xff];
+                    crc1 ^= brd[(k << 8) + ((word1 >> (k << 3)) & 0xff)];
 #if N > 2
-                    crc2 ^= crc_braid_big_table[k][(word2 >> (k << 3)) & 0xff];
+                    crc2 ^= brd[(k << 8) + ((word2 >> (k << 3)) & 0xff)];
 #if N > 3
-                    crc3 ^= crc_braid_big_table[k][(word3 >> (k << 3)) & 0xff];
+                    crc3 ^= brd[(k << 8) + ((word3 >> (k << 3)) & 0xff)];
 #if N > 4
-                    crc4 ^= crc_braid_big_table[k][(word4 >> (k << 3)) & 0xff];
+                    crc4 ^= brd[(k << 8) + ((word4 >> (k << 3)) & 0xff)];
 #if N > 5
-                    crc5 ^= crc_braid_big_table[k][(word5 >> (k << 3)) & 0xff];
+                    crc5 ^= brd[(k << 8) + ((word5 >> (k << 3)) & 0xff)];
 #endif
 #endif
 #endif
@@ -1008,17 +1026,17 @@ unsigned long ZEXPORT crc32_z(crc, buf, len)
               Process the last block, combining the CRCs of the N braids at the
               same time.
              */
-            comb = crc_word_big(crc0 ^ words[0]);
+            comb = crc_word_big(crc0 ^ words[0], tab->big);
 #if N > 1
-            comb = crc_word_big(crc1 ^ words[1] ^ comb);
+            comb = crc_word_big(crc1 ^ words[1] ^ comb, tab->big);
 #if N > 2
-            comb = crc_word_big(crc2 ^ words[2] ^ comb);
+            comb = crc_word_big(crc2 ^ words[2] ^ comb, tab->big);
 #if N > 3
-            comb = crc_word_big(crc3 ^ words[3] ^ comb);
+            comb = crc_word_big(crc3 ^ words[3] ^ comb, tab->big);
 #if N > 4
-            comb = crc_word_big(crc4 ^ words[4] ^ comb);
+            comb = crc_word_big(crc4 ^ words[4] ^ comb, tab->big);
 #if N > 5
-            comb = crc_word_big(crc5 ^ words[5] ^ comb);
+            comb = crc_word_big(crc5 ^ words[5] ^ comb, tab->big);
 #endif
 #endif
 #endif
@@ -1039,25 +1057,406 @@ unsigned long ZEXPORT crc32_z(crc, buf, len)
     /* Complete the computation of the CRC on any remaining bytes. */
     while (len >= 8) {
         len -= 8;
-        crc = (crc >> 8) ^ crc_table[(crc ^ *buf++) & 0xff];
-        crc = (crc >> 8) ^ crc_table[(crc ^ *buf++) & 0xff];
-        crc = (crc >> 8) ^ crc_table[(crc ^ *buf++) & 0xff];
-        crc = (crc >> 8) ^ crc_table[(crc ^ *buf++) & 0xff];
-        crc = (crc >> 8) ^ crc_table[(crc ^ *buf++) & 0xff];
-        crc = (crc >> 8) ^ crc_table[(crc ^ *buf++) & 0xff];
-        crc = (crc >> 8) ^ crc_table[(crc ^ *buf++) & 0xff];
-        crc = (crc >> 8) ^ crc_table[(crc ^ *buf++) & 0xff];
+        crc = (crc >> 8) ^ ltl[(crc ^ *buf++) & 0xff];
+        crc = (crc >> 8) ^ ltl[(crc ^ *buf++) & 0xff];
+        crc = (crc >> 8) ^ ltl[(crc ^ *buf++) & 0xff];
+        crc = (crc >> 8) ^ ltl[(crc ^ *buf++) & 0xff];
+        crc = (crc >> 8) ^ ltl[(crc ^ *buf++) & 0xff];
+        crc = (crc >> 8) ^ ltl[(crc ^ *buf++) & 0xff];
+        crc = (crc >> 8) ^ ltl[(crc ^ *buf++) & 0xff];
+        crc = (crc >> 8) ^ ltl[(crc ^ *buf++) & 0xff];
     }
     while (len) {
         len--;
-        crc = (crc >> 8) ^ crc_table[(crc ^ *buf++) & 0xff];
+        crc = (crc >> 8) ^ ltl[(crc ^ *buf++) & 0xff];
     }
 
     /* Return the CRC, post-conditioned. */
     return crc ^ 0xffffffff;
 }
 
+/* The tables for CRC-32 */
+local const crc_tables crc32_tables = {
+    crc_table
+#ifdef W
+    , crc_big_table, crc_braid_table[0], crc_braid_big_table[0]
+#endif
+};
+
+/* =========================================================================
+ * The braided CRC, used when there is no faster version for this processor,
+ * and by the faster versions for what they don't handle.
+ */
+unsigned long ZLIB_INTERNAL crc32_base(crc, buf, len)
+    unsigned long crc;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+    /* Return initial CRC, if requested. */
+    if (buf == Z_NULL) return 0;
+
+#ifdef DYNAMIC_CRC_TABLE
+    z_once(&made, make_crc_table);
+#endif /* DYNAMIC_CRC_TABLE */
+
+    return crc_braid(crc, buf, len, &crc32_tables);
+}
+
+/* The tables for CRC-32C */
+local const crc_tables crc32c_tables = {
+    crc32c_table
+#ifdef W
+    , crc32c_big_table, crc32c_braid_table[0], crc32c_braid_big_table[0]
+#endif
+};
+
+/* =========================================================================
+ * The braided CRC-32C, used when the processor has no crc32 instruction.
+ */
+unsigned long ZLIB_INTERNAL crc32c_base(crc, buf, len)
+    unsigned long crc;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+    /* Return initial CRC, if requested. */
+    if (buf == Z_NULL) return 0;
+
+    z_once(&madec, make_crc32c_table);
+    return crc_braid(crc, buf, len, &crc32c_tables);
+}
+
+#endif
+
+#ifdef Z_X86_SIMD
+/* =========================================================================
+ * Compute the CRC by folding with carry-less multiplication, as described in
+ * "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+ * by Gopal, Ozturk, et al. (Intel, 2009). A 128-bit piece of the message is
+ * moved n bits further along by multiplying its two 64-bit halves by x^(n+32)
+ * and x^(n-32) modulo the CRC polynomial, and the products are exclusive-ored
+ * into the piece n bits later. Four such streams of pieces are folded at once
+ * to keep the multipliers busy, then folded into one 128-bit value, which is
+ * reduced to the 32-bit CRC. The constants are x^k modulo the polynomial, bit
+ * reflected and shifted up one bit, for the k noted. The result is the same
+ * as for the braided calculation, for any length and alignment.
+ */
+
+/* Constants to fold 128 bits ahead by 2048, 512, or 128 bits */
+#define FOLD_2048 _mm_set_epi64x(0x1322d1430, 0x11542778a) /* k = 2016, 2080 */
+#define FOLD_512  _mm_set_epi64x(0x1c6e41596, 0x154442bd4) /* k = 480, 544 */
+#define FOLD_128  _mm_set_epi64x(0x0ccaa009e, 0x1751997d0) /* k = 96, 160 */
+
+/* Move the 128 bits in x ahead by the distance for the constants in k, and
+   exclusive-or them with y. */
+local Z_TARGET("pclmul") __m128i fold128 OF((__m128i x, __m128i k, __m128i y));
+local Z_TARGET("pclmul") __m128i fold128(x, k, y)
+    __m128i x;
+    __m128i k;
+    __m128i y;
+{
+    return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00),
+                                       _mm_clmulepi64_si128(x, k, 0x11)), y);
+}
+
+/* Fold the len bytes at buf, a multiple of 16, into x, and return the CRC of
+   the result without post-conditioning. */
+local Z_TARGET("sse4.1,pclmul") unsigned crc_reduce OF((__m128i x,
+                                const unsigned char FAR *buf, z_size_t len));
+local Z_TARGET("sse4.1,pclmul") unsigned crc_reduce(x, buf, len)
+    __m128i x;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+    __m128i y;
+    __m128i low = _mm_setr_epi32(-1, 0, -1, 0);
+    __m128i k64 = _mm_set_epi64x(0, 0x163cd6124);               /* k = 64 */
+    __m128i poly = _mm_set_epi64x(0x1f7011641, 0x1db710641); /* mu, P */
+
+    for (; len; len -= 16, buf += 16)
+        x = fold128(x, FOLD_128, _mm_loadu_si128((const __m128i *)buf));
+
+    /* Fold 128 bits down to 64, then to 32 plus 32 bits of zeros */
+    y = _mm_clmulepi64_si128(x, FOLD_128, 0x10);
+    x = _mm_xor_si128(_mm_srli_si128(x, 8), y);
+    y = _mm_srli_si128(x, 4);
+    x = _mm_clmulepi64_si128(_mm_and_si128(x, low), k64, 0x00);
+    x = _mm_xor_si128(x, y);
+
+    /* Barrett reduction to 32 bits */
+    y = _mm_clmulepi64_si128(_mm_and_si128(x, low), poly, 0x10);
+    y = _mm_clmulepi64_si128(_mm_and_si128(y, low), poly, 0x00);
+    x = _mm_xor_si128(x, y);
+    return (unsigned)_mm_extract_epi32(x, 1);
+}
+
+/* ========================================================================= */
+Z_TARGET("sse4.1,pclmul") unsigned long ZLIB_INTERNAL crc32_pclmul(crc, buf,
+                                                                    len)
+    unsigned long crc;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+    __m128i x0, x1, x2, x3;
+    z_size_t n;
+
+    /* Return initial CRC, if requested. */
+    if (buf == Z_NULL) return 0;
+
+    /* Leave short messages and the last len % 16 bytes to the braids */
+    if (len < 64)
+        return crc32_base(crc, buf, len);
+    n = len & ~(z_size_t)15;
+
+    /* Start the four streams, with the pre-conditioned CRC */
+    x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)buf),
+                       _mm_cvtsi32_si128((int)(crc ^ 0xffffffff)));
+    x1 = _mm_loadu_si128((const __m128i *)(buf + 16));
+    x2 = _mm_loadu_si128((const __m128i *)(buf + 32));
+    x3 = _mm_loadu_si128((const __m128i *)(buf + 48));
+    buf += 64;
+    n -= 64;
+
+    /* Fold each stream 512 bits ahead */
+    for (; n >= 64; n -= 64, buf += 64) {
+        x0 = fold128(x0, FOLD_512, _mm_loadu_si128((const __m128i *)buf));
+        x1 = fold128(x1, FOLD_512,
+                     _mm_loadu_si128((const __m128i *)(buf + 16)));
+        x2 = fold128(x2, FOLD_512,
+                     _mm_loadu_si128((const __m128i *)(buf + 32)));
+        x3 = fold128(x3, FOLD_512,
+                     _mm_loadu_si128((const __m128i *)(buf + 48)));
+    }
+
+    /* Fold the streams into one, then fold in the remaining pieces */
+    x0 = fold128(x0, FOLD_128, x1);
+    x0 = fold128(x0, FOLD_128, x2);
+    x0 = fold128(x0, FOLD_128, x3);
+    crc = crc_reduce(x0, buf, n) ^ 0xffffffff;
+    return crc32_base(crc, buf + n, len & 15);
+}
+
+#ifdef Z_X86_AVX512
+/* Same as fold128(), for four 128-bit lanes at once. */
+local Z_TARGET("avx512f,vpclmulqdq") __m512i fold512 OF((__m512i x, __m512i k,
+                                                         __m512i y));
+local Z_TARGET("avx512f,vpclmulqdq") __m512i fold512(x, k, y)
+    __m512i x;
+    __m512i k;
+    __m512i y;
+{
+    return _mm512_ternarylogic_epi64(_mm512_clmulepi64_epi128(x, k, 0x00),
+                                     _mm512_clmulepi64_epi128(x, k, 0x11),
+                                     y, 0x96);
+}
+
+/* =========================================================================
+ * Same as crc32_pclmul(), but with four streams of 512 bits, each folded
+ * 2048 bits ahead, using VPCLMULQDQ on AVX-512 registers. Messages shorter
+ * than CRC_WIDE bytes are left to crc32_pclmul().
+ */
+#define CRC_WIDE 512
+
+Z_TARGET("avx512f,vpclmulqdq,sse4.1,pclmul")
+unsigned long ZLIB_INTERNAL crc32_vpclmul(crc, buf, len)
+    unsigned long crc;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+    __m512i z0, z1, z2, z3, k;
+    __m128i x;
+    z_size_t n;
+
+    /* Return initial CRC, if requested. */
+    if (buf == Z_NULL) return 0;
+
+    if (len < CRC_WIDE)
+        return crc32_pclmul(crc, buf, len);
+    n = len & ~(z_size_t)15;
+
+    /* Start the four streams, with the pre-conditioned CRC */
+    z0 = _mm512_xor_si512(_mm512_loadu_si512((const void *)buf),
+                          _mm512_inserti32x4(_mm512_setzero_si512(),
+                              _mm_cvtsi32_si128((int)(crc ^ 0xffffffff)), 0));
+    z1 = _mm512_loadu_si512((const void *)(buf + 64));
+    z2 = _mm512_loadu_si512((const void *)(buf + 128));
+    z3 = _mm512_loadu_si512((const void *)(buf + 192));
+    buf += 256;
+    n -= 256;
+
+    /* Fold each stream 2048 bits ahead */
+    k = _mm512_broadcast_i32x4(FOLD_2048);
+    for (; n >= 256; n -= 256, buf += 256) {
+        z0 = fold512(z0, k, _mm512_loadu_si512((const void *)buf));
+        z1 = fold512(z1, k, _mm512_loadu_si512((const void *)(buf + 64)));
+        z2 = fold512(z2, k, _mm512_loadu_si512((const void *)(buf + 128)));
+        z3 = fold512(z3, k, _mm512_loadu_si512((const void *)(buf + 192)));
+    }
+
+    /* Fold the streams into one, and fold in the remaining 512-bit pieces */
+    k = _mm512_broadcast_i32x4(FOLD_512);
+    z0 = fold512(z0, k, z1);
+    z0 = fold512(z0, k, z2);
+    z0 = fold512(z0, k, z3);
+    for (; n >= 64; n -= 64, buf += 64)
+        z0 = fold512(z0, k, _mm512_loadu_si512((const void *)buf));
+
+    /* Fold the four lanes into one, then fold in the remaining pieces */
+    x = _mm512_extracti32x4_epi32(z0, 0);
+    x = fold128(x, FOLD_128, _mm512_extracti32x4_epi32(z0, 1));
+    x = fold128(x, FOLD_128, _mm512_extracti32x4_epi32(z0, 2));
+    x = fold128(x, FOLD_128, _mm512_extracti32x4_epi32(z0, 3));
+    crc = crc_reduce(x, buf, n) ^ 0xffffffff;
+    return crc32_base(crc, buf + n, len & 15);
+}
+#endif /* Z_X86_AVX512 */
+#endif /* Z_X86_SIMD */
+
+#if defined(ARMCRC32) || defined(Z_X86_SIMD)
+/* =========================================================================
+ * CRC-32C using the crc32 instructions of SSE4.2 or the crc32c instructions
+ * of ARMv8. On x86 this is only called after checking for SSE4.2 at run time.
+ * As for the ARM CRC-32 above, three CRCs are interleaved to keep the
+ * instruction busy every cycle in spite of its latency of three cycles, and
+ * are then combined. Each batch is a power of two words, so that combining
+ * needs just one multiplication by an entry of x2nc_table[] per CRC. The
+ * batches are shorter on x86, where the combination is relatively cheaper.
+ */
+#ifdef ARMCRC32
+#  define CRCC_TARGET
+#  define crc32c_hw crc32c_base
+#  define crcc_word z_word_t
+#  define CRCC_BYTE(crc, val) \
+    __asm__ volatile("crc32cb %w0, %w0, %w1" : "+r"(crc) : "r"(val))
+#  define CRCC_WORD(crc, val) \
+    __asm__ volatile("crc32cx %w0, %w0, %x1" : "+r"(crc) : "r"(val))
+#  define CRCC_MIN_BITS 9           /* log2 of fewest words in a batch */
+#  define CRCC_MAX_BITS 12          /* log2 of most words in a batch */
+#else
+#  define CRCC_TARGET Z_TARGET("sse4.2")
+#  define crc32c_hw crc32c_sse42
+#  define crcc_word Z_U8
+#  define CRCC_BYTE(crc, val) crc = _mm_crc32_u8((unsigned)(crc), val)
+#  define CRCC_WORD(crc, val) crc = _mm_crc32_u64(crc, val)
+#  define CRCC_MIN_BITS 7
+#  define CRCC_MAX_BITS 10
+#endif
+
+CRCC_TARGET unsigned long ZLIB_INTERNAL crc32c_hw(crc, buf, len)
+    unsigned long crc;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+    z_crc_t val;
+    crcc_word crc0, crc1, crc2;
+    const crcc_word *word;
+    z_size_t last, last2, i;
+    z_size_t num;
+    int n;
+
+    /* Return initial CRC, if requested. */
+    if (buf == Z_NULL) return 0;
+
+    z_once(&madec, make_crc32c_table);
+
+    /* Pre-condition the CRC */
+    crc0 = crc ^ 0xffffffff;
+
+    /* Compute the CRC up to a word boundary. */
+    while (len && ((z_size_t)buf & 7) != 0) {
+        len--;
+        val = *buf++;
+        CRCC_BYTE(crc0, val);
+    }
+
+    /* Prepare to compute the CRC on full 64-bit words word[0..num-1]. */
+    word = (const crcc_word *)buf;
+    num = len >> 3;
+    len &= 7;
+
+    /* Do three interleaved CRCs on batches of the largest power of two words
+       that fit, up to 2^CRCC_MAX_BITS, and combine them, for as long as there
+       are enough words to pay for the combination. */
+    while (num >= (z_size_t)3 << CRCC_MIN_BITS) {
+        n = CRCC_MIN_BITS;
+        while (n < CRCC_MAX_BITS && num >= (z_size_t)6 << n)
+            n++;
+        last = (z_size_t)1 << n;
+        last2 = last << 1;
+        crc1 = 0;
+        crc2 = 0;
+        for (i = 0; i < last; i++) {
+            CRCC_WORD(crc0, word[i]);
+            CRCC_WORD(crc1, word[i + last]);
+            CRCC_WORD(crc2, word[i + last2]);
+        }
+        word += 3 * last;
+        num -= 3 * last;
+        val = x2nc_table[n + 6];
+        crc0 = multmod(val, (z_crc_t)crc0, POLYC) ^ crc1;
+        crc0 = multmod(val, (z_crc_t)crc0, POLYC) ^ crc2;
+    }
+
+    /* Compute the CRC on any remaining words. */
+    for (i = 0; i < num; i++)
+        CRCC_WORD(crc0, word[i]);
+    word += num;
+
+    /* Complete the CRC on any remaining bytes. */
+    buf = (const unsigned char FAR *)word;
+    while (len) {
+        len--;
+        val = *buf++;
+        CRCC_BYTE(crc0, val);
+    }
+
+    /* Return the CRC, post-conditioned. */
+    return (unsigned long)crc0 ^ 0xffffffff;
+}
+#endif
+
+#ifndef MAKECRCH
+/* The crc32_z() and crc32c_z() versions for this processor, chosen the first
+   time through by crc_choose(). */
+local unsigned long (*crc32_kern) OF((unsigned long crc,
+                                      const unsigned char FAR *buf,
+                                      z_size_t len));
+local unsigned long (*crc32c_kern) OF((unsigned long crc,
+                                       const unsigned char FAR *buf,
+                                       z_size_t len));
+local z_once_t crc_chosen = Z_ONCE_INIT;
+
+local void crc_choose OF((void));
+local void crc_choose()
+{
+    crc32_kern = crc32_base;
+    crc32c_kern = crc32c_base;
+#ifdef Z_X86_SIMD
+#  ifdef Z_X86_AVX512
+    if (z_cpu_features() & Z_CPU_VPCLMUL)
+        crc32_kern = crc32_vpclmul;
+    else
+#  endif
+    if (z_cpu_features() & Z_CPU_PCLMUL)
+        crc32_kern = crc32_pclmul;
+    if (z_cpu_features() & Z_CPU_SSE42)
+        crc32c_kern = crc32c_sse42;
+#endif
+}
+#endif
+
+/* ========================================================================= */
+unsigned long ZEXPORT crc32_z(crc, buf, len)
+    unsigned long crc;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+#ifdef MAKECRCH
+    return crc32_base(crc, buf, len);
+#else
+    z_once(&crc_chosen, crc_choose);
+    return crc32_kern(crc, buf, len);
 #endif
+}
 
 /* ========================================================================= */
 unsigned long ZEXPORT crc32(crc, buf, len)
@@ -1068,6 +1467,28 @@ unsigned long ZEXPORT crc32(crc, buf, len)
     return crc32_z(crc, buf, len);
 }
 
+/* ========================================================================= */
+unsigned long ZEXPORT crc32_copy(crc, dst, src, len)
+    unsigned long crc;
+    unsigned char FAR *dst;
+    const unsigned char FAR *src;
+    z_size_t len;
+{
+    z_size_t n;
+
+    if (src == Z_NULL)
+        return crc32_z(crc, src, len);
+    while (len) {
+        n = len < Z_COPY_CHUNK ? len : Z_COPY_CHUNK;
+        crc = crc32_z(crc, src, n);
+        zmemcpy(dst, src, (uInt)n);
+        dst += n;
+        src += n;
+        len -= n;
+    }
+    return crc;
+}
+
 /* ========================================================================= */
 uLong ZEXPORT crc32_combine64(crc1, crc2, len2)
     uLong crc1;
@@ -1075,7 +1496,7 @@ uLong ZEXPORT crc32_combine64(crc1, crc2, len2)
     z_off64_t len2;
 {
 #ifdef DYNAMIC_CRC_TABLE
-    once(&made, make_crc_table);
+    z_once(&made, make_crc_table);
 #endif /* DYNAMIC_CRC_TABLE */
     return multmodp(x2nmodp(len2, 3), crc1) ^ crc2;
 }
@@ -1094,7 +1515,7 @@ uLong ZEXPORT crc32_combine_gen64(len2)
     z_off64_t len2;
 {
 #ifdef DYNAMIC_CRC_TABLE
-    once(&made, make_crc_table);
+    z_once(&made, make_crc_table);
 #endif /* DYNAMIC_CRC_TABLE */
     return x2nmodp(len2, 3);
 }
@@ -1114,3 +1535,36 @@ uLong crc32_combine_op(crc1, crc2, op)
 {
     return multmodp(op, crc1) ^ crc2;
 }
+
+/* ========================================================================= */
+unsigned long ZEXPORT crc32c_z(crc, buf, len)
+    unsigned long crc;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+#ifdef MAKECRCH
+    return crc32c_base(crc, buf, len);
+#else
+    z_once(&crc_chosen, crc_choose);
+    return crc32c_kern(crc, buf, len);
+#endif
+}
+
+/* ========================================================================= */
+uLong ZEXPORT crc32c_combine64(crc1, crc2, len2)
+    uLong crc1;
+    uLong crc2;
+    z_off64_t len2;
+{
+    z_once(&madec, make_crc32c_table);
+    return multmod(x2nmod(len2, 3, x2nc_table, POLYC), crc1, POLYC) ^ crc2;
+}
+
+/* ========================================================================= */
+uLong ZEXPORT crc32c_combine(crc1, crc2, len2)
+    uLong crc1;
+    uLong crc2;
+    z_off_t len2;
+{
+    return crc32c_combine64(crc1, crc2, len2);
+}
@@ -51,6 +51,16 @@
 
 #include "deflate.h"
 
+#ifdef Z_X86_SIMD
+#  include <immintrin.h>
+#endif
+#ifdef Z_ARM_SIMD
+#  include <arm_neon.h>
+#  ifdef USE_CRC_HASH
+#    include <arm_acle.h>
+#  endif
+#endif
+
 const char deflate_copyright[] =
    " deflate 1.2.12 Copyright 1995-2022 Jean-loup Gailly and Mark Adler ";
 /*
@@ -80,9 +90,15 @@ local block_state deflate_stored OF((deflate_state *s, int flush));
 local block_state deflate_fast   OF((deflate_state *s, int flush));
 #ifndef FASTEST
 local block_state deflate_slow   OF((deflate_state *s, int flush));
+local void medium_match       OF((deflate_state *s));
+local block_state deflate_medium OF((deflate_state *s, int flush));
+local unsigned opt_matches    OF((deflate_state *s, IPos cur_match, uInt str,
+                                  uInt len, ushf *pair, unsigned room));
+local block_state deflate_optimal OF((deflate_state *s, int flush));
 #endif
 local block_state deflate_rle    OF((deflate_state *s, int flush));
 local block_state deflate_huff   OF((deflate_state *s, int flush));
+local block_state deflate_quick  OF((deflate_state *s, int flush));
 local void lm_init        OF((deflate_state *s));
 local void putShortMSB    OF((deflate_state *s, uInt b));
 local void flush_pending  OF((z_streamp strm));
@@ -112,8 +128,29 @@ local  void check_match OF((deflate_state *s, IPos start, IPos match,
 #endif
 /* Matches of length 3 are discarded if their distance exceeds TOO_FAR */
 
+#define OPT_CHUNK 16384
+/* Most bytes that deflate_optimal() parses at once */
+
+#define OPT_PAIRS 4
+/* Matches per byte that deflate_optimal() has room for, on average */
+
+/* Work space for deflate_optimal() */
+typedef struct opt_state_s {
+    ct_data ltree[HEAP_SIZE];       /* symbol counts, for the costs */
+    ct_data dtree[2*D_CODES+1];
+    uch lcost[L_CODES];             /* bits for each literal/length code */
+    uch dcost[D_CODES];             /* bits for each distance code */
+    uch mcost[MAX_MATCH+1];         /* bits for each match length */
+    uInt cost[OPT_CHUNK+1];         /* fewest bits to get to each byte */
+    ush step[OPT_CHUNK+1];          /* length of the last step to there */
+    ush dist[OPT_CHUNK+1];          /* its distance, zero for a literal */
+    uInt first[OPT_CHUNK+1];        /* start of each byte's matches */
+    ush match[2*OPT_PAIRS*OPT_CHUNK];   /* length, distance pairs */
+    ush parse[2][2*OPT_CHUNK];      /* latest and best parse, as pairs */
+} FAR opt_state;
+
 /* Values for max_lazy_match, good_match and max_chain_length, depending on
- * the desired pack level (0..9). The values given below have been tuned to
+ * the desired pack level (0..12). The values given below have been tuned to
  * exclude worst case performance for pathological files. Better values may be
  * found for specific files.
  */
@@ -131,24 +168,31 @@ local const config configuration_table[2] = {
 /* 0 */ {0,    0,  0,    0, deflate_stored},  /* store only */
 /* 1 */ {4,    4,  8,    4, deflate_fast}}; /* max speed, no lazy matches */
 #else
-local const config configuration_table[10] = {
+local const config configuration_table[13] = {
 /*      good lazy nice chain */
 /* 0 */ {0,    0,  0,    0, deflate_stored},  /* store only */
 /* 1 */ {4,    4,  8,    4, deflate_fast}, /* max speed, no lazy matches */
 /* 2 */ {4,    5, 16,    8, deflate_fast},
-/* 3 */ {4,    6, 32,   32, deflate_fast},
+/* 3 */ {4,   16, 16,    4, deflate_medium}, /* greedy, one step ahead */
+/* 4 */ {8,   16, 32,    8, deflate_medium},
+/* 5 */ {16,  32, 64,   24, deflate_medium},
+/* 6 */ {12,  64, 128,  96, deflate_medium},
 
-/* 4 */ {4,    4, 16,   16, deflate_slow},  /* lazy matches */
-/* 5 */ {8,   16, 32,   32, deflate_slow},
-/* 6 */ {8,   16, 128, 128, deflate_slow},
-/* 7 */ {8,   32, 128, 256, deflate_slow},
+/* 7 */ {8,   32, 128, 256, deflate_slow},  /* lazy matches */
 /* 8 */ {32, 128, 258, 1024, deflate_slow},
-/* 9 */ {32, 258, 258, 4096, deflate_slow}}; /* max compression */
+/* 9 */ {32, 258, 258, 4096, deflate_slow},  /* max compression */
+
+/* 10 */ {2, 258, 258, 1024, deflate_optimal},  /* optimal parsing */
+/* 11 */ {5, 258, 258, 4096, deflate_optimal},
+/* 12 */ {15, 258, 258, 8192, deflate_optimal}};
 #endif
 
 /* Note: the deflate() code requires max_lazy >= MIN_MATCH and max_chain >= 4
- * For deflate_fast() (levels <= 3) good is ignored and lazy has a different
- * meaning.
+ * For deflate_fast() (levels <= 2) good is ignored and lazy has a different
+ * meaning. For deflate_medium() (levels 3 to 6) lazy has that same meaning,
+ * and matches shorter than good are checked against a match at the next byte.
+ * For deflate_optimal() (levels 10 to 12) good is the most passes made to
+ * refine the costs, and lazy is ignored.
  */
 
 /* rank Z_BLOCK between Z_NO_FLUSH and Z_PARTIAL_FLUSH */
@@ -162,6 +206,70 @@ local const config configuration_table[10] = {
  */
 #define UPDATE_HASH(s,h,c) (h = (((h)<<s->hash_shift) ^ (c)) & s->hash_mask)
 
+#ifdef USE_CRC_HASH
+/* ===========================================================================
+ * Return the CRC-32C of the four bytes at str, for use as a hash key. All four
+ * bytes are mixed into every bit of the key, which spreads the strings over
+ * the buckets far better than UPDATE_HASH() does, and the key does not depend
+ * on the one for the string before, so strings can be hashed in any order.
+ * Only used if s->crc_hash was set by deflateInit2_(). The fourth byte can be
+ * past the current input (but not past the window allocation), which at worst
+ * misses a match.
+ */
+local uInt crc_hash OF((const Bytef *str));
+local uInt crc_hash(str)
+    const Bytef *str;
+{
+    unsigned val, h = 0;
+
+    val = str[0] | ((unsigned)str[1] << 8) | ((unsigned)str[2] << 16) |
+          ((unsigned)str[3] << 24);
+#  ifdef Z_ARM_SIMD
+    h = __crc32cw(h, val);
+#  elif defined(_MSC_VER) && !defined(__clang__)
+    h = _mm_crc32_u32(h, val);
+#  else
+    /* no target attribute needed, so this can be inlined into any caller */
+    __asm__("crc32l %1, %0" : "+r"(h) : "rm"(val));
+#  endif
+    return h;
+}
+
+#  define HASH_STRING(s, str) \
+   (s->crc_hash ? (s->ins_h = crc_hash(s->window + (str)) & s->hash_mask) : \
+    (UPDATE_HASH(s, s->ins_h, s->window[(str) + (MIN_MATCH-1)])))
+#else
+#  define HASH_STRING(s, str) \
+   UPDATE_HASH(s, s->ins_h, s->window[(str) + (MIN_MATCH-1)])
+#endif
+/* Set s->ins_h to the hash key of the string at str, either by updating the
+ * running key or, if s->crc_hash is set, from scratch.
+ */
+
+#define QUICK_KEY(s, p) \
+   ((uInt)(((((ulg)(p)[0] | ((ulg)(p)[1] << 8) | ((ulg)(p)[2] << 16) | \
+              ((ulg)(p)[3] << 24)) * 2654435761UL) & 0xffffffffUL) >> \
+           (32 - (s)->hash_bits)))
+/* Hash key of the four bytes at p for deflate_quick(), which only emits
+ * matches of at least four bytes, made by multiplying them by a constant
+ * near 2^32 divided by the golden ratio and keeping the top hash_bits bits
+ * of the product. Like crc_hash(), the key does not depend on the key for the
+ * string before, and the fourth byte can be past the current input.
+ */
+
+#ifdef USE_CRC_HASH
+#  define QUICK_STRING(s, str) \
+   (s->strategy == Z_QUICK && !s->crc_hash ? \
+    (s->ins_h = QUICK_KEY(s, s->window + (str))) : HASH_STRING(s, str))
+#else
+#  define QUICK_STRING(s, str) \
+   (s->strategy == Z_QUICK ? (s->ins_h = QUICK_KEY(s, s->window + (str))) : \
+    HASH_STRING(s, str))
+#endif
+/* Set s->ins_h to the hash key of the string at str for the current strategy,
+ * for insertions that are not in a compression loop.
+ */
+
 
 /* ===========================================================================
  * Insert string str in the dictionary and set match_head to the previous head
@@ -175,12 +283,12 @@ local const config configuration_table[10] = {
  */
 #ifdef FASTEST
 #define INSERT_STRING(s, str, match_head) \
-   (UPDATE_HASH(s, s->ins_h, s->window[(str) + (MIN_MATCH-1)]), \
+   (HASH_STRING(s, str), \
     match_head = s->head[s->ins_h], \
     s->head[s->ins_h] = (Pos)(str))
 #else
 #define INSERT_STRING(s, str, match_head) \
-   (UPDATE_HASH(s, s->ins_h, s->window[(str) + (MIN_MATCH-1)]), \
+   (HASH_STRING(s, str), \
     match_head = s->prev[(str) & s->w_mask] = s->head[s->ins_h], \
     s->head[s->ins_h] = (Pos)(str))
 #endif
@@ -204,28 +312,83 @@ local const config configuration_table[10] = {
 local void slide_hash(s)
     deflate_state *s;
 {
-    unsigned n, m;
+    s->slide(s->head, s->hash_size, s->w_size);
+#ifndef FASTEST
+    s->slide(s->prev, s->w_size, s->w_size);
+    /* If n is not on any hash chain, prev[n] is garbage but its value will
+     * never be used.
+     */
+#endif
+}
+
+/* ===========================================================================
+ * Subtract wsize from each of the n entries of a hash table, setting those
+ * that would go negative to NIL, since they are now outside of the window.
+ * The SIMD versions below do the same with unsigned saturating subtracts, and
+ * require that n be a multiple of 16, which is always true for the head and
+ * prev tables.
+ */
+void ZLIB_INTERNAL slide_hash_c(table, n, wsize)
+    Posf *table;
+    unsigned n;
+    uInt wsize;
+{
+    unsigned m;
     Posf *p;
-    uInt wsize = s->w_size;
 
-    n = s->hash_size;
-    p = &s->head[n];
+    p = &table[n];
     do {
         m = *--p;
         *p = (Pos)(m >= wsize ? m - wsize : NIL);
     } while (--n);
-    n = wsize;
-#ifndef FASTEST
-    p = &s->prev[n];
+}
+
+#ifdef Z_X86_SIMD
+void ZLIB_INTERNAL slide_hash_sse2(table, n, wsize)
+    Posf *table;
+    unsigned n;
+    uInt wsize;
+{
+    __m128i *p = (__m128i *)table;
+    __m128i w = _mm_set1_epi16((short)wsize);
+
     do {
-        m = *--p;
-        *p = (Pos)(m >= wsize ? m - wsize : NIL);
-        /* If n is not on any hash chain, prev[n] is garbage but
-         * its value will never be used.
-         */
-    } while (--n);
-#endif
+        _mm_storeu_si128(p, _mm_subs_epu16(_mm_loadu_si128(p), w));
+        p++;
+    } while (n -= 8);
+}
+
+Z_TARGET("avx2") void ZLIB_INTERNAL slide_hash_avx2(table, n, wsize)
+    Posf *table;
+    unsigned n;
+    uInt wsize;
+{
+    __m256i *p = (__m256i *)table;
+    __m256i w = _mm256_set1_epi16((short)wsize);
+
+    do {
+        _mm256_storeu_si256(p, _mm256_subs_epu16(_mm256_loadu_si256(p), w));
+        p++;
+    } while (n -= 16);
+}
+#endif /* Z_X86_SIMD */
+
+#ifdef Z_ARM_SIMD
+void ZLIB_INTERNAL slide_hash_neon(table, n, wsize)
+    Posf *table;
+    unsigned n;
+    uInt wsize;
+{
+    uint16_t *p = (uint16_t *)table;
+    uint16x8_t w = vdupq_n_u16((uint16_t)wsize);
+
+    do {
+        vst1q_u16(p, vqsubq_u16(vld1q_u16(p), w));
+        vst1q_u16(p + 8, vqsubq_u16(vld1q_u16(p + 8), w));
+        p += 16;
+    } while (n -= 16);
 }
+#endif /* Z_ARM_SIMD */
 
 /* ========================================================================= */
 int ZEXPORT deflateInit_(strm, level, version, stream_size)
@@ -294,8 +457,9 @@ int ZEXPORT deflateInit2_(strm, level, method, windowBits, memLevel, strategy,
     }
 #endif
     if (memLevel < 1 || memLevel > MAX_MEM_LEVEL || method != Z_DEFLATED ||
-        windowBits < 8 || windowBits > 15 || level < 0 || level > 9 ||
-        strategy < 0 || strategy > Z_FIXED || (windowBits == 8 && wrap != 1)) {
+        windowBits < 8 || windowBits > 15 || level < 0 ||
+        level > Z_OPTIMAL_COMPRESSION ||
+        strategy < 0 || strategy > Z_QUICK || (windowBits == 8 && wrap != 1)) {
         return Z_STREAM_ERROR;
     }
     if (windowBits == 8) windowBits = 9;  /* until 256-byte window bug fixed */
@@ -316,7 +480,7 @@ int ZEXPORT deflateInit2_(strm, level, method, windowBits, memLevel, strategy,
     s->hash_mask = s->hash_size - 1;
     s->hash_shift =  ((s->hash_bits+MIN_MATCH-1)/MIN_MATCH);
 
-    s->window = (Bytef *) ZALLOC(strm, s->w_size, 2*sizeof(Byte));
+    s->window = (Bytef *) ZALLOC(strm, s->w_size + WIN_PAD, 2*sizeof(Byte));
     s->prev   = (Posf *)  ZALLOC(strm, s->w_size, sizeof(Pos));
     s->head   = (Posf *)  ZALLOC(strm, s->hash_size, sizeof(Pos));
 
@@ -360,19 +524,32 @@ int ZEXPORT deflateInit2_(strm, level, method, windowBits, memLevel, strategy,
      * fewer bits than a fixed-code block would for the same set of symbols.
      * Therefore its average symbol length is assured to be less than 31. So
      * the compressed data for a dynamic block also cannot overwrite the
-     * symbols from which it is being constructed.
+     * symbols from which it is being constructed. The same holds for each of
+     * the blocks that deflateSplit() may send for one set of symbols, since
+     * each is chosen the same way, and those each add at most ten bits of
+     * header and alignment, far less than the slack of the above analysis.
      */
 
     s->pending_buf = (uchf *) ZALLOC(strm, s->lit_bufsize, 4);
     s->pending_buf_size = (ulg)s->lit_bufsize * 4;
 
+    s->opt = Z_NULL;
+    if (level > Z_BEST_COMPRESSION)
+        s->opt = (opt_state *) ZALLOC(strm, 1, sizeof(opt_state));
+    s->split = 1;
+    s->split_freq = Z_NULL;
+
     if (s->window == Z_NULL || s->prev == Z_NULL || s->head == Z_NULL ||
-        s->pending_buf == Z_NULL) {
+        s->pending_buf == Z_NULL ||
+        (level > Z_BEST_COMPRESSION && s->opt == Z_NULL)) {
         s->status = FINISH_STATE;
         strm->msg = ERR_MSG(Z_MEM_ERROR);
         deflateEnd (strm);
         return Z_MEM_ERROR;
     }
+#if WIN_PAD
+    zmemzero(s->window + 2*s->w_size, 2*WIN_PAD);
+#endif
     s->sym_buf = s->pending_buf + s->lit_bufsize;
     s->sym_end = (s->lit_bufsize - 1) * 3;
     /* We avoid equality with lit_bufsize*3 because of wraparound at 64K
@@ -384,6 +561,29 @@ int ZEXPORT deflateInit2_(strm, level, method, windowBits, memLevel, strategy,
     s->strategy = strategy;
     s->method = (Byte)method;
 
+    s->slide = slide_hash_c;
+#ifdef Z_X86_SIMD
+    if (z_cpu_features() & Z_CPU_AVX2) {
+        s->slide = slide_hash_avx2;
+        s->compare = compare256_avx2;
+    }
+    else {
+        s->slide = slide_hash_sse2;
+        s->compare = compare256_sse2;
+    }
+#endif
+#ifdef Z_ARM_SIMD
+    s->slide = slide_hash_neon;
+    s->compare = compare256_neon;
+#endif
+#ifdef USE_CRC_HASH
+#  ifdef Z_ARM_SIMD
+    s->crc_hash = 1;
+#  else
+    s->crc_hash = (z_cpu_features() & Z_CPU_SSE42) != 0;
+#  endif
+#endif
+
     return deflateReset(strm);
 }
 
@@ -458,7 +658,7 @@ int ZEXPORT deflateSetDictionary (strm, dictionary, dictLength)
         str = s->strstart;
         n = s->lookahead - (MIN_MATCH-1);
         do {
-            UPDATE_HASH(s, s->ins_h, s->window[str + MIN_MATCH-1]);
+            QUICK_STRING(s, str);
 #ifndef FASTEST
             s->prev[str & s->w_mask] = s->head[s->ins_h];
 #endif
@@ -596,7 +796,7 @@ int ZEXPORT deflatePrime (strm, bits, value)
         put = Buf_size - s->bi_valid;
         if (put > bits)
             put = bits;
-        s->bi_buf |= (ush)((value & ((1 << put) - 1)) << s->bi_valid);
+        s->bi_buf |= (bi_t)(value & ((1 << put) - 1)) << s->bi_valid;
         s->bi_valid += put;
         _tr_flush_bits(s);
         value >>= put;
@@ -622,7 +822,8 @@ int ZEXPORT deflateParams(strm, level, strategy)
 #else
     if (level == Z_DEFAULT_COMPRESSION) level = 6;
 #endif
-    if (level < 0 || level > 9 || strategy < 0 || strategy > Z_FIXED) {
+    if (level < 0 || level > Z_OPTIMAL_COMPRESSION || strategy < 0 ||
+        strategy > Z_QUICK) {
         return Z_STREAM_ERROR;
     }
     func = configuration_table[s->level].func;
@@ -636,6 +837,11 @@ int ZEXPORT deflateParams(strm, level, strategy)
         if (strm->avail_in || (s->strstart - s->block_start) + s->lookahead)
             return Z_BUF_ERROR;
     }
+    if (level > Z_BEST_COMPRESSION && s->opt == Z_NULL) {
+        s->opt = (opt_state *) ZALLOC(strm, 1, sizeof(opt_state));
+        if (s->opt == Z_NULL)
+            return Z_MEM_ERROR;
+    }
     if (s->level != level) {
         if (s->level == 0 && s->matches != 0) {
             if (s->matches == 1)
@@ -673,6 +879,25 @@ int ZEXPORT deflateTune(strm, good_length, max_lazy, nice_length, max_chain)
     return Z_OK;
 }
 
+/* ========================================================================= */
+int ZEXPORT deflateSplit(strm, parts)
+    z_streamp strm;
+    int parts;
+{
+    deflate_state *s;
+
+    if (deflateStateCheck(strm)) return Z_STREAM_ERROR;
+    s = strm->state;
+    if (parts < 1 || parts > SPLIT_SEGS) return Z_STREAM_ERROR;
+    if (parts > 1 && s->split_freq == Z_NULL) {
+        s->split_freq = (ushf *) ZALLOC(strm, (SPLIT_SEGS + 1) *
+                                        (L_CODES + D_CODES), sizeof(ush));
+        if (s->split_freq == Z_NULL) return Z_MEM_ERROR;
+    }
+    s->split = parts;
+    return Z_OK;
+}
+
 /* =========================================================================
  * For the default windowBits of 15 and memLevel of 8, this function returns
  * a close to exact, as well as small, upper bound on the compressed size.
@@ -740,8 +965,11 @@ uLong ZEXPORT deflateBound(strm, sourceLen)
         wraplen = 6;
     }
 
-    /* if not default parameters, return conservative bound */
-    if (s->w_bits != 15 || s->hash_bits != 8 + 7)
+    /* if not default parameters, or if Z_QUICK, which never falls back to
+       stored blocks, or if blocks may be split into more stored blocks,
+       return conservative bound */
+    if (s->w_bits != 15 || s->hash_bits != 8 + 7 || s->strategy == Z_QUICK ||
+        s->split > 1)
         return complen + wraplen;
 
     /* default settings: return tight bound for that case */
@@ -901,7 +1129,7 @@ int ZEXPORT deflate (strm, flush)
             put_byte(s, 0);
             put_byte(s, 0);
             put_byte(s, 0);
-            put_byte(s, s->level == 9 ? 2 :
+            put_byte(s, s->level >= 9 ? 2 :
                      (s->strategy >= Z_HUFFMAN_ONLY || s->level < 2 ?
                       4 : 0));
             put_byte(s, OS_CODE);
@@ -925,7 +1153,7 @@ int ZEXPORT deflate (strm, flush)
             put_byte(s, (Byte)((s->gzhead->time >> 8) & 0xff));
             put_byte(s, (Byte)((s->gzhead->time >> 16) & 0xff));
             put_byte(s, (Byte)((s->gzhead->time >> 24) & 0xff));
-            put_byte(s, s->level == 9 ? 2 :
+            put_byte(s, s->level >= 9 ? 2 :
                      (s->strategy >= Z_HUFFMAN_ONLY || s->level < 2 ?
                       4 : 0));
             put_byte(s, s->gzhead->os & 0xff);
@@ -1043,6 +1271,7 @@ int ZEXPORT deflate (strm, flush)
         bstate = s->level == 0 ? deflate_stored(s, flush) :
                  s->strategy == Z_HUFFMAN_ONLY ? deflate_huff(s, flush) :
                  s->strategy == Z_RLE ? deflate_rle(s, flush) :
+                 s->strategy == Z_QUICK ? deflate_quick(s, flush) :
                  (*(configuration_table[s->level].func))(s, flush);
 
         if (bstate == finish_started || bstate == finish_done) {
@@ -1126,6 +1355,8 @@ int ZEXPORT deflateEnd (strm)
     status = strm->state->status;
 
     /* Deallocate in reverse order of allocations: */
+    TRY_FREE(strm, strm->state->split_freq);
+    TRY_FREE(strm, strm->state->opt);
     TRY_FREE(strm, strm->state->pending_buf);
     TRY_FREE(strm, strm->state->head);
     TRY_FREE(strm, strm->state->prev);
@@ -1167,18 +1398,25 @@ int ZEXPORT deflateCopy (dest, source)
     zmemcpy((voidpf)ds, (voidpf)ss, sizeof(deflate_state));
     ds->strm = dest;
 
-    ds->window = (Bytef *) ZALLOC(dest, ds->w_size, 2*sizeof(Byte));
+    ds->window = (Bytef *) ZALLOC(dest, ds->w_size + WIN_PAD, 2*sizeof(Byte));
     ds->prev   = (Posf *)  ZALLOC(dest, ds->w_size, sizeof(Pos));
     ds->head   = (Posf *)  ZALLOC(dest, ds->hash_size, sizeof(Pos));
     ds->pending_buf = (uchf *) ZALLOC(dest, ds->lit_bufsize, 4);
+    if (ss->opt != Z_NULL)      /* work space only, so nothing to copy */
+        ds->opt = (opt_state *) ZALLOC(dest, 1, sizeof(opt_state));
+    if (ss->split_freq != Z_NULL)       /* likewise */
+        ds->split_freq = (ushf *) ZALLOC(dest, (SPLIT_SEGS + 1) *
+                                         (L_CODES + D_CODES), sizeof(ush));
 
     if (ds->window == Z_NULL || ds->prev == Z_NULL || ds->head == Z_NULL ||
-        ds->pending_buf == Z_NULL) {
+        ds->pending_buf == Z_NULL ||
+        (ss->opt != Z_NULL && ds->opt == Z_NULL) ||
+        (ss->split_freq != Z_NULL && ds->split_freq == Z_NULL)) {
         deflateEnd (dest);
         return Z_MEM_ERROR;
     }
     /* following zmemcpy do not work for 16-bit MSDOS */
-    zmemcpy(ds->window, ss->window, ds->w_size * 2 * sizeof(Byte));
+    zmemcpy(ds->window, ss->window, (ds->w_size + WIN_PAD) * 2 * sizeof(Byte));
     zmemcpy((voidpf)ds->prev, (voidpf)ss->prev, ds->w_size * sizeof(Pos));
     zmemcpy((voidpf)ds->head, (voidpf)ss->head, ds->hash_size * sizeof(Pos));
     zmemcpy(ds->pending_buf, ss->pending_buf, (uInt)ds->pending_buf_size);
@@ -1199,7 +1437,8 @@ int ZEXPORT deflateCopy (dest, source)
  * and total number of bytes read.  All deflate() input goes through
  * this function so some applications may wish to modify it to avoid
  * allocating a large strm->next_in buffer and copying from it.
- * (See also flush_pending()).
+ * (See also flush_pending()).  The check value is computed as the input is
+ * copied, so that the input is read from memory only once.
  */
 local unsigned read_buf(strm, buf, size)
     z_streamp strm;
@@ -1213,15 +1452,17 @@ local unsigned read_buf(strm, buf, size)
 
     strm->avail_in  -= len;
 
-    zmemcpy(buf, strm->next_in, len);
     if (strm->state->wrap == 1) {
-        strm->adler = adler32(strm->adler, buf, len);
+        strm->adler = adler32_copy(strm->adler, buf, strm->next_in, len);
     }
 #ifdef GZIP
     else if (strm->state->wrap == 2) {
-        strm->adler = crc32(strm->adler, buf, len);
+        strm->adler = crc32_copy(strm->adler, buf, strm->next_in, len);
     }
 #endif
+    else {
+        zmemcpy(buf, strm->next_in, len);
+    }
     strm->next_in  += len;
     strm->total_in += len;
 
@@ -1252,6 +1493,7 @@ local void lm_init (s)
     s->match_length = s->prev_length = MIN_MATCH-1;
     s->match_available = 0;
     s->ins_h = 0;
+    s->block_open = 0;
 #ifndef FASTEST
 #ifdef ASMV
     match_init(); /* initialize the asm code */
@@ -1259,6 +1501,88 @@ local void lm_init (s)
 #endif
 }
 
+#if (defined(Z_X86_SIMD) || defined(Z_ARM_SIMD)) && !defined(UNALIGNED_OK)
+#  define SIMD_MATCH
+#endif
+/* When SIMD_MATCH is defined, longest_match() compares strings using the
+ * s->compare() function that deflateInit2_() chose for the processor. If
+ * UNALIGNED_OK is defined, the two bytes at a time comparison is used instead.
+ * The match lengths found, and so the compressed output, are the same either
+ * way.
+ */
+
+#ifdef Z_X86_SIMD
+/* ===========================================================================
+ * Return the number of leading bytes that are equal in scan[0..255] and
+ * match[0..255], comparing sixteen bytes at a time with SSE2. The first
+ * mismatch is located with a count of the trailing zeros in the mask of equal
+ * bytes. The window always has MAX_MATCH bytes after strstart, so reading all
+ * 256 bytes starting at strstart+2 stays inside the window.
+ */
+unsigned ZLIB_INTERNAL compare256_sse2(scan, match)
+    const Bytef *scan;
+    const Bytef *match;
+{
+    unsigned len = 0, mask;
+
+    do {
+        mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(
+            _mm_loadu_si128((const __m128i *)(scan + len)),
+            _mm_loadu_si128((const __m128i *)(match + len))));
+        if (mask != 0xffff)
+            return len + z_ctz32(~mask);
+        len += 16;
+    } while (len < 256);
+    return 256;
+}
+
+/* ===========================================================================
+ * Same as above, but thirty-two bytes at a time with AVX2.
+ */
+Z_TARGET("avx2") unsigned ZLIB_INTERNAL compare256_avx2(scan, match)
+    const Bytef *scan;
+    const Bytef *match;
+{
+    unsigned len = 0, mask;
+
+    do {
+        mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            _mm256_loadu_si256((const __m256i *)(scan + len)),
+            _mm256_loadu_si256((const __m256i *)(match + len))));
+        if (mask != 0xffffffff)
+            return len + z_ctz32(~mask);
+        len += 32;
+    } while (len < 256);
+    return 256;
+}
+#endif /* Z_X86_SIMD */
+
+#ifdef Z_ARM_SIMD
+/* ===========================================================================
+ * Same as above, sixteen bytes at a time with NEON. NEON has no movemask, so
+ * the byte comparison result is narrowed to four bits per byte in a 64-bit
+ * value, and the trailing zero count divided by four.
+ */
+unsigned ZLIB_INTERNAL compare256_neon(scan, match)
+    const Bytef *scan;
+    const Bytef *match;
+{
+    unsigned len = 0;
+    uint8x16_t eq;
+    uint64_t ne;
+
+    do {
+        eq = vceqq_u8(vld1q_u8(scan + len), vld1q_u8(match + len));
+        ne = ~vget_lane_u64(vreinterpret_u64_u8(
+                 vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        if (ne)
+            return len + (z_ctz64(ne) >> 2);
+        len += 16;
+    } while (len < 256);
+    return 256;
+}
+#endif /* Z_ARM_SIMD */
+
 #ifndef FASTEST
 /* ===========================================================================
  * Set match_start to the longest match starting at the given string and
@@ -1299,7 +1623,9 @@ local uInt longest_match(s, cur_match)
     register ush scan_start = *(ushf*)scan;
     register ush scan_end   = *(ushf*)(scan+best_len-1);
 #else
+#ifndef SIMD_MATCH
     register Bytef *strend = s->window + s->strstart + MAX_MATCH;
+#endif
     register Byte scan_end1  = scan[best_len-1];
     register Byte scan_end   = scan[best_len];
 #endif
@@ -1378,6 +1704,12 @@ local uInt longest_match(s, cur_match)
          * are always equal when the other bytes match, given that
          * the hash keys are equal and that HASH_BITS >= 8.
          */
+#ifdef SIMD_MATCH
+        /* Compare the remaining MAX_MATCH-2 bytes a vector at a time. This
+         * includes scan[2], and so works whatever the hash function.
+         */
+        len = 2 + (int)s->compare(scan + 2, match + 1);
+#else
         scan += 2, match++;
         Assert(*scan == *match, "match[2]?");
 
@@ -1395,6 +1727,7 @@ local uInt longest_match(s, cur_match)
 
         len = MAX_MATCH - (int)(strend - scan);
         scan = strend - MAX_MATCH;
+#endif /* SIMD_MATCH */
 
 #endif /* UNALIGNED_OK */
 
@@ -1429,7 +1762,9 @@ local uInt longest_match(s, cur_match)
     register Bytef *scan = s->window + s->strstart; /* current string */
     register Bytef *match;                       /* matched string */
     register int len;                           /* length of current match */
+#ifndef SIMD_MATCH
     register Bytef *strend = s->window + s->strstart + MAX_MATCH;
+#endif
 
     /* The code is optimized for HASH_BITS >= 8 and MAX_MATCH-2 multiple of 16.
      * It is easy to get rid of this optimization if necessary.
@@ -1452,6 +1787,9 @@ local uInt longest_match(s, cur_match)
      * are always equal when the other bytes match, given that
      * the hash keys are equal and that HASH_BITS >= 8.
      */
+#ifdef SIMD_MATCH
+    len = 2 + (int)s->compare(scan + 2, match + 2);
+#else
     scan += 2, match += 2;
     Assert(*scan == *match, "match[2]?");
 
@@ -1468,6 +1806,7 @@ local uInt longest_match(s, cur_match)
     Assert(scan <= s->window+(unsigned)(s->window_size-1), "wild scan");
 
     len = MAX_MATCH - (int)(strend - scan);
+#endif
 
     if (len < MIN_MATCH) return MIN_MATCH - 1;
 
@@ -1585,7 +1924,7 @@ local void fill_window(s)
             Call UPDATE_HASH() MIN_MATCH-3 more times
 #endif
             while (s->insert) {
-                UPDATE_HASH(s, s->ins_h, s->window[str + MIN_MATCH-1]);
+                QUICK_STRING(s, str);
 #ifndef FASTEST
                 s->prev[str & s->w_mask] = s->head[s->ins_h];
 #endif
@@ -2095,6 +2434,472 @@ local block_state deflate_slow(s, flush)
         FLUSH_BLOCK(s, 0);
     return block_done;
 }
+
+/* ===========================================================================
+ * Insert the string at strstart in the dictionary, and set match_length to
+ * the length of the longest match for it, or to zero if there is none worth
+ * taking. longest_match() sets match_start.
+ */
+local void medium_match(s)
+    deflate_state *s;
+{
+    IPos hash_head = NIL;
+
+    s->match_length = 0;
+    if (s->lookahead >= MIN_MATCH) {
+        INSERT_STRING(s, s->strstart, hash_head);
+    }
+    if (hash_head != NIL && s->strstart - hash_head <= MAX_DIST(s)) {
+        s->match_length = longest_match (s, hash_head);
+        if (s->match_length < MIN_MATCH || (s->match_length <= 5 &&
+            (s->strategy == Z_FILTERED || (s->match_length == MIN_MATCH &&
+                                s->strstart - s->match_start > TOO_FAR))))
+            s->match_length = 0;
+    }
+}
+
+/* ===========================================================================
+ * Between deflate_fast() and deflate_slow(). Matches are taken greedily, but
+ * once one is found (or a literal), a match is also looked for where it ends.
+ * If that next match still holds going backwards all the way to the start of
+ * the current one, then the current one is dropped and the next is taken
+ * from there instead, and the same is tried again where it ends. This picks
+ * up most of what the lazy evaluation gains, at close to the cost of greedy
+ * matching, since the look at the next position is not wasted: the next
+ * match found is the one used on the next step. That match is kept in
+ * match_length and match_start with match_available set, where match_length
+ * is zero if there was none. Matches shorter than good_match also get the
+ * lazy check of deflate_slow() against a match at the next byte.
+ */
+local block_state deflate_medium(s, flush)
+    deflate_state *s;
+    int flush;
+{
+    IPos hash_head;         /* head of the hash chain */
+    int bflush;             /* set if current block must be flushed */
+    uInt start;             /* start of the current match or literal */
+    uInt length;            /* its length, one for a literal */
+    uInt distance;          /* its distance, zero for a literal */
+    uInt done;              /* last string inserted in the dictionary */
+    uInt back;              /* how far back the next match goes */
+
+    /* longest_match() only returns matches longer than prev_length, which
+     * deflate_slow() may have left set
+     */
+    s->prev_length = MIN_MATCH-1;
+    for (;;) {
+        /* Make sure that we always have enough lookahead, except
+         * at the end of the input file. We need MAX_MATCH bytes
+         * for the next match, plus MIN_MATCH bytes to insert the
+         * string following the next match.
+         */
+        if (s->lookahead < MIN_LOOKAHEAD) {
+            fill_window(s);
+            if (s->lookahead < MIN_LOOKAHEAD && flush == Z_NO_FLUSH) {
+                return need_more;
+            }
+            if (s->lookahead == 0) break; /* flush the current block */
+        }
+
+        /* Find the longest match at strstart, unless the last step did */
+        if (!s->match_available)
+            medium_match(s);
+        s->match_available = 0;
+        start = done = s->strstart;
+        for (;;) {
+            if (s->match_length) {
+                length = s->match_length;
+                distance = start - s->match_start;
+            }
+            else {
+                length = 1;
+                distance = 0;
+            }
+
+            /* Insert the strings inside the match in the dictionary, unless
+             * the match is long, as for deflate_fast().
+             */
+            if (length <= s->max_insert_length) {
+                while (done + 1 < start + length) {
+                    done++;
+                    INSERT_STRING(s, done, hash_head);
+                }
+            }
+            else if (done + 1 < start + length) {
+                done = start + length - 1;
+                s->ins_h = s->window[done + 1];
+                UPDATE_HASH(s, s->ins_h, s->window[done + 2]);
+#if MIN_MATCH != 3
+                Call UPDATE_HASH() MIN_MATCH-3 more times
+#endif
+            }
+
+            /* If the current match is short, see if there is a longer one
+             * at the next byte, as deflate_slow() would
+             */
+            if (distance && length < s->good_match &&
+                length <= s->max_insert_length &&
+                s->lookahead > MIN_LOOKAHEAD &&
+                s->sym_next + 3 < s->sym_end) {
+                hash_head = s->prev[(start + 1) & s->w_mask];
+                if (hash_head != NIL && start + 1 - hash_head <= MAX_DIST(s)) {
+                    s->strstart = start + 1;
+                    s->lookahead--;
+                    s->prev_length = length;
+                    s->match_length = longest_match (s, hash_head);
+                    s->prev_length = MIN_MATCH-1;
+                    if (s->match_length > length) {
+                        Tracevv((stderr,"%c", s->window[start]));
+                        _tr_tally_lit(s, s->window[start], bflush);
+                        start++;
+                        continue;
+                    }
+                    s->strstart = start;
+                    s->lookahead++;
+                }
+            }
+
+            /* Find the match where this one ends, if there is room for it */
+            if (s->lookahead - length < MIN_LOOKAHEAD)
+                break;
+            s->strstart = start + length;
+            s->lookahead -= length;
+            medium_match(s);
+            done = s->strstart;
+            s->strstart = start;
+            s->lookahead += length;
+            s->match_available = 1;
+            if (s->match_length == 0)
+                break;
+
+            /* See how far back the next match goes. If it goes back to
+             * start, take it from there instead. If the current one is a
+             * match and the next goes back to one byte after its start, then
+             * emit a literal for that byte, and take the next match from
+             * there, if there is room for the literal without filling the
+             * symbol buffer.
+             */
+            back = 0;
+            while (back < length && back < s->match_start &&
+                   s->match_length + back < MAX_MATCH &&
+                   s->window[start + length - 1 - back] ==
+                   s->window[s->match_start - 1 - back])
+                back++;
+            if (distance && back == length - 1 &&
+                s->sym_next + 3 < s->sym_end) {
+                Tracevv((stderr,"%c", s->window[start]));
+                _tr_tally_lit(s, s->window[start], bflush);
+                start++;
+                s->strstart = start;
+                s->lookahead--;
+            }
+            else if (back < length)
+                break;
+            s->match_start -= back;
+            s->match_length += back;
+            s->match_available = 0;
+        }
+
+        /* Emit the current match or literal */
+        if (distance) {
+            check_match(s, start, start - distance, length);
+            _tr_tally_dist(s, distance, length - MIN_MATCH, bflush);
+        }
+        else {
+            Tracevv((stderr,"%c", s->window[start]));
+            _tr_tally_lit(s, s->window[start], bflush);
+        }
+        s->strstart = start + length;
+        s->lookahead -= length;
+        if (bflush) FLUSH_BLOCK(s, 0);
+    }
+    Assert (!s->match_available, "match left over");
+    s->match_length = MIN_MATCH-1;  /* for deflate_fast() and deflate_slow() */
+    s->insert = s->strstart < MIN_MATCH-1 ? s->strstart : MIN_MATCH-1;
+    if (flush == Z_FINISH) {
+        FLUSH_BLOCK(s, 1);
+        return finish_done;
+    }
+    if (s->sym_next)
+        FLUSH_BLOCK(s, 0);
+    return block_done;
+}
+
+/* ===========================================================================
+ * Walk the hash chain from cur_match for the string at str, and put in pair[]
+ * the matches found that are longer than all of those before them, as length
+ * and distance pairs, up to len bytes long. So each match in pair[] is the
+ * closest one of its length or longer. Return the number of pairs. If there
+ * are more than room, the last pair is replaced by a longer match. Nothing
+ * at or past str + len is read, so the lookahead can be all that there is.
+ */
+local unsigned opt_matches(s, cur_match, str, len, pair, room)
+    deflate_state *s;
+    IPos cur_match;                 /* head of the hash chain */
+    uInt str;                       /* string to match */
+    uInt len;                       /* longest match to look for */
+    ushf *pair;                     /* where to put the matches */
+    unsigned room;                  /* most pairs to put there */
+{
+    unsigned chain_length = s->max_chain_length;
+    Bytef *scan = s->window + str;
+    Bytef *match;
+    uInt best = MIN_MATCH-1;
+    uInt n;
+    unsigned got = 0;
+    uInt nice = (uInt)s->nice_match < len ? (uInt)s->nice_match : len;
+    IPos limit = str > (IPos)MAX_DIST(s) ? str - (IPos)MAX_DIST(s) : NIL;
+    Posf *prev = s->prev;
+    uInt wmask = s->w_mask;
+
+    if (len < MIN_MATCH || room == 0)
+        return 0;
+    while (cur_match > limit && chain_length--) {
+        match = s->window + cur_match;
+        if (match[best] == scan[best] && match[0] == scan[0] &&
+            match[1] == scan[1]) {
+            for (n = 2; n < len && match[n] == scan[n]; n++)
+                ;
+            if (n > best) {
+                if (got == room)
+                    got--;
+                pair[2 * got] = (ush)n;
+                pair[2 * got + 1] = (ush)(str - cur_match);
+                got++;
+                best = n;
+                if (n >= nice)
+                    break;
+            }
+        }
+        cur_match = prev[cur_match & wmask];
+    }
+    return got;
+}
+
+/* ===========================================================================
+ * Parse for the fewest bits, instead of the longest matches. The input is
+ * taken in chunks of up to OPT_CHUNK bytes. All of the matches for each byte
+ * of a chunk are found first, keeping the closest match for each length.
+ * Then the cheapest way through the chunk is found by going forward a byte at
+ * a time, recording the cheapest way to get to each following byte with a
+ * literal or with a match of any length. The costs come from the Huffman
+ * codes that trees.c would build for the symbols of the block so far plus
+ * those of the previous parse of the chunk, so the parse is repeated, up to
+ * good_match times, as long as the result gets better. The best parse is
+ * then added to the block, which is emitted as usual. The symbols are always
+ * standard deflate, so any inflate can decode the result.
+ */
+local block_state deflate_optimal(s, flush)
+    deflate_state *s;
+    int flush;
+{
+    opt_state *o = s->opt;
+    IPos hash_head;         /* head of the hash chain */
+    int bflush = 0;         /* set if current block must be flushed */
+    uInt str;               /* window position of the chunk */
+    uInt n;                 /* length of the chunk */
+    uInt i, j;              /* position in the chunk */
+    uInt length, distance;  /* a match */
+    uInt c, t;              /* costs */
+    uInt total, best;       /* cost of a parse, and of the best parse */
+    uInt run, run_dist;     /* long match that following bytes are inside */
+    unsigned k, got, pool;  /* for match[] */
+    unsigned cur, have;     /* parse[] in progress, and the best one */
+    unsigned sym, syms[2];  /* index in and number of pairs in parse[] */
+    int pass, passes;
+
+    for (;;) {
+        /* Get as much input as will fit in the window, and wait for a full
+         * chunk unless flushing or the window is full. Until the end, leave
+         * MIN_LOOKAHEAD-1 bytes after the chunk, so that there is always
+         * MIN_LOOKAHEAD after a string being matched, and so that the next
+         * fill_window() can slide the window.
+         */
+        if (s->lookahead < MIN_LOOKAHEAD)
+            fill_window(s);
+        else if (s->strm->avail_in &&
+                 s->strstart + s->lookahead < s->window_size)
+            s->lookahead += read_buf(s->strm,
+                                     s->window + s->strstart + s->lookahead,
+                                     (unsigned)(s->window_size -
+                                                s->strstart - s->lookahead));
+        n = s->lookahead;
+        if (flush == Z_NO_FLUSH) {
+            if (n < MIN_LOOKAHEAD ||
+                (n < OPT_CHUNK + MIN_LOOKAHEAD && s->strm->avail_in == 0))
+                return need_more;
+            n -= MIN_LOOKAHEAD-1;
+        }
+        else if (n == 0)
+            break;
+
+        /* Every byte could be a literal, so the chunk must not have more
+         * bytes than there is room left for symbols. Start a new block if the
+         * room is down to a quarter.
+         */
+        if (s->sym_next && s->sym_end - s->sym_next < s->sym_end >> 2)
+            FLUSH_BLOCK(s, 0);
+        if (n > (s->sym_end - s->sym_next) / 3)
+            n = (s->sym_end - s->sym_next) / 3;
+        if (n > OPT_CHUNK)
+            n = OPT_CHUNK;
+        str = s->strstart;
+
+        /* Find the matches for each byte of the chunk. Inside a match that
+         * reaches nice_match, just take the rest of that match.
+         */
+        k = 0;
+        run = 0;
+        run_dist = 0;
+        for (i = 0; i < n; i++) {
+            o->first[i] = k;
+            if (i + MIN_MATCH > s->lookahead)
+                continue;
+            INSERT_STRING(s, str + i, hash_head);
+            if (run > MIN_MATCH) {
+                run--;
+                o->match[k++] = (ush)run;
+                o->match[k++] = (ush)run_dist;
+                continue;
+            }
+            run = 0;
+            if (hash_head == NIL)
+                continue;
+            length = n - i < MAX_MATCH ? n - i : MAX_MATCH;
+            pool = (2*OPT_PAIRS*OPT_CHUNK - k) >> 1;
+            got = opt_matches(s, hash_head, str + i, length, o->match + k,
+                              pool / (n - i));
+            if (got) {
+                k += got << 1;
+                if (o->match[k - 2] >= (uInt)s->nice_match) {
+                    run = o->match[k - 2];
+                    run_dist = o->match[k - 1];
+                }
+            }
+        }
+        o->first[n] = k;
+
+        /* Start with the costs for the block so far, where anything not seen
+         * yet is taken to be as likely as anything seen once.
+         */
+        for (i = 0; i < L_CODES; i++)
+            o->ltree[i].Freq = s->dyn_ltree[i].Freq + 1;
+        for (i = 0; i < D_CODES; i++)
+            o->dtree[i].Freq = s->dyn_dtree[i].Freq + 1;
+        _tr_costs(s, o->ltree, o->dtree, o->lcost, o->dcost);
+
+        passes = s->strategy == Z_FIXED || s->good_match < 1 ? 1 :
+                 s->good_match;
+        best = (uInt)-1;
+        cur = 0;
+        have = 0;
+        for (pass = 0; pass < passes; pass++) {
+            for (length = MIN_MATCH; length <= MAX_MATCH; length++)
+                o->mcost[length] =
+                    o->lcost[_length_code[length - MIN_MATCH] + LITERALS + 1];
+
+            /* Find the cheapest way to each byte of the chunk */
+            o->cost[0] = 0;
+            for (i = 1; i <= n; i++)
+                o->cost[i] = (uInt)-1;
+            for (i = 0; i < n; i++) {
+                c = o->cost[i];
+                t = c + o->lcost[s->window[str + i]];
+                if (t < o->cost[i + 1]) {
+                    o->cost[i + 1] = t;
+                    o->step[i + 1] = 1;
+                    o->dist[i + 1] = 0;
+                }
+                length = MIN_MATCH;
+                for (k = o->first[i]; k < o->first[i + 1]; k += 2) {
+                    distance = o->match[k + 1];
+                    t = c + o->dcost[d_code(distance - 1)];
+                    for (; length <= o->match[k]; length++)
+                        if (t + o->mcost[length] < o->cost[i + length]) {
+                            o->cost[i + length] = t + o->mcost[length];
+                            o->step[i + length] = (ush)length;
+                            o->dist[i + length] = (ush)distance;
+                        }
+                }
+            }
+
+            /* Follow it back, putting the steps at the end of parse[cur] */
+            sym = OPT_CHUNK;
+            for (j = n; j; j -= o->step[j]) {
+                sym--;
+                o->parse[cur][2 * sym] = o->step[j];
+                o->parse[cur][2 * sym + 1] = o->dist[j];
+            }
+            syms[cur] = OPT_CHUNK - sym;
+
+            /* Count its symbols, and get the costs with codes for them */
+            for (i = 0; i < L_CODES; i++)
+                o->ltree[i].Freq = s->dyn_ltree[i].Freq;
+            for (i = 0; i < D_CODES; i++)
+                o->dtree[i].Freq = s->dyn_dtree[i].Freq;
+            o->ltree[LITERALS].Freq++;
+            for (j = 0, k = sym; k < OPT_CHUNK; k++) {
+                length = o->parse[cur][2 * k];
+                distance = o->parse[cur][2 * k + 1];
+                if (distance) {
+                    o->ltree[_length_code[length - MIN_MATCH] + LITERALS + 1]
+                        .Freq++;
+                    o->dtree[d_code(distance - 1)].Freq++;
+                }
+                else
+                    o->ltree[s->window[str + j]].Freq++;
+                j += length;
+            }
+            _tr_costs(s, o->ltree, o->dtree, o->lcost, o->dcost);
+
+            /* Keep this parse if it is the best so far with its own codes,
+             * otherwise further passes are not going to help
+             */
+            total = 0;
+            for (j = 0, k = sym; k < OPT_CHUNK; k++) {
+                length = o->parse[cur][2 * k];
+                distance = o->parse[cur][2 * k + 1];
+                if (distance)
+                    total += o->lcost[_length_code[length - MIN_MATCH] +
+                                      LITERALS + 1] +
+                             o->dcost[d_code(distance - 1)];
+                else
+                    total += o->lcost[s->window[str + j]];
+                j += length;
+            }
+            if (total >= best)
+                break;
+            best = total;
+            have = cur;
+            cur ^= 1;
+        }
+
+        /* Add the best parse to the block */
+        for (k = OPT_CHUNK - syms[have]; k < OPT_CHUNK; k++) {
+            length = o->parse[have][2 * k];
+            distance = o->parse[have][2 * k + 1];
+            if (distance) {
+                check_match(s, s->strstart, s->strstart - distance, length);
+                _tr_tally_dist(s, distance, length - MIN_MATCH, bflush);
+            }
+            else {
+                Tracevv((stderr,"%c", s->window[s->strstart]));
+                _tr_tally_lit(s, s->window[s->strstart], bflush);
+            }
+            s->strstart += length;
+            s->lookahead -= length;
+        }
+        if (bflush) FLUSH_BLOCK(s, 0);
+    }
+    s->insert = s->strstart < MIN_MATCH-1 ? s->strstart : MIN_MATCH-1;
+    if (flush == Z_FINISH) {
+        FLUSH_BLOCK(s, 1);
+        return finish_done;
+    }
+    if (s->sym_next)
+        FLUSH_BLOCK(s, 0);
+    return block_done;
+}
 #endif /* FASTEST */
 
 /* ===========================================================================
@@ -2209,3 +3014,229 @@ local block_state deflate_huff(s, flush)
         FLUSH_BLOCK(s, 0);
     return block_done;
 }
+
+#define QUICK_MIN 4
+/* Shortest match deflate_quick() will emit. A three-byte match coded with the
+ * static trees often takes more bits than the three literals would.
+ */
+
+/* ===========================================================================
+ * Return the length of the match between the strings at scan and match, up to
+ * MAX_MATCH, or a length less than MIN_MATCH if they differ in the first
+ * MIN_MATCH bytes.
+ */
+local unsigned quick_match OF((deflate_state *s, Bytef *scan, Bytef *match));
+local unsigned quick_match(s, scan, match)
+    deflate_state *s;
+    Bytef *scan;
+    Bytef *match;
+{
+#ifdef SIMD_MATCH
+    if (scan[0] != match[0] || scan[1] != match[1] || scan[2] != match[2] ||
+        scan[3] != match[3])
+        return 0;
+    return 2 + s->compare(scan + 2, match + 2);
+#else
+    Bytef *strend = scan + MAX_MATCH;
+
+    (void)s;
+    if (scan[0] != match[0] || scan[1] != match[1] || scan[2] != match[2] ||
+        scan[3] != match[3])
+        return 0;
+    scan += 2, match += 2;
+    do {
+    } while (*++scan == *++match && *++scan == *++match &&
+             *++scan == *++match && *++scan == *++match &&
+             *++scan == *++match && *++scan == *++match &&
+             *++scan == *++match && *++scan == *++match &&
+             scan < strend);
+    return MAX_MATCH - (unsigned)(strend - scan);
+#endif
+}
+
+/* ===========================================================================
+ * Send a code of len bits for quick_run(), writing out half of the bit buffer
+ * once it is at least half full. So there are fewer than Buf_size/2 bits in
+ * bits between codes, and len can be up to Buf_size/2.
+ */
+#if Buf_size == 64
+#  define QUICK_PUT() \
+    (put[0] = (uch)bits, put[1] = (uch)(bits >> 8), \
+     put[2] = (uch)(bits >> 16), put[3] = (uch)(bits >> 24))
+#else
+#  define QUICK_PUT() (put[0] = (uch)bits, put[1] = (uch)(bits >> 8))
+#endif
+#define QUICK_SEND(val, len) \
+    { bits |= (bi_t)(val) << n; \
+      n += (int)(len); \
+      if (n >= (int)Buf_size/2) { \
+          QUICK_PUT(); \
+          put += Buf_size >> 4; \
+          bits >>= Buf_size/2; \
+          n -= (int)Buf_size/2; \
+      } \
+    }
+
+/* ===========================================================================
+ * Send literals and matches coded with the static trees for deflate_quick()
+ * until more input is needed or pending_buf is nearly full. Return true if it
+ * is nearly full. The state and the bit buffer are copied to local variables,
+ * since otherwise the compiler has to assume that every byte written to
+ * pending_buf could change them. The codes and extra bits are looked up
+ * together in the _quick_* tables.
+ *
+ * The hash key of each string is computed from scratch from its first four
+ * bytes, with crc_hash() or else QUICK_KEY(), so that strings can be skipped.
+ * deflateSetDictionary() and fill_window() insert strings with the same key
+ * when the strategy is Z_QUICK.
+ */
+local int quick_run OF((deflate_state *s));
+local int quick_run(s)
+    deflate_state *s;
+{
+    Bytef *window = s->window;
+    Posf *head = s->head;
+#ifndef FASTEST
+    Posf *prev = s->prev;
+    uInt wmask = s->w_mask;
+#endif
+#ifdef USE_CRC_HASH
+    int crc = s->crc_hash;
+    uInt mask = s->hash_mask;
+#endif
+    uInt max_dist = MAX_DIST(s);
+    bi_t bits = s->bi_buf;                  /* local bit buffer */
+    int n = s->bi_valid;                    /* number of bits in bits */
+    uchf *put = s->pending_buf + s->pending;    /* where to write bits */
+    uchf *full = s->pending_buf + s->pending_buf_size - 16;
+                                            /* room for a symbol and an end */
+    uInt str = s->strstart;                 /* string to look for */
+    uInt more = s->lookahead;               /* bytes from str on */
+    uInt stop;                              /* first str to leave for later */
+    uInt h;                                 /* hash key of str */
+    IPos cur = NIL;                         /* earlier string with key h */
+    unsigned dist = 0, len;                 /* match distance and length */
+    ulg v, w;                               /* entries from _quick_* tables */
+
+    /* Stop where the lookahead falls below MIN_LOOKAHEAD, or at the end of
+     * the input, and in either case before the window must be slid, since
+     * the match comparison can read MAX_MATCH bytes past str. */
+    stop = str + (more < MIN_LOOKAHEAD ? more : more - (MIN_LOOKAHEAD - 1));
+    if (stop > (uInt)s->window_size - (MIN_LOOKAHEAD - 1))
+        stop = (uInt)s->window_size - (MIN_LOOKAHEAD - 1);
+    while (n >= (int)Buf_size/2) {
+        QUICK_PUT();
+        put += Buf_size >> 4;
+        bits >>= Buf_size/2;
+        n -= (int)Buf_size/2;
+    }
+    do {
+        len = 0;
+        if (more >= QUICK_MIN) {
+#ifdef USE_CRC_HASH
+            if (crc)
+                h = crc_hash(window + str) & mask;
+            else
+#endif
+            h = QUICK_KEY(s, window + str);
+            cur = head[h];
+#ifndef FASTEST
+            prev[str & wmask] = (Pos)cur;
+#endif
+            head[h] = (Pos)str;
+            dist = str - cur;
+            if (cur != NIL && dist <= max_dist) {
+                len = quick_match(s, window + str, window + cur);
+                if (len > more)
+                    len = more;
+            }
+        }
+        if (len >= QUICK_MIN) {
+            check_match(s, str, cur, len);
+            v = _quick_len[len - MIN_MATCH];
+            dist--;
+            w = _quick_dist[dist < 256 ? dist : 256 + (dist >> 7)];
+#if Buf_size == 64
+            QUICK_SEND((v >> 4) | (((w & 31) | ((dist - (w >> 9)) << 5)) <<
+                                   (v & 15)),
+                       (v & 15) + 5 + ((w >> 5) & 15));
+#else
+            QUICK_SEND(v >> 4, v & 15);
+            QUICK_SEND(w & 31, 5);
+            QUICK_SEND(dist - (w >> 9), (w >> 5) & 15);
+#endif
+            str += len;
+            more -= len;
+        } else {
+            Tracevv((stderr,"%c", window[str]));
+            v = _quick_lit[window[str]];
+            QUICK_SEND(v >> 4, v & 15);
+            str++;
+            more--;
+        }
+    } while (str < stop && put < full);
+#ifdef ZLIB_DEBUG
+    s->bits_sent += ((ulg)(put - s->pending_buf - s->pending) << 3) + n -
+                    s->bi_valid;
+#endif
+    s->pending = (ulg)(put - s->pending_buf);
+    s->bi_buf = bits;
+    s->bi_valid = n;
+    s->strstart = str;
+    s->lookahead = more;
+    return put >= full;
+}
+
+/* ===========================================================================
+ * For Z_QUICK, look for a match only at the most recent string with the same
+ * hash key, insert only the strings at which a match is looked for, and send
+ * the literals and matches coded with the static trees straight to
+ * pending_buf, with no symbol buffer, frequency counting, tree construction
+ * or choice of block type. The block is only ended when flushing, so it can
+ * span many fillings of pending_buf and many calls of deflate(), as
+ * s->block_open says. This trades a good deal of compression for speed.
+ */
+local block_state deflate_quick(s, flush)
+    deflate_state *s;
+    int flush;
+{
+    int last = flush == Z_FINISH;
+
+    if (last && s->block_open != 2) {
+        /* the rest of the stream goes in a last block */
+        if (s->block_open)
+            _tr_quick_end(s, 0);
+        _tr_quick_start(s, 1);
+        s->block_open = 2;
+    }
+    for (;;) {
+        /* Make sure that we always have enough lookahead, except
+         * at the end of the input file, as in deflate_fast().
+         */
+        if (s->lookahead < MIN_LOOKAHEAD) {
+            fill_window(s);
+            if (s->lookahead < MIN_LOOKAHEAD && flush == Z_NO_FLUSH)
+                return need_more;
+            if (s->lookahead == 0) break; /* end the current block */
+        }
+        if (s->block_open == 0) {
+            _tr_quick_start(s, 0);
+            s->block_open = 1;
+        }
+        if (quick_run(s)) {
+            flush_pending(s->strm);
+            if (s->strm->avail_out == 0)
+                return need_more;
+        }
+    }
+    s->insert = s->strstart < MIN_MATCH-1 ? s->strstart : MIN_MATCH-1;
+    if (s->block_open) {
+        _tr_quick_end(s, last);
+        s->block_open = 0;
+        s->block_start = s->strstart;
+        flush_pending(s->strm);
+        if (s->strm->avail_out == 0)
+            return last ? finish_started : need_more;
+    }
+    return last ? finish_done : block_done;
+}
@@ -23,6 +23,16 @@
 #  define GZIP
 #endif
 
+/* USE_CRC_HASH, from zutil.h, has deflate compute its hash keys from four
+   bytes with the CRC-32C instruction, on processors that have one. This finds
+   different matches than the usual three-byte rolling hash, so the compressed
+   output then depends on the processor it was made on. */
+#ifdef USE_CRC_HASH
+#  define WIN_PAD 1     /* byte pairs past the window for crc_hash() reads */
+#else
+#  define WIN_PAD 0
+#endif
+
 /* ===========================================================================
  * Internal compression state.
  */
@@ -48,8 +58,14 @@
 #define MAX_BITS 15
 /* All codes must not exceed MAX_BITS bits */
 
-#define Buf_size 16
-/* size of bit buffer in bi_buf */
+#ifdef Z_U8
+   typedef Z_U8 bi_t;
+#  define Buf_size 64
+#else
+   typedef ulg bi_t;
+#  define Buf_size 32
+#endif
+/* type and size of bit buffer in bi_buf */
 
 #define INIT_STATE    42    /* zlib header -> BUSY_STATE */
 #ifdef GZIP
@@ -177,19 +193,22 @@ typedef struct internal_state {
     uInt max_lazy_match;
     /* Attempt to find a better match only when the current match is strictly
      * smaller than this value. This mechanism is used only for compression
-     * levels >= 4.
+     * levels >= 7.
      */
 #   define max_insert_length  max_lazy_match
     /* Insert new strings in the hash table only if the match length is not
      * greater than this length. This saves time but degrades compression.
-     * max_insert_length is used only for compression levels <= 3.
+     * max_insert_length is used only for compression levels <= 6.
      */
 
     int level;    /* compression level (1..9) */
     int strategy; /* favor or force Huffman coding*/
 
     uInt good_match;
-    /* Use a faster search when the previous match is longer than this */
+    /* Use a faster search when the previous match is longer than this. For
+     * levels 3 to 6, look for a longer match at the next byte only when the
+     * current match is shorter than this.
+     */
 
     int nice_match; /* Stop searching when current match exceeds this */
 
@@ -252,9 +271,9 @@ typedef struct internal_state {
     ulg bits_sent;      /* bit length of compressed data sent mod 2^32 */
 #endif
 
-    ush bi_buf;
+    bi_t bi_buf;
     /* Output buffer. bits are inserted starting at the bottom (least
-     * significant bits).
+     * significant bits), and written out Buf_size bits at a time.
      */
     int bi_valid;
     /* Number of valid bits in bi_buf.  All bits above the last valid bit
@@ -268,6 +287,37 @@ typedef struct internal_state {
      * updated to the new high water mark.
      */
 
+    void (*slide) OF((Posf *table, unsigned n, uInt wsize));
+    /* Slide one of the hash tables down by wsize: slide_hash_c() or the
+     * fastest vectorized equivalent for this processor.
+     */
+
+#if defined(Z_X86_SIMD) || defined(Z_ARM_SIMD)
+    unsigned (*compare) OF((const Bytef *scan, const Bytef *match));
+    /* Return the number of leading bytes that are equal in the two 256-byte
+     * strings, using the widest vector instructions this processor has.
+     */
+#endif
+
+#ifdef USE_CRC_HASH
+    int crc_hash;
+    /* True if hash keys are computed by crc_hash() instead of UPDATE_HASH() */
+#endif
+
+    int block_open;
+    /* Whether deflate_quick() has a static block open in the bit buffer: 0 if
+     * not, 1 if so, or 2 if it is the last block of the stream.
+     */
+
+    struct opt_state_s FAR *opt;
+    /* Work space for deflate_optimal(), allocated only for levels above 9 */
+
+    int split;
+    /* Most blocks to split a flushed block into, set by deflateSplit() */
+
+    ushf *split_freq;
+    /* Running symbol counts for split_block(), allocated if split > 1 */
+
 } FAR deflate_state;
 
 /* Output a byte on the stream.
@@ -290,6 +340,20 @@ typedef struct internal_state {
 /* Number of bytes after end of data in window to initialize in order to avoid
    memory checker errors from longest match routines */
 
+#define SPLIT_SEGS 16
+/* Most blocks that deflateSplit() can cut one flushed block into, and the
+ * number of pieces the block is cut into to look for the boundaries.
+ */
+
+#define SPLIT_MIN 2048
+/* Fewest symbols in a block for it to be considered for splitting */
+
+#define SPLIT_GAIN 6
+/* A block is split only if that saves more than 2^-SPLIT_GAIN of its size */
+
+#define SPLIT_TREES 40
+/* Estimated bits for the trees of a block, plus four for each code used */
+
         /* in trees.c */
 void ZLIB_INTERNAL _tr_init OF((deflate_state *s));
 int ZLIB_INTERNAL _tr_tally OF((deflate_state *s, unsigned dist, unsigned lc));
@@ -299,6 +363,10 @@ void ZLIB_INTERNAL _tr_flush_bits OF((deflate_state *s));
 void ZLIB_INTERNAL _tr_align OF((deflate_state *s));
 void ZLIB_INTERNAL _tr_stored_block OF((deflate_state *s, charf *buf,
                         ulg stored_len, int last));
+void ZLIB_INTERNAL _tr_quick_start OF((deflate_state *s, int last));
+void ZLIB_INTERNAL _tr_quick_end OF((deflate_state *s, int last));
+void ZLIB_INTERNAL _tr_costs OF((deflate_state *s, ct_data *ltree,
+                        ct_data *dtree, uchf *lcost, uchf *dcost));
 
 #define d_code(dist) \
    ((dist) < 256 ? _dist_code[dist] : _dist_code[256+((dist)>>7)])
@@ -307,17 +375,23 @@ void ZLIB_INTERNAL _tr_stored_block OF((deflate_state *s, charf *buf,
  * used.
  */
 
-#ifndef ZLIB_DEBUG
-/* Inline versions of _tr_tally for speed: */
-
 #if defined(GEN_TREES_H) || !defined(STDC)
   extern uch ZLIB_INTERNAL _length_code[];
   extern uch ZLIB_INTERNAL _dist_code[];
+  extern ulg ZLIB_INTERNAL _quick_lit[];
+  extern ulg ZLIB_INTERNAL _quick_len[];
+  extern ulg ZLIB_INTERNAL _quick_dist[];
 #else
   extern const uch ZLIB_INTERNAL _length_code[];
   extern const uch ZLIB_INTERNAL _dist_code[];
+  extern const ulg ZLIB_INTERNAL _quick_lit[];
+  extern const ulg ZLIB_INTERNAL _quick_len[];
+  extern const ulg ZLIB_INTERNAL _quick_dist[];
 #endif
 
+#ifndef ZLIB_DEBUG
+/* Inline versions of _tr_tally for speed: */
+
 # define _tr_tally_lit(s, c, flush) \
   { uch cc = (c); \
     s->sym_buf[s->sym_next++] = 0; \
@@ -165,6 +165,7 @@
 #define LOOK 0      /* look for a gzip header */
 #define COPY 1      /* copy input directly */
 #define GZIP 2      /* decompress a gzip stream */
+#define PAR 3       /* deliver gzip streams decompressed in parallel */
 
 /* internal gzip file state data structure */
 typedef struct {
@@ -183,10 +184,13 @@ typedef struct {
     unsigned char *out;     /* output buffer (double-sized when reading) */
     int direct;             /* 0 if processing gzip, 1 if transparent */
         /* just for reading */
-    int how;                /* 0: get header, 1: copy, 2: decompress */
+    int how;                /* 0: get header, 1: copy, 2: decompress, */
+                            /* 3: deliver parallel decompression */
     z_off64_t start;        /* where the gzip data started, for rewinding */
     int eof;                /* true if end of input file reached */
     int past;               /* true if read requested past end */
+    int threads;            /* requested threads, 1 for no parallel reading */
+    struct gz_par_s *par;   /* parallel reading state, or NULL */
         /* just for writing */
     int level;              /* compression level */
     int strategy;           /* compression strategy */
@@ -115,6 +115,8 @@ local gzFile gz_open(path, fd, mode)
         return NULL;
     state->size = 0;            /* no buffers allocated yet */
     state->want = GZBUFSIZE;    /* requested buffer size */
+    state->threads = 1;         /* no parallel reading */
+    state->par = NULL;          /* no parallel reading state yet */
     state->msg = NULL;          /* no error message yet */
 
     /* interpret mode */
@@ -165,6 +167,9 @@ local gzFile gz_open(path, fd, mode)
             case 'F':
                 state->strategy = Z_FIXED;
                 break;
+            case 'Q':
+                state->strategy = Z_QUICK;
+                break;
             case 'T':
                 state->direct = 1;
                 break;
@@ -341,6 +346,29 @@ int ZEXPORT gzbuffer(file, size)
     return 0;
 }
 
+/* -- see zlib.h -- */
+int ZEXPORT gzthreads(file, threads)
+    gzFile file;
+    int threads;
+{
+    gz_statep state;
+
+    /* get internal structure and check integrity */
+    if (file == NULL)
+        return -1;
+    state = (gz_statep)file;
+    if (state->mode != GZ_READ)
+        return -1;
+
+    /* make sure we haven't already allocated memory */
+    if (state->size != 0)
+        return -1;
+
+    /* set requested threads */
+    state->threads = threads;
+    return 0;
+}
+
 /* -- see zlib.h -- */
 int ZEXPORT gzrewind(file)
     gzFile file;
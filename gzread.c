@@ -4,12 +4,19 @@
  */
 
 #include "gzguts.h"
+#include "zthread.h"
 
 /* Local functions */
 local int gz_load OF((gz_statep, unsigned char *, unsigned, unsigned *));
 local int gz_avail OF((gz_statep));
+local int gz_par_head OF((const unsigned char *, z_size_t));
+local void gz_par_part OF((struct gz_par_s *, unsigned));
+local void gz_par_work OF((voidpf));
+local int gz_par_round OF((gz_statep));
 local int gz_look OF((gz_statep));
 local int gz_decomp OF((gz_statep));
+local int gz_par_fetch OF((gz_statep));
+local void gz_par_free OF((gz_statep));
 local int gz_fetch OF((gz_statep));
 local int gz_skip OF((gz_statep, z_off64_t));
 local z_size_t gz_read OF((gz_statep, voidp, z_size_t));
@@ -79,6 +86,288 @@ local int gz_avail(state)
     return 0;
 }
 
+/* Parallel reading, used when gzthreads() asks for more than one thread. When
+   a gzip member starts, gz_par_round() loads up to GZ_PAR_SPAN compressed
+   bytes per thread, cuts them into equal parts, and runs one task per part.
+   Each task after the first looks for the first gzip header at or after the
+   start of its part. Each task then decompresses whole members in turn until
+   the next member starts in the next part, which should be where the task
+   for that part started. The parts that follow each other that way from the
+   first are delivered in order by gz_par_fetch(), and the next round starts
+   where the last of them stopped. A wrong guess at a header only costs time,
+   since a task stops at a member that does not decompress, and inflate()
+   checks the trailer of every member.
+
+   The first task uses state->strm. If its first member does not complete,
+   for lack of input or of room for the output, then it is finished as usual
+   with gz_decomp() once the output so far has been delivered. */
+
+#define GZ_PAR_SPAN 1048576UL   /* compressed bytes loaded per thread */
+#define GZ_PAR_OUT (32 * GZ_PAR_SPAN)   /* most output per part */
+#define GZ_PAR_NONE ((z_size_t)-1)      /* no member found */
+
+/* The members decompressed by one task in a round. */
+typedef struct {
+    z_size_t start;         /* offset of the first member, or GZ_PAR_NONE */
+    z_size_t stop;          /* offset of the first member not decompressed */
+    unsigned char *out;     /* decompressed members */
+    z_size_t size;          /* allocated bytes at out */
+    z_size_t have;          /* decompressed bytes at out */
+    int init;               /* true if strm has been initialized */
+    z_stream strm;          /* inflate stream, unused for the first part */
+} gz_part;
+
+/* Parallel reading state. task may only be used while holding the lock, and
+   each part only by the one thread that took its task. */
+struct gz_par_s {
+    gz_statep state;        /* the file, for the first part's stream */
+    int threads;            /* most threads to use */
+    unsigned char *in;      /* compressed data for the round */
+    z_size_t size;          /* allocated bytes at in */
+    z_size_t have;          /* loaded bytes at in */
+    gz_part *part;          /* threads parts */
+    unsigned parts;         /* parts in this round */
+    z_size_t piece;         /* length of all but the last part */
+    unsigned links;         /* parts that follow each other from the first */
+    int finish;             /* true to finish a member with gz_decomp() */
+    int err;                /* inflate() error for that member, or Z_OK */
+    z_size_t stop;          /* offset in in to continue from after the round */
+    unsigned link;          /* part being delivered */
+    z_size_t next;          /* offset of the next output in that part */
+    z_lock lock;
+    unsigned task;          /* next part to decompress */
+};
+
+/* Return true if buf[0..len-1] starts with what could be a gzip header,
+   followed by a deflate block header that is not invalid. */
+local int gz_par_head(buf, len)
+    const unsigned char *buf;
+    z_size_t len;
+{
+    z_size_t n;
+    unsigned flags;
+
+    if (len < 10 || buf[0] != 31 || buf[1] != 139 || buf[2] != 8 ||
+            (buf[3] & 0xe0))
+        return 0;
+    flags = buf[3];
+    n = 10;
+    if (flags & 4) {                    /* extra field */
+        if (len - n < 2)
+            return 0;
+        n += 2 + buf[n] + ((z_size_t)buf[n + 1] << 8);
+    }
+    if (flags & 8) {                    /* file name */
+        while (n < len && buf[n])
+            n++;
+        n++;
+    }
+    if (flags & 16) {                   /* comment */
+        while (n < len && buf[n])
+            n++;
+        n++;
+    }
+    if (flags & 2) {                    /* header crc */
+        if (n >= len || len - n < 2 ||
+                (crc32_z(0L, buf, n) & 0xffff) !=
+                (buf[n] + ((unsigned)buf[n + 1] << 8)))
+            return 0;
+        n += 2;
+    }
+    return n < len && (buf[n] & 6) != 6;
+}
+
+/* Decompress the members of part k of the round. */
+local void gz_par_part(par, k)
+    struct gz_par_s *par;
+    unsigned k;
+{
+    gz_part *part = par->part + k;
+    z_streamp strm;
+    unsigned char *in = par->in, *out;
+    z_size_t have = par->have, pos, limit, mark, size;
+    int ret, first = 1;
+
+    /* start at the start for the first part, otherwise at the first header
+       at or after the start of the part */
+    part->have = 0;
+    if (k == 0) {
+        strm = &(par->state->strm);
+        pos = 0;
+    }
+    else {
+        strm = &(part->strm);
+        for (pos = k * par->piece; pos < have; pos++) {
+            out = (unsigned char *)memchr(in + pos, 31, have - pos);
+            if (out == NULL) {
+                pos = have;
+                break;
+            }
+            pos = (z_size_t)(out - in);
+            if (gz_par_head(in + pos, have - pos))
+                break;
+        }
+        if (pos < have && !part->init) {
+            strm->zalloc = Z_NULL;
+            strm->zfree = Z_NULL;
+            strm->opaque = Z_NULL;
+            strm->avail_in = 0;
+            strm->next_in = Z_NULL;
+            part->init = inflateInit2(strm, 15 + 16) == Z_OK;
+        }
+        if (pos == have || !part->init) {
+            part->start = part->stop = GZ_PAR_NONE;
+            return;
+        }
+    }
+    part->start = pos;
+
+    /* decompress whole members that start in this part */
+    limit = k == par->parts - 1 ? have : (k + 1) * par->piece;
+    while (pos < limit && have - pos >= 2 && in[pos] == 31 &&
+           in[pos + 1] == 139) {
+        inflateReset(strm);
+        strm->next_in = in + pos;
+        strm->avail_in = (uInt)(have - pos);
+        mark = part->have;
+        do {
+            if (part->have == part->size) {     /* need more room */
+                size = part->size ? part->size << 1 : GZ_PAR_SPAN << 2;
+                out = size > GZ_PAR_OUT ? NULL :
+                      (unsigned char *)realloc(part->out, size);
+                if (out == NULL) {
+                    ret = Z_BUF_ERROR;
+                    break;
+                }
+                part->out = out;
+                part->size = size;
+            }
+            strm->next_out = part->out + part->have;
+            strm->avail_out = (uInt)(part->size - part->have);
+            ret = inflate(strm, Z_NO_FLUSH);
+            part->have = part->size - strm->avail_out;
+        } while (ret == Z_OK);
+        if (ret != Z_STREAM_END) {
+            if (k == 0 && first) {
+                /* keep the output, and finish the member later */
+                par->finish = 1;
+                par->err = ret == Z_BUF_ERROR ? Z_OK : ret;
+                par->stop = (z_size_t)(strm->next_in - in);
+            }
+            else
+                part->have = mark;
+            break;
+        }
+        pos = (z_size_t)(strm->next_in - in);
+        first = 0;
+    }
+    part->stop = pos;
+}
+
+/* Decompress parts until there are none left. This is run by each of the
+   threads. */
+local void gz_par_work(arg)
+    voidpf arg;
+{
+    struct gz_par_s *par = (struct gz_par_s *)arg;
+    unsigned k;
+
+    z_acquire(&par->lock);
+    while (par->task < par->parts) {
+        k = par->task++;
+        z_release(&par->lock);
+        gz_par_part(par, k);
+        z_acquire(&par->lock);
+    }
+    z_release(&par->lock);
+}
+
+/* Decompress the gzip members at strm->next_in that are in the next
+   state->threads times GZ_PAR_SPAN bytes of input on several threads, and
+   set state->how to PAR to deliver them. state->how is left as GZIP if there
+   is not enough input for more than one thread, if parallel reading could not
+   be set up, or if there is only one thread after all. Return -1 on error,
+   otherwise 0. */
+local int gz_par_round(state)
+    gz_statep state;
+{
+    z_streamp strm = &(state->strm);
+    struct gz_par_s *par = state->par;
+    unsigned got, k;
+    int threads;
+
+    /* set up parallel reading the first time */
+    if (par == NULL) {
+        threads = z_threads(state->threads);
+        par = threads == 1 ? NULL :
+              (struct gz_par_s *)malloc(sizeof(struct gz_par_s));
+        if (par != NULL) {
+            par->state = state;
+            par->threads = threads;
+            par->size = (z_size_t)threads * GZ_PAR_SPAN;
+            if (par->size < state->size)
+                par->size = state->size;
+            par->in = (unsigned char *)malloc(par->size);
+            par->part = (gz_part *)calloc((size_t)threads, sizeof(gz_part));
+            if (par->in == NULL || par->part == NULL ||
+                    z_lock_init(&par->lock)) {
+                free(par->part);
+                free(par->in);
+                free(par);
+                par = NULL;
+            }
+        }
+        if (par == NULL) {
+            state->threads = 1;         /* read with one thread from now on */
+            return 0;
+        }
+        state->par = par;
+    }
+
+    /* move the input to the start, and fill the rest */
+    if (strm->avail_in)
+        memmove(par->in, strm->next_in, strm->avail_in);
+    par->have = strm->avail_in;
+    strm->next_in = par->in;
+    if (state->eof == 0) {
+        if (gz_load(state, par->in + par->have,
+                    (unsigned)(par->size - par->have), &got) == -1)
+            return -1;
+        par->have += got;
+    }
+    strm->avail_in = (uInt)par->have;
+
+    /* cut the input into parts */
+    par->parts = (unsigned)((par->have - 1) / GZ_PAR_SPAN + 1);
+    if (par->parts > (unsigned)par->threads)
+        par->parts = (unsigned)par->threads;
+    if (par->parts < 2)
+        return 0;
+    par->piece = par->have / par->parts;
+
+    /* decompress the parts */
+    par->finish = 0;
+    par->err = Z_OK;
+    par->task = 0;
+    z_run((int)par->parts, gz_par_work, par);
+
+    /* find the parts that follow each other from the first, and keep the
+       whole input available until they have been delivered, so that the end
+       of the input is not taken to be reached too soon */
+    for (k = 1; !par->finish && k < par->parts &&
+                par->part[k].start == par->part[k - 1].stop; k++)
+        ;
+    par->links = k;
+    if (!par->finish)
+        par->stop = par->part[k - 1].stop;
+    strm->next_in = par->in;
+    strm->avail_in = (uInt)par->have;
+    par->link = 0;
+    par->next = 0;
+    state->how = PAR;
+    return 0;
+}
+
 /* Look for gzip header, set up for inflate or copy.  state->x.have must be 0.
    If this is the first time in, allocate required memory.  state->how will be
    left unchanged if there is no more input data available, will be set to COPY
@@ -141,6 +430,8 @@ local int gz_look(state)
         inflateReset(strm);
         state->how = GZIP;
         state->direct = 0;
+        if (state->threads != 1)
+            return gz_par_round(state);
         return 0;
     }
 
@@ -220,6 +511,83 @@ local int gz_decomp(state)
     return 0;
 }
 
+/* Copy the next output of a parallel round to the output buffer. Once it
+   has all been delivered, set state->how to LOOK for the next member, or to
+   GZIP to finish the member that the round stopped in, with strm->next_in
+   and strm->avail_in where to continue. Returns -1 on error, otherwise 0. */
+local int gz_par_fetch(state)
+    gz_statep state;
+{
+    struct gz_par_s *par = state->par;
+    z_streamp strm = &(state->strm);
+    gz_part *part;
+    z_size_t n;
+
+    /* copy from the next part with output left */
+    while (par->link < par->links) {
+        part = par->part + par->link;
+        if (par->next < part->have) {
+            n = part->have - par->next;
+            if (n > state->size << 1)
+                n = state->size << 1;
+            memcpy(state->out, part->out + par->next, n);
+            par->next += n;
+            state->x.next = state->out;
+            state->x.have = (unsigned)n;
+            return 0;
+        }
+        par->link++;
+        par->next = 0;
+    }
+
+    /* all delivered -- continue with the input after the round */
+    strm->next_in = par->in + par->stop;
+    strm->avail_in = (uInt)(par->have - par->stop);
+    if (!par->finish) {
+        state->how = LOOK;
+        return 0;
+    }
+    if (par->err == Z_STREAM_ERROR || par->err == Z_NEED_DICT) {
+        gz_error(state, Z_STREAM_ERROR,
+                 "internal error: inflate stream corrupt");
+        return -1;
+    }
+    if (par->err == Z_MEM_ERROR) {
+        gz_error(state, Z_MEM_ERROR, "out of memory");
+        return -1;
+    }
+    if (par->err == Z_DATA_ERROR) {             /* deflate stream invalid */
+        gz_error(state, Z_DATA_ERROR,
+                 strm->msg == NULL ? "compressed data error" : strm->msg);
+        return -1;
+    }
+    state->how = GZIP;
+    if (state->eof && strm->avail_in == 0)
+        gz_error(state, Z_BUF_ERROR, "unexpected end of file");
+    return 0;
+}
+
+/* Free the parallel reading state. */
+local void gz_par_free(state)
+    gz_statep state;
+{
+    struct gz_par_s *par = state->par;
+    int k;
+
+    if (par == NULL)
+        return;
+    for (k = 0; k < par->threads; k++) {
+        if (par->part[k].init)
+            inflateEnd(&(par->part[k].strm));
+        free(par->part[k].out);
+    }
+    z_lock_free(&par->lock);
+    free(par->part);
+    free(par->in);
+    free(par);
+    state->par = NULL;
+}
+
 /* Fetch data and put it in the output buffer.  Assumes state->x.have is 0.
    Data is either copied from the input file or decompressed from the input
    file depending on state->how.  If state->how is LOOK, then a gzip header is
@@ -250,6 +618,10 @@ local int gz_fetch(state)
             strm->next_out = state->out;
             if (gz_decomp(state) == -1)
                 return -1;
+            break;
+        case PAR:       /* -> PAR, LOOK, or GZIP (to finish a member) */
+            if (gz_par_fetch(state) == -1)
+                return -1;
         }
     } while (state->x.have == 0 && (!state->eof || strm->avail_in));
     return 0;
@@ -335,7 +707,8 @@ local z_size_t gz_read(state, buf, len)
 
         /* need output data -- for small len or new stream load up our output
            buffer */
-        else if (state->how == LOOK || n < (state->size << 1)) {
+        else if (state->how == LOOK || state->how == PAR ||
+                 n < (state->size << 1)) {
             /* get more output, looking for header if required */
             if (gz_fetch(state) == -1)
                 return 0;
@@ -639,6 +1012,7 @@ int ZEXPORT gzclose_r(file)
 
     /* free memory and close file */
     if (state->size) {
+        gz_par_free(state);
         inflateEnd(&(state->strm));
         free(state->out);
         free(state->in);
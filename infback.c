@@ -66,6 +66,12 @@ int stream_size;
     state->window = window;
     state->wnext = 0;
     state->whave = 0;
+    state->chk = Z_NULL;
+    state->exact = 1;
+#ifdef INFLATE_MULTISYM
+    state->lencode = Z_NULL;
+    state->pairsok = 0;
+#endif
     return Z_OK;
 }
 
@@ -116,6 +122,10 @@ struct inflate_state FAR *state;
 #else /* !BUILDFIXED */
 #   include "inffixed.h"
 #endif /* BUILDFIXED */
+#ifdef INFLATE_MULTISYM
+    if (state->lencode != lenfix)
+        state->pairsok = 0;
+#endif
     state->lencode = lenfix;
     state->lenbits = 9;
     state->distcode = distfix;
@@ -459,6 +469,9 @@ void FAR *out_desc;
             state->next = state->codes;
             state->lencode = (code const FAR *)(state->next);
             state->lenbits = 9;
+#ifdef INFLATE_MULTISYM
+            state->pairsok = 0;
+#endif
             ret = inflate_table(LENS, state->lens, state->nlen, &(state->next),
                                 &(state->lenbits), state->work);
             if (ret) {
@@ -481,7 +494,8 @@ void FAR *out_desc;
 
         case LEN:
             /* use inflate_fast() if we have enough input and output */
-            if (have >= 6 && left >= 258) {
+            if (have >= INFLATE_FAST_MIN_HAVE &&
+                left >= INFLATE_FAST_MIN_LEFT) {
                 RESTORE();
                 if (state->whave < state->wsize)
                     state->whave = state->wsize - left;
@@ -0,0 +1,701 @@
+/* infbuf.c -- decompress a memory buffer in one call
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/*
+   inflateBuffer() decompresses a stream that is all in memory to an output
+   buffer that is all in memory. inflate() can do that too, but it is built
+   to stop and resume anywhere in the input or output, so it decodes headers
+   and code lengths a bit at a time through its state machine, keeps a
+   sliding window unless told otherwise, and leaves the last symbols before
+   the end of its output buffer to its slow loop. Here the headers and code
+   lengths are decoded straight from the input, and there is no window,
+   since matches are copied from the output itself. inflate_fast() decodes
+   each block until there is too little output left for it, and then goes
+   on in a small buffer that has room, with the output as its window. Only
+   the last few bytes of input are left to a loop that checks for the ends
+   at every step. Data that does not decode in full is decoded again with
+   inflate(), so that errors are reported just as uncompress2() always has.
+ */
+
+#include "zutil.h"
+#include "inftrees.h"
+#include "inflate.h"
+#include "inffast.h"
+#include "inffixed.h"
+
+/* Bit buffer, at least 32 bits */
+#ifdef Z_U8
+   typedef Z_U8 ib_bits;
+#  define IB_FILL 56
+#else
+   typedef unsigned long ib_bits;
+#  define IB_FILL 24
+#endif
+
+/* Position in the input and output. The input is read a byte at a time into
+   hold, and a lack of input is an error. */
+typedef struct {
+    z_const unsigned char FAR *next;    /* next input byte */
+    z_const unsigned char FAR *last;    /* end of the input */
+    ib_bits hold;                       /* bit buffer */
+    unsigned bits;                      /* bits in hold */
+    unsigned char FAR *dest;            /* start of the output */
+    unsigned char FAR *put;             /* next output byte */
+    unsigned char FAR *end;             /* end of the output */
+} ib_pos;
+
+#define IB_PULL() \
+    do { \
+        if (p->next == p->last) \
+            return Z_DATA_ERROR; \
+        p->hold += (ib_bits)(*p->next++) << p->bits; \
+        p->bits += 8; \
+    } while (0)
+#define IB_NEED(n) \
+    do { \
+        while (p->bits < (unsigned)(n)) \
+            IB_PULL(); \
+    } while (0)
+#define IB_BITS(n) ((unsigned)p->hold & ((1U << (n)) - 1))
+#define IB_DROP(n) \
+    do { \
+        p->hold >>= (n); \
+        p->bits -= (unsigned)(n); \
+    } while (0)
+
+/* ===========================================================================
+ * Decode the zlib or gzip header at the input, as state->wrap permits, for a
+ * window of up to 1 << state->wbits bytes (zero for what the header says).
+ * Set state->wrap to what was found and state->flags for the check to use.
+ * Return Z_OK, or Z_DATA_ERROR if the header is invalid or incomplete,
+ * including a zlib header that asks for a dictionary.
+ */
+local int ib_head OF((struct inflate_state FAR *state, ib_pos *p));
+local int ib_head(state, p)
+    struct inflate_state FAR *state;
+    ib_pos *p;
+{
+    z_const unsigned char FAR *buf = p->next;
+    z_size_t len = (z_size_t)(p->last - p->next), n;
+    unsigned flags, bits;
+
+    state->flags = 0;
+    state->dmax = 32768U;
+    if ((state->wrap & 3) == 0)         /* raw */
+        return Z_OK;
+#ifdef GUNZIP
+    if ((state->wrap & 2) && len >= 2 && buf[0] == 31 && buf[1] == 139) {
+        if (len < 10 || buf[2] != Z_DEFLATED || (buf[3] & 0xe0))
+            return Z_DATA_ERROR;
+        flags = buf[3];
+        n = 10;
+        if (flags & 4) {                /* extra field */
+            if (len - n < 2 ||
+                len - n - 2 < (unsigned)(buf[n] + (buf[n + 1] << 8)))
+                return Z_DATA_ERROR;
+            n += 2 + buf[n] + (buf[n + 1] << 8);
+        }
+        if (flags & 8) {                /* file name */
+            while (n < len && buf[n] != 0)
+                n++;
+            if (n++ == len)
+                return Z_DATA_ERROR;
+        }
+        if (flags & 16) {               /* comment */
+            while (n < len && buf[n] != 0)
+                n++;
+            if (n++ == len)
+                return Z_DATA_ERROR;
+        }
+        if (flags & 2) {                /* header crc */
+            if (len - n < 2 || ((state->wrap & 4) &&
+                                (crc32_z(0L, buf, n) & 0xffff) !=
+                                buf[n] + ((unsigned)buf[n + 1] << 8)))
+                return Z_DATA_ERROR;
+            n += 2;
+        }
+        state->wrap &= ~1;
+        state->flags = 0x800 + flags;   /* method and flags, as inflate() */
+        state->check = crc32(0L, Z_NULL, 0);
+        p->next += n;
+        return Z_OK;
+    }
+#endif
+    if ((state->wrap & 1) == 0 || len < 2 ||
+        (buf[0] & 0xf) != Z_DEFLATED || ((buf[0] << 8) + buf[1]) % 31)
+        return Z_DATA_ERROR;
+    bits = (buf[0] >> 4) + 8U;
+    if (bits > 15 || (state->wbits && bits > state->wbits) ||
+        (buf[1] & 0x20))
+        return Z_DATA_ERROR;
+    state->wrap &= ~2;
+    state->dmax = 1U << bits;
+    state->check = adler32(0L, Z_NULL, 0);
+    p->next += 2;
+    return Z_OK;
+}
+
+/* ===========================================================================
+ * Decode the code lengths of a dynamic block, after its three header bits,
+ * and build the decoding tables in state->codes. Return Z_OK, or
+ * Z_DATA_ERROR if they are invalid or incomplete.
+ */
+local int ib_dynamic OF((struct inflate_state FAR *state, ib_pos *p));
+local int ib_dynamic(state, p)
+    struct inflate_state FAR *state;
+    ib_pos *p;
+{
+    static const unsigned short order[19] = /* permutation of code lengths */
+        {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    unsigned nlen, ndist, ncode, have, copy, val;
+    code here;
+    code FAR *next;
+
+    IB_NEED(14);
+    nlen = IB_BITS(5) + 257;
+    IB_DROP(5);
+    ndist = IB_BITS(5) + 1;
+    IB_DROP(5);
+    ncode = IB_BITS(4) + 4;
+    IB_DROP(4);
+#ifndef PKZIP_BUG_WORKAROUND
+    if (nlen > 286 || ndist > 30)
+        return Z_DATA_ERROR;
+#endif
+    for (have = 0; have < ncode; have++) {
+        IB_NEED(3);
+        state->lens[order[have]] = (unsigned short)IB_BITS(3);
+        IB_DROP(3);
+    }
+    while (have < 19)
+        state->lens[order[have++]] = 0;
+    next = state->codes;
+    state->lencode = (const code FAR *)next;
+    state->lenbits = 7;
+    if (inflate_table(CODES, state->lens, 19, &next, &state->lenbits,
+                      state->work))
+        return Z_DATA_ERROR;
+    have = 0;
+    while (have < nlen + ndist) {
+        for (;;) {
+            here = state->lencode[IB_BITS(state->lenbits)];
+            if (here.bits <= p->bits) break;
+            IB_PULL();
+        }
+        IB_DROP(here.bits);
+        if (here.val < 16) {
+            state->lens[have++] = here.val;
+            continue;
+        }
+        if (here.val == 16) {
+            IB_NEED(2);
+            if (have == 0)
+                return Z_DATA_ERROR;
+            val = state->lens[have - 1];
+            copy = 3 + IB_BITS(2);
+            IB_DROP(2);
+        }
+        else if (here.val == 17) {
+            IB_NEED(3);
+            val = 0;
+            copy = 3 + IB_BITS(3);
+            IB_DROP(3);
+        }
+        else {
+            IB_NEED(7);
+            val = 0;
+            copy = 11 + IB_BITS(7);
+            IB_DROP(7);
+        }
+        if (have + copy > nlen + ndist)
+            return Z_DATA_ERROR;
+        while (copy--)
+            state->lens[have++] = (unsigned short)val;
+    }
+    if (state->lens[256] == 0)          /* no end-of-block code */
+        return Z_DATA_ERROR;
+    next = state->codes;
+    state->lencode = (const code FAR *)next;
+    state->lenbits = 9;
+    if (inflate_table(LENS, state->lens, nlen, &next, &state->lenbits,
+                      state->work))
+        return Z_DATA_ERROR;
+    state->distcode = (const code FAR *)next;
+    state->distbits = 6;
+    if (inflate_table(DISTS, state->lens + nlen, ndist, &next,
+                      &state->distbits, state->work))
+        return Z_DATA_ERROR;
+#ifdef INFLATE_MULTISYM
+    state->pairsok = 0;
+#endif
+    return Z_OK;
+}
+
+/* ===========================================================================
+ * Decode the rest of the current block, checking for the ends of the input
+ * and output at every step. Return Z_OK at the end of the block,
+ * Z_DATA_ERROR for invalid or incomplete data, or Z_BUF_ERROR if the output
+ * is full, after filling it.
+ */
+local int ib_tail OF((struct inflate_state FAR *state, ib_pos *p));
+local int ib_tail(state, p)
+    struct inflate_state FAR *state;
+    ib_pos *p;
+{
+    z_const unsigned char FAR *next = p->next;
+    z_const unsigned char FAR *last = p->last;
+    ib_bits hold = p->hold;
+    unsigned bits = p->bits;
+    unsigned char FAR *put = p->put;
+    unsigned char FAR *end = p->end;
+    code const FAR *lcode = state->lencode;
+    code const FAR *dcode = state->distcode;
+    unsigned lmask = (1U << state->lenbits) - 1;
+    unsigned dmask = (1U << state->distbits) - 1;
+    code here;
+    unsigned op, len, dist;
+    unsigned char FAR *from;
+    int ret;
+#ifdef INFLATE_FAST64
+    Z_U8 word;                  /* next eight bytes of input */
+#endif
+
+#define IB_REFILL() \
+    do { \
+        while (bits < IB_FILL && next < last) { \
+            hold |= (ib_bits)(*next++) << bits; \
+            bits += 8; \
+        } \
+    } while (0)
+
+    for (;;) {
+#ifdef INFLATE_FAST64
+        if (last - next >= 8) {         /* as inflate_fast() does, which
+                                           leaves the next input bits above
+                                           bits in hold, so refill with | */
+            zmemcpy(&word, next, 8);
+            hold |= word << bits;
+            next += (63 - bits) >> 3;
+            bits |= 56;
+        }
+        else
+#endif
+            IB_REFILL();
+        here = lcode[(unsigned)hold & lmask];
+      dolen:
+        ret = Z_DATA_ERROR;             /* for a lack of input */
+        if (here.bits > bits)
+            break;
+        hold >>= here.bits;
+        bits -= here.bits;
+        op = here.op;
+        if (op == 0) {                  /* literal */
+            ret = Z_BUF_ERROR;
+            if (put == end)
+                break;
+            *put++ = (unsigned char)here.val;
+            continue;
+        }
+        if ((op & 16) == 0) {
+            if ((op & 64) == 0) {       /* 2nd level length code */
+                here = lcode[here.val + ((unsigned)hold & ((1U << op) - 1))];
+                goto dolen;
+            }
+            ret = op & 32 ? Z_OK : Z_DATA_ERROR;    /* end of block */
+            break;
+        }
+        len = here.val;                 /* length base */
+        op &= 15;                       /* number of extra bits */
+        if (op) {
+            if (bits < op)
+                IB_REFILL();
+            if (bits < op)
+                break;
+            len += (unsigned)hold & ((1U << op) - 1);
+            hold >>= op;
+            bits -= op;
+        }
+        if (bits < 15)
+            IB_REFILL();
+        here = dcode[(unsigned)hold & dmask];
+      dodist:
+        if (here.bits > bits)
+            break;
+        hold >>= here.bits;
+        bits -= here.bits;
+        op = here.op;
+        if ((op & 16) == 0) {
+            if ((op & 64) == 0) {       /* 2nd level distance code */
+                here = dcode[here.val + ((unsigned)hold & ((1U << op) - 1))];
+                goto dodist;
+            }
+            break;                      /* invalid distance code */
+        }
+        dist = here.val;                /* distance base */
+        op &= 15;                       /* number of extra bits */
+        if (op) {
+            if (bits < op)
+                IB_REFILL();
+            if (bits < op)
+                break;
+            dist += (unsigned)hold & ((1U << op) - 1);
+            hold >>= op;
+            bits -= op;
+        }
+#ifdef INFLATE_STRICT
+        if (dist > state->dmax)
+            break;
+#endif
+        if (dist > (z_size_t)(put - p->dest))   /* too far back */
+            break;
+
+        /* copy the match, as much as fits */
+        from = put - dist;
+        if (len > (z_size_t)(end - put)) {
+            len = (unsigned)(end - put);
+            ret = Z_BUF_ERROR;
+        }
+        while (len--)
+            *put++ = *from++;
+        if (ret == Z_BUF_ERROR)
+            break;
+    }
+#undef IB_REFILL
+    p->next = next;
+    p->hold = hold & (((ib_bits)1 << bits) - 1);
+    p->bits = bits;
+    p->put = put;
+    return ret;
+}
+
+/* ===========================================================================
+ * Decode the rest of a fixed or dynamic block, with the decoding tables in
+ * state. inflate_fast() does the work while there is enough input for it.
+ * When there is less than a match and a chunk of output left, it goes on in
+ * a small buffer instead, with the output so far as its window, and what
+ * fits is copied to the output. ib_tail() does the rest. Return as for
+ * ib_tail().
+ */
+local int ib_codes OF((struct inflate_state FAR *state, ib_pos *p));
+local int ib_codes(state, p)
+    struct inflate_state FAR *state;
+    ib_pos *p;
+{
+    z_streamp strm = state->strm;
+    const uInt max = (uInt)-1;
+    z_size_t have, left, kept;
+    unsigned char FAR *chk;
+    unsigned char buf[2 * INFLATE_FAST_MIN_LEFT];   /* for the last output */
+
+    for (;;) {
+        /* give back the whole bytes in hold for inflate_fast() */
+        p->next -= p->bits >> 3;
+        p->bits &= 7;
+        p->hold &= (1U << p->bits) - 1;
+        have = (z_size_t)(p->last - p->next);
+        left = (z_size_t)(p->end - p->put);
+        if (have < INFLATE_FAST_MIN_HAVE)
+            return ib_tail(state, p);
+
+        /* matches may reach back to dest, but no more than 32K */
+        kept = (z_size_t)(p->put - p->dest);
+        if (kept > 32768U)
+            kept = 32768U;
+        strm->next_in = p->next;
+        strm->avail_in = have > max ? max : (uInt)have;
+        state->hold = (unsigned long)p->hold;
+        state->bits = p->bits;
+        state->mode = LEN;
+        if (left >= INFLATE_FAST_MIN_LEFT) {
+            strm->next_out = p->put;
+            strm->avail_out = left > max - kept ? max - (uInt)kept :
+                                                  (uInt)left;
+            inflate_fast(strm, (unsigned)kept + strm->avail_out);
+            p->put = strm->next_out;
+        }
+        else {
+            /* decode to buf, with the kept output as a full window */
+            chk = state->chk;
+            state->chk = Z_NULL;
+            state->window = p->put - kept;
+            state->wsize = state->whave = (unsigned)kept;
+            strm->next_out = buf;
+            strm->avail_out = sizeof(buf);
+            inflate_fast(strm, sizeof(buf));
+            state->chk = chk;
+            state->window = Z_NULL;
+            state->wsize = state->whave = 0;
+            have = (z_size_t)(strm->next_out - buf);
+            if (have > left) {
+                zmemcpy(p->put, buf, left);
+                p->put += left;
+                return state->mode == BAD ? Z_DATA_ERROR : Z_BUF_ERROR;
+            }
+            zmemcpy(p->put, buf, have);
+            p->put += have;
+        }
+        p->next = strm->next_in;
+        p->hold = state->hold;
+        p->bits = state->bits;
+        if (state->mode == TYPE)
+            return Z_OK;
+        if (state->mode == BAD)
+            return Z_DATA_ERROR;
+        if (strm->avail_in < 2 * INFLATE_FAST_MIN_HAVE)
+            return ib_tail(state, p);   /* stopped for lack of input */
+    }
+}
+
+/* ===========================================================================
+ * Decode the blocks of the deflate data at the input, and the trailer that
+ * follows, if any. Return Z_OK, or as for ib_tail().
+ */
+local int ib_blocks OF((struct inflate_state FAR *state, ib_pos *p));
+local int ib_blocks(state, p)
+    struct inflate_state FAR *state;
+    ib_pos *p;
+{
+    unsigned len, n;
+    unsigned long check, total;
+    int ret;
+
+    state->chk = state->wrap & 4 ? p->put : Z_NULL;
+    do {
+        IB_NEED(3);
+        state->last = (int)IB_BITS(1);
+        IB_DROP(1);
+        switch (IB_BITS(2)) {
+        case 0:                         /* stored */
+            IB_DROP(2);
+            IB_DROP(p->bits & 7);
+            IB_NEED(32);
+            len = IB_BITS(16);
+            if (len != (((unsigned)(p->hold >> 16) & 0xffff) ^ 0xffff))
+                return Z_DATA_ERROR;
+            IB_DROP(32);
+            p->next -= p->bits >> 3;    /* give back the whole bytes */
+            p->hold = 0;
+            p->bits = 0;
+            ret = Z_OK;
+            if ((z_size_t)(p->last - p->next) < len) {
+                len = (unsigned)(p->last - p->next);
+                ret = Z_DATA_ERROR;     /* after copying what is there */
+            }
+            if ((z_size_t)(p->end - p->put) < len) {
+                len = (unsigned)(p->end - p->put);
+                ret = Z_BUF_ERROR;
+            }
+            if (state->chk != Z_NULL) { /* check while copying */
+                UPDATE_UPTO(p->put);
+                state->check = UPDATE_COPY(state->check, p->put, p->next,
+                                           len);
+                state->chk = p->put + len;
+            }
+            else
+                zmemcpy(p->put, p->next, len);
+            p->put += len;
+            p->next += len;
+            if (ret != Z_OK)
+                return ret;
+            break;
+        case 1:                         /* fixed */
+            IB_DROP(2);
+#ifdef INFLATE_MULTISYM
+            if (state->lencode != lenfix)
+                state->pairsok = 0;
+#endif
+            state->lencode = lenfix;
+            state->lenbits = 9;
+            state->distcode = distfix;
+            state->distbits = 5;
+            ret = ib_codes(state, p);
+            if (ret != Z_OK)
+                return ret;
+            break;
+        case 2:                         /* dynamic */
+            IB_DROP(2);
+            ret = ib_dynamic(state, p);
+            if (ret == Z_OK)
+                ret = ib_codes(state, p);
+            if (ret != Z_OK)
+                return ret;
+            break;
+        default:                        /* invalid */
+            return Z_DATA_ERROR;
+        }
+    } while (!state->last);
+
+    /* check the trailer */
+    IB_DROP(p->bits & 7);
+    if ((state->wrap & 3) == 0)
+        return Z_OK;
+    UPDATE_UPTO(p->put);
+    check = total = 0;
+    for (n = 0; n < 4; n++) {
+        IB_NEED(8);
+        if (state->flags)
+            check += (unsigned long)IB_BITS(8) << (8 * n);
+        else
+            check = (check << 8) + IB_BITS(8);
+        IB_DROP(8);
+    }
+    for (n = 0; n < 4 && state->flags; n++) {
+        IB_NEED(8);
+        total += (unsigned long)IB_BITS(8) << (8 * n);
+        IB_DROP(8);
+    }
+    if ((state->wrap & 4) && (check != (state->check & 0xffffffffUL) ||
+        (state->flags &&
+         total != ((unsigned long)(p->put - p->dest) & 0xffffffffUL))))
+        return Z_DATA_ERROR;
+    return Z_OK;
+}
+
+/* ===========================================================================
+ * Decompress with inflate(), as uncompress2() always did. This is used when
+ * the data does not decode in full, since how much input inflate() reports
+ * as used in that case depends on what it had pulled into its bit buffer,
+ * and that is what callers have been given.
+ */
+local int ib_inflate OF((Bytef *dest, uLongf *destLen, const Bytef *source,
+                         uLong *sourceLen, int windowBits));
+local int ib_inflate(dest, destLen, source, sourceLen, windowBits)
+    Bytef *dest;
+    uLongf *destLen;
+    const Bytef *source;
+    uLong *sourceLen;
+    int windowBits;
+{
+    z_stream stream;
+    int err;
+    const uInt max = (uInt)-1;
+    uLong len, left;
+    Byte buf[1];    /* for detection of incomplete stream when *destLen == 0 */
+
+    len = *sourceLen;
+    if (*destLen) {
+        left = *destLen;
+        *destLen = 0;
+    }
+    else {
+        left = 1;
+        dest = buf;
+    }
+
+    stream.next_in = (z_const Bytef *)source;
+    stream.avail_in = 0;
+    stream.zalloc = (alloc_func)0;
+    stream.zfree = (free_func)0;
+    stream.opaque = (voidpf)0;
+
+    err = inflateInit2(&stream, windowBits);
+    if (err != Z_OK) return err;
+
+    stream.next_out = dest;
+    stream.avail_out = 0;
+
+    do {
+        if (stream.avail_out == 0) {
+            stream.avail_out = left > (uLong)max ? max : (uInt)left;
+            left -= stream.avail_out;
+        }
+        if (stream.avail_in == 0) {
+            stream.avail_in = len > (uLong)max ? max : (uInt)len;
+            len -= stream.avail_in;
+        }
+        err = inflate(&stream, Z_NO_FLUSH);
+    } while (err == Z_OK);
+
+    *sourceLen -= len + stream.avail_in;
+    if (dest != buf)
+        *destLen = stream.total_out;
+    else if (stream.total_out && err == Z_BUF_ERROR)
+        left = 1;
+
+    inflateEnd(&stream);
+    return err == Z_STREAM_END ? Z_OK :
+           err == Z_NEED_DICT ? Z_DATA_ERROR  :
+           err == Z_BUF_ERROR && left + stream.avail_out ? Z_DATA_ERROR :
+           err;
+}
+
+/* ===========================================================================
+ */
+int ZEXPORT inflateBuffer(dest, destLen, source, sourceLen, windowBits)
+    Bytef *dest;
+    uLongf *destLen;
+    const Bytef *source;
+    uLong *sourceLen;
+    int windowBits;
+{
+    z_stream stream;
+    struct inflate_state FAR *state;
+    ib_pos pos;
+    Byte buf[1];    /* for dest when *destLen == 0 */
+    int bits, wrap, ret;
+
+    /* decode windowBits as inflateInit2() does */
+    bits = windowBits;
+    if (windowBits < 0) {
+        if (windowBits < -15)
+            return Z_STREAM_ERROR;
+        wrap = 0;
+        windowBits = -windowBits;
+    }
+    else {
+        wrap = (windowBits >> 4) + 5;
+#ifdef GUNZIP
+        if (windowBits < 48)
+            windowBits &= 15;
+#endif
+    }
+    if (windowBits && (windowBits < 8 || windowBits > 15))
+        return Z_STREAM_ERROR;
+
+    /* allocate the state for inflate_fast(), but no window */
+    stream.zalloc = zcalloc;
+    stream.zfree = zcfree;
+    stream.opaque = (voidpf)0;
+    stream.msg = Z_NULL;
+    state = (struct inflate_state FAR *)ZALLOC(&stream, 1,
+                                               sizeof(struct inflate_state));
+    if (state == Z_NULL)
+        return Z_MEM_ERROR;
+    stream.state = (struct internal_state FAR *)state;
+    state->strm = &stream;
+    state->wrap = wrap;
+    state->wbits = (unsigned)windowBits;
+    state->wsize = 0;
+    state->whave = 0;
+    state->wnext = 0;
+    state->window = Z_NULL;
+    state->sane = 1;
+    state->exact = 0;
+    state->lencode = Z_NULL;
+#ifdef INFLATE_MULTISYM
+    state->pairsok = 0;
+#endif
+
+    /* decode the stream */
+    pos.next = (z_const unsigned char FAR *)source;
+    pos.last = pos.next + *sourceLen;
+    pos.hold = 0;
+    pos.bits = 0;
+    pos.dest = *destLen ? dest : buf;
+    pos.put = pos.dest;
+    pos.end = pos.dest + *destLen;
+    ret = ib_head(state, &pos);
+    if (ret == Z_OK)
+        ret = ib_blocks(state, &pos);
+
+    /* return the amounts used, or if the data did not decode in full, do it
+       again with inflate() for the amounts it would report */
+    ZFREE(&stream, state);
+    if (ret != Z_OK)
+        return ib_inflate(dest, destLen, source, sourceLen, bits);
+    *sourceLen = (uLong)(pos.next - (z_const unsigned char FAR *)source) -
+                 (pos.bits >> 3);
+    *destLen = (uLong)(pos.put - pos.dest);
+    return Z_OK;
+}
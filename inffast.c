@@ -12,6 +12,196 @@
 #  pragma message("Assembler code may have bugs -- use at your own risk")
 #else
 
+#ifdef INFLATE_CHUNK
+/* A chunk of INFLATE_CHUNK bytes, loaded and stored unaligned */
+#  ifdef Z_X86_SIMD
+#    include <emmintrin.h>
+     typedef __m128i z_chunk;
+#    define CHUNK_LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+#    define CHUNK_STORE(p, v) _mm_storeu_si128((__m128i *)(p), v)
+#    define CHUNK_SPLAT(c) _mm_set1_epi8((char)(c))
+#  else
+#    include <arm_neon.h>
+     typedef uint8x16_t z_chunk;
+#    define CHUNK_LOAD(p) vld1q_u8(p)
+#    define CHUNK_STORE(p, v) vst1q_u8(p, v)
+#    define CHUNK_SPLAT(c) vdupq_n_u8(c)
+#  endif
+
+local unsigned char FAR *chunk_copy OF((unsigned char FAR *out,
+                                        const unsigned char FAR *from,
+                                        unsigned len));
+local unsigned char FAR *chunk_match OF((unsigned char FAR *out,
+                                         unsigned dist, unsigned len));
+local unsigned char FAR *exact_copy OF((unsigned char FAR *out,
+                                        const unsigned char FAR *from,
+                                        unsigned len));
+local unsigned char FAR *exact_match OF((unsigned char FAR *out,
+                                         unsigned dist, unsigned len));
+
+/*
+   Copy len > 0 bytes from from to out, which do not overlap, and return out +
+   len. This neither reads nor writes past the len bytes, since from may be in
+   the window, which has no room past its end. inflateBack(), whose window can
+   overlap the output, uses exact_copy() instead.
+ */
+local unsigned char FAR *chunk_copy(out, from, len)
+unsigned char FAR *out;
+const unsigned char FAR *from;
+unsigned len;
+{
+    if (len < INFLATE_CHUNK) {
+        do {
+            *out++ = *from++;
+        } while (--len);
+        return out;
+    }
+    while (len > INFLATE_CHUNK) {
+        CHUNK_STORE(out, CHUNK_LOAD(from));
+        out += INFLATE_CHUNK;
+        from += INFLATE_CHUNK;
+        len -= INFLATE_CHUNK;
+    }
+    len = INFLATE_CHUNK - len;      /* last chunk may overlap the previous */
+    out -= len;
+    from -= len;
+    CHUNK_STORE(out, CHUNK_LOAD(from));
+    return out + INFLATE_CHUNK;
+}
+
+/*
+   Copy a match of len > 0 bytes to out from dist bytes back in the output,
+   and return out + len. This may write up to INFLATE_CHUNK - 1 bytes past the
+   match. When dist is at least a chunk, each chunk is read after the chunks
+   it depends on have been written. Otherwise, the first chunk is written a
+   byte at a time, and then repeated every whole number of dist bytes,
+   except for dist == 1, which is a run of one byte value.
+ */
+local unsigned char FAR *chunk_match(out, dist, len)
+unsigned char FAR *out;
+unsigned dist;
+unsigned len;
+{
+    unsigned char FAR *end;
+    const unsigned char FAR *from;
+    z_chunk pat;
+    unsigned n;
+
+    end = out + len;
+    from = out - dist;
+    if (dist >= INFLATE_CHUNK) {
+        do {
+            CHUNK_STORE(out, CHUNK_LOAD(from));
+            out += INFLATE_CHUNK;
+            from += INFLATE_CHUNK;
+        } while (out < end);
+    }
+    else if (dist == 1) {
+        pat = CHUNK_SPLAT(*from);
+        do {
+            CHUNK_STORE(out, pat);
+            out += INFLATE_CHUNK;
+        } while (out < end);
+    }
+    else {
+        n = len < INFLATE_CHUNK ? len : INFLATE_CHUNK;
+        do {
+            *out++ = *from++;
+        } while (--n);
+        if (out < end) {
+            out -= INFLATE_CHUNK;
+            pat = CHUNK_LOAD(out);
+            n = INFLATE_CHUNK - INFLATE_CHUNK % dist;
+            while ((out += n) < end)
+                CHUNK_STORE(out, pat);
+        }
+    }
+    return end;
+}
+
+/*
+   Copy len bytes from from to out in order, whole chunks and then a byte at a
+   time, and return out + len. This is for inflateBack(), where the window is
+   the output, so from may be up to INFLATE_CHUNK - 1 bytes ahead of out in the
+   same buffer, or at least a chunk behind it. Each chunk is read before it is
+   overwritten, and no byte is read after it has been written, as chunk_copy()
+   would for its last chunk.
+ */
+local unsigned char FAR *exact_copy(out, from, len)
+unsigned char FAR *out;
+const unsigned char FAR *from;
+unsigned len;
+{
+    while (len >= INFLATE_CHUNK) {
+        CHUNK_STORE(out, CHUNK_LOAD(from));
+        out += INFLATE_CHUNK;
+        from += INFLATE_CHUNK;
+        len -= INFLATE_CHUNK;
+    }
+    while (len) {
+        *out++ = *from++;
+        len--;
+    }
+    return out;
+}
+
+/*
+   Copy a match like chunk_match(), but without writing past its end. This is
+   for inflateBack(), where the output is the window, so the bytes past the
+   match are the oldest history, still needed for distances close to the
+   window size. Whole chunks are copied when dist is at least a chunk, and the
+   rest a byte at a time.
+ */
+local unsigned char FAR *exact_match(out, dist, len)
+unsigned char FAR *out;
+unsigned dist;
+unsigned len;
+{
+    const unsigned char FAR *from;
+
+    from = out - dist;
+    if (dist >= INFLATE_CHUNK)
+        return exact_copy(out, from, len);
+    while (len) {
+        *out++ = *from++;
+        len--;
+    }
+    return out;
+}
+
+/* Copy a match of len bytes from dist back, exactly if exact is true */
+#  define MATCH_COPY() \
+    out = exact ? exact_match(out, dist, len) : chunk_match(out, dist, len)
+
+/* Copy len bytes from the window at from, exactly if exact is true */
+#  define FROM_COPY(len) \
+    out = exact ? exact_copy(out, from, len) : chunk_copy(out, from, len)
+
+/* Copy n > 0 bytes from the window at from to out, advancing both */
+#  define WINDOW_COPY(n) \
+    do { \
+        FROM_COPY(n); \
+        from += n; \
+    } while (0)
+#else
+#  define WINDOW_COPY(n) \
+    do { \
+        *out++ = *from++; \
+    } while (--n)
+#endif
+
+#ifdef INFLATE_MULTISYM
+/* Most literal pair lookups before filling the bit buffer again: four with
+   the 64-bit bit buffer, or one with the 32-bit buffer.  A lookup takes at
+   most MAX_LENBITS bits, and needs that many in the bit buffer, including the
+   lookup that ends the run. */
+#  ifdef INFLATE_FAST64
+#    define PAIR_RUN 4
+#  else
+#    define PAIR_RUN 1
+#  endif
+#endif
+
 /*
    Decode literal, length, and distance codes and write out the resulting
    literal and match bytes until either not enough input or output is
@@ -23,8 +213,8 @@
    Entry assumptions:
 
         state->mode == LEN
-        strm->avail_in >= 6
-        strm->avail_out >= 258
+        strm->avail_in >= INFLATE_FAST_MIN_HAVE
+        strm->avail_out >= INFLATE_FAST_MIN_LEFT
         start >= strm->avail_out
         state->bits < 8
 
@@ -46,10 +236,37 @@
       bytes, which is the maximum length that can be coded.  inflate_fast()
       requires strm->avail_out >= 258 for each loop to avoid checking for
       output space.
+
+    - With INFLATE_CHUNK, matches are copied a chunk of 16 bytes at a time,
+      which may write up to 15 bytes past the end of the match.  That needs
+      strm->avail_out >= 273 for each loop instead.  If state->exact is true,
+      as for inflateBack(), whose output is the window, nothing is written
+      past the end of the output, and the last part of each match is copied
+      a byte at a time.  That includes copies from the window, which there
+      may start just ahead of the output.
+
+    - With INFLATE_FAST64, the bit buffer is filled to at least 56 bits once
+      per loop, with one unaligned load of the next eight input bytes.  That
+      is enough for a length/distance pair without any more input, or for up
+      to three literals, which are decoded without going back around the
+      loop.  Eight bytes of input must then be available for each loop.
+
+    - With INFLATE_MULTISYM, the root index bits of a literal/length code are
+      looked up in the literal pair table, a copy of the root table where an
+      entry for a literal gives one or two literals at once.  With
+      INFLATE_FAST64, up to four such lookups are made per loop, for up to
+      eight literals, and if they end on a length code, the bit buffer is
+      filled again to decode the length/distance pair without going back
+      around the loop.
+
+    - If state->chk is not Z_NULL, then the check value is updated with the
+      output so far whenever about INFLATE_CHECK_RUN more bytes have been
+      written, so that the output is read back while it is still in the
+      cache instead of in a separate pass by inflate().
  */
 void ZLIB_INTERNAL inflate_fast(strm, start)
 z_streamp strm;
-unsigned start;         /* inflate()'s starting value for strm->avail_out */
+unsigned start;         /* inflate()'s starting avail_out, plus kept output */
 {
     struct inflate_state FAR *state;
     z_const unsigned char FAR *in;      /* local strm->next_in */
@@ -57,6 +274,8 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     unsigned char FAR *out;     /* local strm->next_out */
     unsigned char FAR *beg;     /* inflate()'s initial strm->next_out */
     unsigned char FAR *end;     /* while out < end, enough space available */
+    unsigned char FAR *lim;     /* decode until out reaches lim or end */
+    unsigned char FAR *chk;     /* output not yet in check, or Z_NULL */
 #ifdef INFLATE_STRICT
     unsigned dmax;              /* maximum distance from zlib header */
 #endif
@@ -64,10 +283,18 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     unsigned whave;             /* valid bytes in the window */
     unsigned wnext;             /* window write index */
     unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
+#ifdef INFLATE_FAST64
+    Z_U8 hold;                  /* local strm->hold */
+    Z_U8 word;                  /* next eight bytes of input */
+#else
     unsigned long hold;         /* local strm->hold */
+#endif
     unsigned bits;              /* local strm->bits */
     code const FAR *lcode;      /* local strm->lencode */
     code const FAR *dcode;      /* local strm->distcode */
+#ifdef INFLATE_MULTISYM
+    code const FAR *lpair;      /* local strm->lenpair */
+#endif
     unsigned lmask;             /* mask for first level of length codes */
     unsigned dmask;             /* mask for first level of distance codes */
     code const *here;           /* retrieved table entry */
@@ -76,14 +303,17 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     unsigned len;               /* match length, unused bytes */
     unsigned dist;              /* match distance */
     unsigned char FAR *from;    /* where to copy match from */
+#if defined(INFLATE_CHUNK) || defined(INFLATE_MULTISYM)
+    int exact;                  /* true to write nothing past the output */
+#endif
 
     /* copy state to local variables */
     state = (struct inflate_state FAR *)strm->state;
     in = strm->next_in;
-    last = in + (strm->avail_in - 5);
+    last = in + (strm->avail_in - (INFLATE_FAST_MIN_HAVE - 1));
     out = strm->next_out;
     beg = out - (start - strm->avail_out);
-    end = out + (strm->avail_out - 257);
+    end = out + (strm->avail_out - (INFLATE_FAST_MIN_LEFT - 1));
 #ifdef INFLATE_STRICT
     dmax = state->dmax;
 #endif
@@ -95,19 +325,75 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     bits = state->bits;
     lcode = state->lencode;
     dcode = state->distcode;
+#ifdef INFLATE_MULTISYM
+    if (!state->pairsok) {
+        inflate_pairs(state->lenpair, lcode, state->lenbits);
+        state->pairsok = 1;
+    }
+    lpair = state->lenpair;
+#endif
     lmask = (1U << state->lenbits) - 1;
     dmask = (1U << state->distbits) - 1;
+#if defined(INFLATE_CHUNK) || defined(INFLATE_MULTISYM)
+    exact = state->exact;
+#endif
+
+    chk = state->chk;
 
     /* decode literals and length/distances until end-of-block or not enough
-       input data or output space */
+       input data or output space, in runs if updating the check value */
+  run:
+    lim = chk != Z_NULL && end - out > INFLATE_CHECK_RUN ?
+          out + INFLATE_CHECK_RUN : end;
     do {
+#ifdef INFLATE_FAST64
+        /* The bits in hold above bits are already the next input bits, so
+           or-ing them in again leaves them unchanged. in is advanced past
+           the whole bytes added. */
+        zmemcpy(&word, in, 8);
+        hold |= word << bits;
+        in += (63 - bits) >> 3;
+        bits |= 56;
+#else
         if (bits < 15) {
             hold += (unsigned long)(*in++) << bits;
             bits += 8;
             hold += (unsigned long)(*in++) << bits;
             bits += 8;
         }
+#endif
+#ifdef INFLATE_MULTISYM
+        here = lpair + (hold & lmask);
+        if (here->op & 128) {                   /* one or two literals */
+            len = PAIR_RUN;
+            do {
+                op = (unsigned)(here->bits);
+                hold >>= op;
+                bits -= op;
+                Tracevv((stderr, here->op == 130 ?
+                        "inflate:         literals 0x%02x 0x%02x\n" :
+                        "inflate:         literal 0x%02x\n",
+                        here->val & 0xff, here->val >> 8));
+                out[0] = (unsigned char)(here->val);
+                if (here->op == 130 || !exact)
+                    out[1] = (unsigned char)(here->val >> 8);
+                out += here->op - 128;
+                here = lpair + (hold & lmask);
+            } while ((here->op & 128) && --len);
+#ifdef INFLATE_FAST64
+            if ((here->op & 128) == 0 && in < last && out < end) {
+                zmemcpy(&word, in, 8);
+                hold |= word << bits;
+                in += (63 - bits) >> 3;
+                bits |= 56;
+                goto dolen;
+            }
+#endif
+            continue;
+        }
+#else
         here = lcode + (hold & lmask);
+#endif
       dolen:
         op = (unsigned)(here->bits);
         hold >>= op;
@@ -118,26 +404,45 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                     "inflate:         literal '%c'\n" :
                     "inflate:         literal 0x%02x\n", here->val));
             *out++ = (unsigned char)(here->val);
+#ifdef INFLATE_FAST64
+            /* at least 41 bits are left, enough for two more literals */
+            for (len = 0; len < 2; len++) {
+                here = lcode + (hold & lmask);
+                if (here->op)
+                    break;
+                op = (unsigned)(here->bits);
+                hold >>= op;
+                bits -= op;
+                Tracevv((stderr, here->val >= 0x20 && here->val < 0x7f ?
+                        "inflate:         literal '%c'\n" :
+                        "inflate:         literal 0x%02x\n", here->val));
+                *out++ = (unsigned char)(here->val);
+            }
+#endif
         }
         else if (op & 16) {                     /* length base */
             len = (unsigned)(here->val);
             op &= 15;                           /* number of extra bits */
             if (op) {
+#ifndef INFLATE_FAST64
                 if (bits < op) {
                     hold += (unsigned long)(*in++) << bits;
                     bits += 8;
                 }
+#endif
                 len += (unsigned)hold & ((1U << op) - 1);
                 hold >>= op;
                 bits -= op;
             }
             Tracevv((stderr, "inflate:         length %u\n", len));
+#ifndef INFLATE_FAST64
             if (bits < 15) {
                 hold += (unsigned long)(*in++) << bits;
                 bits += 8;
                 hold += (unsigned long)(*in++) << bits;
                 bits += 8;
             }
+#endif
             here = dcode + (hold & dmask);
           dodist:
             op = (unsigned)(here->bits);
@@ -147,6 +452,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
             if (op & 16) {                      /* distance base */
                 dist = (unsigned)(here->val);
                 op &= 15;                       /* number of extra bits */
+#ifndef INFLATE_FAST64
                 if (bits < op) {
                     hold += (unsigned long)(*in++) << bits;
                     bits += 8;
@@ -155,6 +461,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         bits += 8;
                     }
                 }
+#endif
                 dist += (unsigned)hold & ((1U << op) - 1);
 #ifdef INFLATE_STRICT
                 if (dist > dmax) {
@@ -201,9 +508,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         from += wsize - op;
                         if (op < len) {         /* some from window */
                             len -= op;
-                            do {
-                                *out++ = *from++;
-                            } while (--op);
+                            WINDOW_COPY(op);
                             from = out - dist;  /* rest from output */
                         }
                     }
@@ -212,16 +517,12 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         op -= wnext;
                         if (op < len) {         /* some from end of window */
                             len -= op;
-                            do {
-                                *out++ = *from++;
-                            } while (--op);
+                            WINDOW_COPY(op);
                             from = window;
                             if (wnext < len) {  /* some from start of window */
                                 op = wnext;
                                 len -= op;
-                                do {
-                                    *out++ = *from++;
-                                } while (--op);
+                                WINDOW_COPY(op);
                                 from = out - dist;      /* rest from output */
                             }
                         }
@@ -230,12 +531,16 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         from += wnext - op;
                         if (op < len) {         /* some from window */
                             len -= op;
-                            do {
-                                *out++ = *from++;
-                            } while (--op);
+                            WINDOW_COPY(op);
                             from = out - dist;  /* rest from output */
                         }
                     }
+#ifdef INFLATE_CHUNK
+                    if (from == out - dist)
+                        MATCH_COPY();
+                    else
+                        FROM_COPY(len);
+#else
                     while (len > 2) {
                         *out++ = *from++;
                         *out++ = *from++;
@@ -247,8 +552,12 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         if (len > 1)
                             *out++ = *from++;
                     }
+#endif
                 }
                 else {
+#ifdef INFLATE_CHUNK
+                    MATCH_COPY();
+#else
                     from = out - dist;          /* copy direct from output */
                     do {                        /* minimum length is three */
                         *out++ = *from++;
@@ -261,6 +570,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         if (len > 1)
                             *out++ = *from++;
                     }
+#endif
                 }
             }
             else if ((op & 64) == 0) {          /* 2nd level distance code */
@@ -287,7 +597,14 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
             state->mode = BAD;
             break;
         }
-    } while (in < last && out < end);
+    } while (in < last && out < lim);
+    if (chk != Z_NULL) {
+        state->check = UPDATE_CHECK(state->check, chk, (unsigned)(out - chk));
+        chk = out;
+        if (state->mode == LEN && in < last && out < end)
+            goto run;
+        state->chk = chk;
+    }
 
     /* return unused bytes (on entry, bits < 8, so in won't go too far back) */
     len = bits >> 3;
@@ -298,10 +615,13 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     /* update state and return */
     strm->next_in = in;
     strm->next_out = out;
-    strm->avail_in = (unsigned)(in < last ? 5 + (last - in) : 5 - (in - last));
+    strm->avail_in = (unsigned)(in < last ?
+                                (INFLATE_FAST_MIN_HAVE - 1) + (last - in) :
+                                (INFLATE_FAST_MIN_HAVE - 1) - (in - last));
     strm->avail_out = (unsigned)(out < end ?
-                                 257 + (end - out) : 257 - (out - end));
-    state->hold = hold;
+                                 (INFLATE_FAST_MIN_LEFT - 1) + (end - out) :
+                                 (INFLATE_FAST_MIN_LEFT - 1) - (out - end));
+    state->hold = (unsigned long)hold;
     state->bits = bits;
     return;
 }
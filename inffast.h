@@ -8,4 +8,35 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/* On 64-bit little-endian processors that can load unaligned words,
+   inflate_fast() fills its bit buffer eight bytes at a time, and then needs
+   eight bytes of input at hand instead of six. */
+#if defined(Z_U8) && !defined(ASMINF) && !defined(NO_INFLATE_FAST64) && \
+    (defined(__x86_64__) || defined(_M_X64) || defined(_M_ARM64) || \
+     (defined(__aarch64__) && defined(__BYTE_ORDER__) && \
+      __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__))
+#  define INFLATE_FAST64
+#  define INFLATE_FAST_MIN_HAVE 8
+#else
+#  define INFLATE_FAST_MIN_HAVE 6
+#endif
+
+/* With SIMD support, inflate_fast() copies matches in chunks of
+   INFLATE_CHUNK bytes, and may write up to INFLATE_CHUNK - 1 bytes past the
+   end of a match, on top of up to 258 bytes for each length/distance pair. */
+#if (defined(Z_X86_SIMD) || defined(Z_ARM_SIMD)) && !defined(ASMINF) && \
+    !defined(NO_INFLATE_CHUNK)
+#  define INFLATE_CHUNK 16
+#  define INFLATE_FAST_MIN_LEFT (258 + INFLATE_CHUNK - 1)
+#else
+#  define INFLATE_FAST_MIN_LEFT 258
+#endif
+
+/* When inflate() is computing the check value, inflate_fast() updates it
+   after each INFLATE_CHECK_RUN bytes or so of output, while those are still
+   in the cache. */
+#ifndef INFLATE_CHECK_RUN
+#  define INFLATE_CHECK_RUN 4096
+#endif
+
 void ZLIB_INTERNAL inflate_fast OF((z_streamp strm, unsigned start));
@@ -85,6 +85,13 @@
 #include "inflate.h"
 #include "inffast.h"
 
+#ifdef Z_X86_SIMD
+#  include <emmintrin.h>
+#endif
+#ifdef Z_ARM_SIMD
+#  include <arm_neon.h>
+#endif
+
 #ifdef MAKEFIXED
 #  ifndef BUILDFIXED
 #    define BUILDFIXED
@@ -94,8 +101,10 @@
 /* function prototypes */
 local int inflateStateCheck OF((z_streamp strm));
 local void fixedtables OF((struct inflate_state FAR *state));
+local int codetables OF((struct inflate_state FAR *state));
 local int updatewindow OF((z_streamp strm, const unsigned char FAR *end,
                            unsigned copy));
+local int fillwindow OF((z_streamp strm));
 #ifdef BUILDFIXED
    void makefixed OF((void));
 #endif
@@ -136,7 +145,11 @@ z_streamp strm;
     state->hold = 0;
     state->bits = 0;
     state->lencode = state->distcode = state->next = state->codes;
+    state->hist = Z_NULL;
     state->sane = 1;
+#ifdef INFLATE_MULTISYM
+    state->pairsok = 0;
+#endif
     state->back = -1;
     Tracev((stderr, "inflate: reset\n"));
     return Z_OK;
@@ -228,6 +241,10 @@ int stream_size;
     strm->state = (struct internal_state FAR *)state;
     state->strm = strm;
     state->window = Z_NULL;
+    state->sets = Z_NULL;
+    state->nsets = 0;
+    state->keep = 0;
+    state->exact = 0;
     state->mode = HEAD;     /* to pass state test in inflateReset2() */
     ret = inflateReset2(strm, windowBits);
     if (ret != Z_OK) {
@@ -266,6 +283,76 @@ int value;
     return Z_OK;
 }
 
+int ZEXPORT inflateTune(strm, lenbits, distbits, tables)
+z_streamp strm;
+int lenbits;
+int distbits;
+int tables;
+{
+    struct inflate_state FAR *state;
+    code_set FAR *sets;
+    code FAR *codes;
+    unsigned size, k;
+
+    if (inflateStateCheck(strm)) return Z_STREAM_ERROR;
+    state = (struct inflate_state FAR *)strm->state;
+    if (state->mode != HEAD || lenbits < 9 || lenbits > MAX_LENBITS ||
+        distbits < 6 || distbits > MAX_DISTBITS ||
+        tables < 0 || tables > MAX_SETS)
+        return Z_STREAM_ERROR;
+
+    /* larger root tables need the space of at least one set */
+    if (tables == 0 && (lenbits > 9 || distbits > 6))
+        tables = 1;
+
+    /* allocate the new sets before letting go of the old ones */
+    sets = Z_NULL;
+    codes = Z_NULL;
+    if (tables) {
+        size = ENOUGH_LENS_ROOT(lenbits) + ENOUGH_DISTS_ROOT(distbits);
+        sets = (code_set FAR *)ZALLOC(strm, tables, sizeof(code_set));
+        codes = (code FAR *)ZALLOC(strm, tables * size, sizeof(code));
+        if (sets == Z_NULL || codes == Z_NULL) {
+            if (sets != Z_NULL) ZFREE(strm, sets);
+            if (codes != Z_NULL) ZFREE(strm, codes);
+            return Z_MEM_ERROR;
+        }
+        for (k = 0; k < (unsigned)tables; k++) {
+            sets[k].nlen = 0;
+            sets[k].used = 0;
+            sets[k].lencode = codes + k * size;
+            sets[k].distcode = sets[k].lencode;
+        }
+    }
+    if (state->sets != Z_NULL) {
+        ZFREE(strm, state->setcodes);
+        ZFREE(strm, state->sets);
+    }
+    state->sets = sets;
+    state->setcodes = codes;
+    state->nsets = (unsigned)tables;
+    state->rootlen = (unsigned)lenbits;
+    state->rootdist = (unsigned)distbits;
+    state->uses = 0;
+    return Z_OK;
+}
+
+int ZEXPORT inflateKeepOutput(strm, keep)
+z_streamp strm;
+int keep;
+{
+    struct inflate_state FAR *state;
+
+    if (inflateStateCheck(strm)) return Z_STREAM_ERROR;
+    state = (struct inflate_state FAR *)strm->state;
+    if (!keep && fillwindow(strm)) {
+        state->mode = MEM;
+        return Z_MEM_ERROR;
+    }
+    state->keep = keep != 0;
+    return Z_OK;
+}
+
 /*
    Return state with length and distance decoding tables and index sizes set to
    fixed code decoding.  Normally this returns fixed tables from inffixed.h.
@@ -313,6 +400,10 @@ struct inflate_state FAR *state;
 #else /* !BUILDFIXED */
 #   include "inffixed.h"
 #endif /* BUILDFIXED */
+#ifdef INFLATE_MULTISYM
+    if (state->lencode != lenfix)
+        state->pairsok = 0;
+#endif
     state->lencode = lenfix;
     state->lenbits = 9;
     state->distcode = distfix;
@@ -380,6 +471,82 @@ void makefixed()
 }
 #endif /* MAKEFIXED */
 
+/*
+   Set up the decoding tables for the dynamic block code lengths in lens[].
+   Without sets of tables from inflateTune(), the tables are built in codes[].
+   Otherwise a set built from the same code lengths is reused if there is one,
+   or else the tables are built in the least recently used set.  Return 0 on
+   success, 1 for an invalid literal/length code, or 2 for an invalid distance
+   code.
+ */
+local int codetables(state)
+struct inflate_state FAR *state;
+{
+    code_set FAR *set;
+    code_set FAR *use;
+    code FAR *next;
+    code FAR *dist;
+    unsigned k;
+
+    /* note: do not change the lenbits or distbits values here (9 and 6)
+       without reading the comments in inftrees.h concerning the ENOUGH
+       constants, which depend on those values */
+    use = Z_NULL;
+    next = state->codes;
+    state->lenbits = 9;
+    state->distbits = 6;
+    if (state->sets != Z_NULL) {
+        use = state->sets;
+        for (k = 0; k < state->nsets; k++) {
+            set = state->sets + k;
+            if (set->nlen == state->nlen && set->ndist == state->ndist &&
+                zmemcmp(set->lens, state->lens,
+                        (state->nlen + state->ndist) *
+                        sizeof(unsigned short)) == 0) {
+                set->used = ++state->uses;
+                state->lencode = (const code FAR *)(set->lencode);
+                state->lenbits = set->lenbits;
+                state->distcode = (const code FAR *)(set->distcode);
+                state->distbits = set->distbits;
+                Tracev((stderr, "inflate:       codes reused\n"));
+                return 0;
+            }
+            if (set->used < use->used)
+                use = set;
+        }
+        use->nlen = 0;
+        next = use->lencode;
+        state->lenbits = state->rootlen;
+        state->distbits = state->rootdist;
+    }
+
+    /* build the tables */
+    state->lencode = (const code FAR *)next;
+    if (inflate_table(LENS, state->lens, state->nlen, &next,
+                      &(state->lenbits), state->work))
+        return 1;
+    dist = next;
+    state->distcode = (const code FAR *)dist;
+    if (inflate_table(DISTS, state->lens + state->nlen, state->ndist, &next,
+                      &(state->distbits), state->work))
+        return 2;
+    if (use == Z_NULL) {
+        state->next = next;
+        return 0;
+    }
+
+    /* keep the set */
+    use->nlen = state->nlen;
+    use->ndist = state->ndist;
+    use->used = ++state->uses;
+    use->distcode = dist;
+    use->lenbits = state->lenbits;
+    use->distbits = state->distbits;
+    zmemcpy(use->lens, state->lens,
+            (state->nlen + state->ndist) * sizeof(unsigned short));
+    return 0;
+}
+
 /*
    Update the window with the last wsize (normally 32K) bytes written before
    returning.  If window does not exist yet, create it.  This is only called
@@ -444,15 +611,26 @@ unsigned copy;
     return 0;
 }
 
-/* Macros for inflate(): */
+/*
+   Copy the output kept as history after an inflate() call with
+   inflateKeepOutput() in effect to the window, before the application is
+   free to change it.  Return true if the window could not be allocated.
+ */
+local int fillwindow(strm)
+z_streamp strm;
+{
+    struct inflate_state FAR *state;
 
-/* check function to use adler32() for zlib or crc32() for gzip */
-#ifdef GUNZIP
-#  define UPDATE_CHECK(check, buf, len) \
-    (state->flags ? crc32(check, buf, len) : adler32(check, buf, len))
-#else
-#  define UPDATE_CHECK(check, buf, len) adler32(check, buf, len)
-#endif
+    state = (struct inflate_state FAR *)strm->state;
+    if (state->hist == Z_NULL)
+        return 0;
+    if (updatewindow(strm, state->hist, state->hhave))
+        return 1;
+    state->hist = Z_NULL;
+    return 0;
+}
+
+/* Macros for inflate(): */
 
 /* check macros for header crc */
 #ifdef GUNZIP
@@ -637,6 +815,7 @@ int flush;
     code last;                  /* parent table entry */
     unsigned len;               /* length to copy for repeats, bits to drop */
     int ret;                    /* return code */
+    unsigned base;              /* kept output just before next_out */
 #ifdef GUNZIP
     unsigned char hbuf[4];      /* buffer for gzip header crc calculation */
 #endif
@@ -653,6 +832,19 @@ int flush;
     in = have;
     out = left;
     ret = Z_OK;
+    state->chk = state->wrap & 4 ? put : Z_NULL;
+
+    /* use the output kept by the last call as history if this output follows
+       it, or else copy it to the window before the application changes it */
+    base = 0;
+    if (state->hist == put && state->hhave <= (unsigned)(-1) - out) {
+        base = state->hhave;
+        state->hist = Z_NULL;
+    }
+    else if (fillwindow(strm)) {
+        state->mode = MEM;
+        return Z_MEM_ERROR;
+    }
     for (;;)
         switch (state->mode) {
         case HEAD:
@@ -919,7 +1111,13 @@ int flush;
                 if (copy > have) copy = have;
                 if (copy > left) copy = left;
                 if (copy == 0) goto inf_leave;
-                zmemcpy(put, next, copy);
+                if (state->chk != Z_NULL) {     /* check while copying */
+                    UPDATE_UPTO(put);
+                    state->check = UPDATE_COPY(state->check, put, next, copy);
+                    state->chk = put + copy;
+                }
+                else
+                    zmemcpy(put, next, copy);
                 have -= copy;
                 next += copy;
                 left -= copy;
@@ -1029,25 +1227,14 @@ int flush;
                 break;
             }
 
-            /* build code tables -- note: do not change the lenbits or distbits
-               values here (9 and 6) without reading the comments in inftrees.h
-               concerning the ENOUGH constants, which depend on those values */
-            state->next = state->codes;
-            state->lencode = (const code FAR *)(state->next);
-            state->lenbits = 9;
-            ret = inflate_table(LENS, state->lens, state->nlen, &(state->next),
-                                &(state->lenbits), state->work);
-            if (ret) {
-                strm->msg = (char *)"invalid literal/lengths set";
-                state->mode = BAD;
-                break;
-            }
-            state->distcode = (const code FAR *)(state->next);
-            state->distbits = 6;
-            ret = inflate_table(DISTS, state->lens + state->nlen, state->ndist,
-                            &(state->next), &(state->distbits), state->work);
+            /* build code tables, or reuse a kept set */
+#ifdef INFLATE_MULTISYM
+            state->pairsok = 0;
+#endif
+            ret = codetables(state);
             if (ret) {
-                strm->msg = (char *)"invalid distances set";
+                strm->msg = ret == 1 ? (char *)"invalid literal/lengths set" :
+                                       (char *)"invalid distances set";
                 state->mode = BAD;
                 break;
             }
@@ -1059,9 +1246,10 @@ int flush;
             state->mode = LEN;
                 /* fallthrough */
         case LEN:
-            if (have >= 6 && left >= 258) {
+            if (have >= INFLATE_FAST_MIN_HAVE &&
+                left >= INFLATE_FAST_MIN_LEFT) {
                 RESTORE();
-                inflate_fast(strm, out);
+                inflate_fast(strm, out + base);
                 LOAD();
                 if (state->mode == TYPE)
                     state->back = -1;
@@ -1166,7 +1354,7 @@ int flush;
                 /* fallthrough */
         case MATCH:
             if (left == 0) goto inf_leave;
-            copy = out - left;
+            copy = out - left + base;
             if (state->offset > copy) {         /* copy from window */
                 copy = state->offset - copy;
                 if (copy > state->whave) {
@@ -1221,9 +1409,10 @@ int flush;
                 out -= left;
                 strm->total_out += out;
                 state->total += out;
-                if ((state->wrap & 4) && out)
-                    strm->adler = state->check =
-                        UPDATE_CHECK(state->check, put - out, out);
+                if ((state->wrap & 4) && out) {
+                    UPDATE_UPTO(put);
+                    strm->adler = state->check;
+                }
                 out = left;
                 if ((state->wrap & 4) && (
 #ifdef GUNZIP
@@ -1276,8 +1465,22 @@ int flush;
      */
   inf_leave:
     RESTORE();
-    if (state->wsize || (out != strm->avail_out && state->mode < BAD &&
-            (state->mode < CHECK || flush != Z_FINISH)))
+    if ((state->wrap & 4) && out != strm->avail_out) {
+        UPDATE_UPTO(strm->next_out);
+        strm->adler = state->check;
+    }
+    if (state->keep) {
+        /* keep the last wsize bytes of output as history in place */
+        copy = base + (out - strm->avail_out);
+        if (copy > (1U << state->wbits))
+            copy = 1U << state->wbits;
+        if (copy) {
+            state->hist = strm->next_out;
+            state->hhave = copy;
+        }
+    }
+    else if (state->wsize || (out != strm->avail_out && state->mode < BAD &&
+             (state->mode < CHECK || flush != Z_FINISH)))
         if (updatewindow(strm, strm->next_out, out - strm->avail_out)) {
             state->mode = MEM;
             return Z_MEM_ERROR;
@@ -1287,9 +1490,6 @@ int flush;
     strm->total_in += in;
     strm->total_out += out;
     state->total += out;
-    if ((state->wrap & 4) && out)
-        strm->adler = state->check =
-            UPDATE_CHECK(state->check, strm->next_out - out, out);
     strm->data_type = (int)state->bits + (state->last ? 64 : 0) +
                       (state->mode == TYPE ? 128 : 0) +
                       (state->mode == LEN_ || state->mode == COPY_ ? 256 : 0);
@@ -1306,6 +1506,10 @@ z_streamp strm;
         return Z_STREAM_ERROR;
     state = (struct inflate_state FAR *)strm->state;
     if (state->window != Z_NULL) ZFREE(strm, state->window);
+    if (state->sets != Z_NULL) {
+        ZFREE(strm, state->setcodes);
+        ZFREE(strm, state->sets);
+    }
     ZFREE(strm, strm->state);
     strm->state = Z_NULL;
     Tracev((stderr, "inflate: end\n"));
@@ -1322,6 +1526,10 @@ uInt *dictLength;
     /* check state */
     if (inflateStateCheck(strm)) return Z_STREAM_ERROR;
     state = (struct inflate_state FAR *)strm->state;
+    if (fillwindow(strm)) {
+        state->mode = MEM;
+        return Z_MEM_ERROR;
+    }
 
     /* copy dictionary */
     if (state->whave && dictionary != Z_NULL) {
@@ -1360,7 +1568,8 @@ uInt dictLength;
 
     /* copy dictionary to window using updatewindow(), which will amend the
        existing dictionary if appropriate */
-    ret = updatewindow(strm, dictionary + dictLength, dictLength);
+    ret = fillwindow(strm) ||
+          updatewindow(strm, dictionary + dictLength, dictLength);
     if (ret) {
         state->mode = MEM;
         return Z_MEM_ERROR;
@@ -1405,10 +1614,67 @@ unsigned len;
 {
     unsigned got;
     unsigned next;
+#if defined(Z_X86_SIMD)
+    unsigned mask;
+    __m128i zero, ones;
+
+    zero = _mm_setzero_si128();
+    ones = _mm_cmpeq_epi8(zero, zero);
+#elif defined(Z_ARM_SIMD)
+    uint8x16_t hit;
+    uint64_t mask;
+#endif
 
     got = *have;
     next = 0;
     while (next < len && got < 4) {
+#if defined(Z_X86_SIMD)
+        /* When no part of the pattern is pending, skip ahead sixteen possible
+           starting positions at a time with SSE2.  The bytes at offsets zero
+           and one from each position are or'ed and compared with zero, and
+           the bytes at offsets two and three are and'ed and compared with
+           0xff, so a set bit in the mask is a complete pattern, and the byte
+           loop takes over from the first one.  The last three bytes are
+           always left to the byte loop, which then leaves *have as it would
+           be from the byte loop alone. */
+        if (got == 0)
+            while (len - next >= 16 + 3) {
+                mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(
+                    _mm_cmpeq_epi8(_mm_or_si128(
+                        _mm_loadu_si128((const __m128i *)(buf + next)),
+                        _mm_loadu_si128((const __m128i *)(buf + next + 1))),
+                        zero),
+                    _mm_cmpeq_epi8(_mm_and_si128(
+                        _mm_loadu_si128((const __m128i *)(buf + next + 2)),
+                        _mm_loadu_si128((const __m128i *)(buf + next + 3))),
+                        ones)));
+                if (mask) {
+                    next += z_ctz32(mask);
+                    break;
+                }
+                next += 16;
+            }
+#elif defined(Z_ARM_SIMD)
+        /* The same with NEON.  NEON has no movemask, so the byte comparison
+           result is narrowed to four bits per byte in a 64-bit value, and the
+           trailing zero count divided by four. */
+        if (got == 0)
+            while (len - next >= 16 + 3) {
+                hit = vandq_u8(
+                    vceqzq_u8(vorrq_u8(vld1q_u8(buf + next),
+                                       vld1q_u8(buf + next + 1))),
+                    vandq_u8(vld1q_u8(buf + next + 2),
+                             vld1q_u8(buf + next + 3)));
+                mask = vget_lane_u64(vreinterpret_u64_u8(
+                    vshrn_n_u16(vreinterpretq_u16_u8(
+                        vceqq_u8(hit, vdupq_n_u8(0xff))), 4)), 0);
+                if (mask) {
+                    next += z_ctz64(mask) >> 2;
+                    break;
+                }
+                next += 16;
+            }
+#endif
         if ((int)(buf[next]) == (got < 2 ? 0 : 0xff))
             got++;
         else if (buf[next])
@@ -1497,11 +1763,15 @@ z_streamp source;
     struct inflate_state FAR *copy;
     unsigned char FAR *window;
     unsigned wsize;
+    code_set FAR *sets;
+    code FAR *codes;
+    unsigned size, k;
 
     /* check input */
     if (inflateStateCheck(source) || dest == Z_NULL)
         return Z_STREAM_ERROR;
     state = (struct inflate_state FAR *)source->state;
+    if (fillwindow(source)) return Z_MEM_ERROR;
 
     /* allocate space */
     copy = (struct inflate_state FAR *)
@@ -1516,6 +1786,22 @@ z_streamp source;
             return Z_MEM_ERROR;
         }
     }
+    sets = Z_NULL;
+    codes = Z_NULL;
+    size = 0;
+    if (state->sets != Z_NULL) {
+        size = ENOUGH_LENS_ROOT(state->rootlen) +
+               ENOUGH_DISTS_ROOT(state->rootdist);
+        sets = (code_set FAR *)ZALLOC(source, state->nsets, sizeof(code_set));
+        codes = (code FAR *)ZALLOC(source, state->nsets * size, sizeof(code));
+        if (sets == Z_NULL || codes == Z_NULL) {
+            if (sets != Z_NULL) ZFREE(source, sets);
+            if (codes != Z_NULL) ZFREE(source, codes);
+            if (window != Z_NULL) ZFREE(source, window);
+            ZFREE(source, copy);
+            return Z_MEM_ERROR;
+        }
+    }
 
     /* copy state */
     zmemcpy((voidpf)dest, (voidpf)source, sizeof(z_stream));
@@ -1526,6 +1812,25 @@ z_streamp source;
         copy->lencode = copy->codes + (state->lencode - state->codes);
         copy->distcode = copy->codes + (state->distcode - state->codes);
     }
+    if (sets != Z_NULL) {
+        zmemcpy((voidpf)sets, (voidpf)state->sets,
+                state->nsets * sizeof(code_set));
+        zmemcpy((voidpf)codes, (voidpf)state->setcodes,
+                state->nsets * size * sizeof(code));
+        for (k = 0; k < state->nsets; k++) {
+            sets[k].lencode = codes + (state->sets[k].lencode -
+                                       state->setcodes);
+            sets[k].distcode = codes + (state->sets[k].distcode -
+                                        state->setcodes);
+        }
+        if (state->lencode >= state->setcodes &&
+            state->lencode <= state->setcodes + state->nsets * size - 1) {
+            copy->lencode = codes + (state->lencode - state->setcodes);
+            copy->distcode = codes + (state->distcode - state->setcodes);
+        }
+        copy->sets = sets;
+        copy->setcodes = codes;
+    }
     copy->next = copy->codes + (state->next - state->codes);
     if (window != Z_NULL) {
         wsize = 1U << state->wbits;
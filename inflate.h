@@ -77,8 +77,27 @@ typedef enum {
         CHECK -> LENGTH -> DONE
  */
 
-/* State maintained between inflate() calls -- approximately 7K bytes, not
-   including the allocated sliding window, which is up to 32K bytes. */
+/* A set of decoding tables for a dynamic block, kept by inflate() to reuse
+   for later blocks with the same code lengths, when enabled by inflateTune().
+   nlen is zero if the set has not been built. */
+typedef struct {
+    unsigned nlen;              /* number of length code lengths */
+    unsigned ndist;             /* number of distance code lengths */
+    unsigned long used;         /* when last used, to replace the oldest */
+    code FAR *lencode;          /* table for length/literal codes */
+    code FAR *distcode;         /* table for distance codes */
+    unsigned lenbits;           /* index bits for lencode */
+    unsigned distbits;          /* index bits for distcode */
+    unsigned short lens[320];   /* code lengths the tables were built from */
+} code_set;
+
+/* Most sets of decoding tables permitted by inflateTune() */
+#define MAX_SETS 16
+
+/* State maintained between inflate() calls -- approximately 7K bytes, or 15K
+   with INFLATE_MULTISYM, not including the allocated sliding window, which is
+   up to 32K bytes, or the sets of decoding tables allocated by
+   inflateTune(). */
 struct inflate_state {
     z_streamp strm;             /* pointer back to this zlib stream */
     inflate_mode mode;          /* current inflate mode */
@@ -91,6 +110,10 @@ struct inflate_state {
     unsigned dmax;              /* zlib header max distance (INFLATE_STRICT) */
     unsigned long check;        /* protected copy of check value */
     unsigned long total;        /* protected copy of output count */
+    unsigned char FAR *chk;     /* output of this call not yet in check, or
+                                   Z_NULL if check is not being computed */
+    int exact;                  /* true if nothing may be written past the
+                                   output, since it is inflateBack()'s window */
     gz_headerp head;            /* where to save gzip header information */
         /* sliding window */
     unsigned wbits;             /* log base 2 of requested window size */
@@ -123,4 +146,45 @@ struct inflate_state {
     int sane;                   /* if false, allow invalid distance too far */
     int back;                   /* bits back of last unprocessed length/lit */
     unsigned was;               /* initial length of match */
+        /* output kept as history, see inflateKeepOutput() */
+    int keep;                   /* true to keep output instead of copying */
+    unsigned char FAR *hist;    /* end of kept output, or Z_NULL if none */
+    unsigned hhave;             /* bytes of kept output ending at hist */
+        /* decoding tables kept for reuse */
+    code_set FAR *sets;         /* table sets, or Z_NULL to use codes[] */
+    code FAR *setcodes;         /* space for the tables of the sets */
+    unsigned nsets;             /* number of sets in sets[] */
+    unsigned rootlen;           /* lenbits to request for a set */
+    unsigned rootdist;          /* distbits to request for a set */
+    unsigned long uses;         /* number of times a set was used */
+#ifdef INFLATE_MULTISYM
+    int pairsok;                /* true if lenpair[] was built for lencode */
+    code lenpair[1U << MAX_LENBITS];    /* lencode root table with pairs,
+                                           8K bytes */
+#endif
 };
+
+/* check functions to use adler32() for zlib or crc32() for gzip, the second
+   also copying len bytes from src to dst */
+#ifdef GUNZIP
+#  define UPDATE_CHECK(check, buf, len) \
+    (state->flags ? crc32(check, buf, len) : adler32(check, buf, len))
+#  define UPDATE_COPY(check, dst, src, len) \
+    (state->flags ? crc32_copy(check, dst, src, len) : \
+                    adler32_copy(check, dst, src, len))
+#else
+#  define UPDATE_CHECK(check, buf, len) adler32(check, buf, len)
+#  define UPDATE_COPY(check, dst, src, len) adler32_copy(check, dst, src, len)
+#endif
+
+/* Update the check value with the output from state->chk up to end, if the
+   check value is being computed.  inflate() and inflate_fast() do this as
+   they go, so that the output is still in the cache when it is read back. */
+#define UPDATE_UPTO(end) \
+    do { \
+        if (state->chk != Z_NULL && (end) != state->chk) { \
+            state->check = UPDATE_CHECK(state->check, state->chk, \
+                                        (unsigned)((end) - state->chk)); \
+            state->chk = (end); \
+        } \
+    } while (0)
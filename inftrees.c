@@ -167,9 +167,10 @@ unsigned short FAR *work;
 
        used keeps track of how many table entries have been allocated from the
        provided *table space.  It is checked for LENS and DIST tables against
-       the constants ENOUGH_LENS and ENOUGH_DISTS to guard against changes in
-       the initial root table size constants.  See the comments in inftrees.h
-       for more information.
+       the maximum sizes ENOUGH_LENS_ROOT() and ENOUGH_DISTS_ROOT() for the
+       requested root table size, to guard against changes in the initial
+       root table size constants.  See the comments in inftrees.h for more
+       information.
 
        sym increments through all symbols, and the loop terminates when
        all codes of length max, i.e. all codes, have been processed.  This
@@ -206,8 +207,8 @@ unsigned short FAR *work;
     mask = used - 1;            /* mask for comparing low */
 
     /* check available table space */
-    if ((type == LENS && used > ENOUGH_LENS) ||
-        (type == DISTS && used > ENOUGH_DISTS))
+    if ((type == LENS && used > ENOUGH_LENS_ROOT(*bits)) ||
+        (type == DISTS && used > ENOUGH_DISTS_ROOT(*bits)))
         return 1;
 
     /* process all codes and make table entries */
@@ -275,8 +276,8 @@ unsigned short FAR *work;
 
             /* check for enough space */
             used += 1U << curr;
-            if ((type == LENS && used > ENOUGH_LENS) ||
-                (type == DISTS && used > ENOUGH_DISTS))
+            if ((type == LENS && used > ENOUGH_LENS_ROOT(*bits)) ||
+                (type == DISTS && used > ENOUGH_DISTS_ROOT(*bits)))
                 return 1;
 
             /* point entry in root table to sub-table */
@@ -302,3 +303,42 @@ unsigned short FAR *work;
     *bits = root;
     return 0;
 }
+
+#ifdef INFLATE_MULTISYM
+/*
+   Build the literal pair table for the root table of a literal/length code,
+   which has 2^bits entries, bits <= MAX_LENBITS.  An index whose bits start
+   with a literal code in the root table gets an entry with op 130 if a
+   second literal code follows within the index bits, with the first literal
+   in the low byte of val and the second in the high byte, or op 129 if not,
+   with bits the total bits of the literal codes.  Any other index gets a
+   copy of the root table entry.
+ */
+void ZLIB_INTERNAL inflate_pairs(pairs, table, bits)
+code FAR *pairs;
+const code FAR *table;
+unsigned bits;
+{
+    unsigned index;             /* root table index */
+    code here;                  /* first code */
+    code next;                  /* code after that */
+
+    for (index = 0; index < (1U << bits); index++) {
+        here = table[index];
+        if (here.op == 0) {                     /* literal */
+            /* the bits after the first code are the low bits of index >>
+               here.bits, which decide the entry there if its code is short
+               enough to lie entirely within them */
+            next = table[index >> here.bits];
+            if (next.op == 0 && next.bits <= bits - here.bits) {
+                here.op = (unsigned char)130;
+                here.bits = (unsigned char)(here.bits + next.bits);
+                here.val = (unsigned short)(here.val + (next.val << 8));
+            }
+            else
+                here.op = (unsigned char)129;
+        }
+        pairs[index] = here;
+    }
+}
+#endif
@@ -33,6 +33,7 @@ typedef struct {
     0001eeee - length or distance, eeee is the number of extra bits
     01100000 - end of block
     01000000 - invalid code
+    1000000n - n literals, only in the table built by inflate_pairs()
  */
 
 /* Maximum size of the dynamic table.  The maximum number of code structures is
@@ -50,6 +51,17 @@ typedef struct {
 #define ENOUGH_DISTS 592
 #define ENOUGH (ENOUGH_LENS+ENOUGH_DISTS)
 
+/* inflateTune() permits larger root tables, up to MAX_LENBITS for
+   literal/length codes and MAX_DISTBITS for distance codes.  "enough 286 10
+   15" returns 1332, "enough 286 11 15" returns 2340, and "enough 30 7 15" and
+   "enough 30 8 15" both return 400.  These give the maximum sizes for a
+   requested root table size of root bits. */
+#define MAX_LENBITS 11
+#define MAX_DISTBITS 8
+#define ENOUGH_LENS_ROOT(root) \
+    ((root) <= 9 ? ENOUGH_LENS : (root) == 10 ? 1332 : 2340)
+#define ENOUGH_DISTS_ROOT(root) ((root) <= 6 ? ENOUGH_DISTS : 400)
+
 /* Type of code to build for inflate_table() */
 typedef enum {
     CODES,
@@ -60,3 +72,14 @@ typedef enum {
 int ZLIB_INTERNAL inflate_table OF((codetype type, unsigned short FAR *lens,
                              unsigned codes, code FAR * FAR *table,
                              unsigned FAR *bits, unsigned short FAR *work));
+
+/* With INFLATE_MULTISYM defined, inflate_fast() looks up the root index bits
+   of a literal/length code in a copy of the root table built by
+   inflate_pairs(), in which the entries for literals give one or two
+   literals at once.  There op is 128 plus the number of literals, bits is
+   the total bits of the literal codes, and val has the first literal in its
+   low byte and the second in its high byte. */
+#ifdef INFLATE_MULTISYM
+void ZLIB_INTERNAL inflate_pairs OF((code FAR *pairs, const code FAR *table,
+                                     unsigned bits));
+#endif
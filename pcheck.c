@@ -0,0 +1,132 @@
+/* pcheck.c -- compute a check value of a memory buffer using several threads
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/*
+   crc32_parallel() and adler32_parallel() cut the buffer into pieces of equal
+   length, except for a shorter last piece, and compute the check value of
+   each piece on its own, as many at once as there are threads. Each thread
+   takes the next piece not yet taken until there are none left, so a thread
+   that is slowed down does not hold up the others for long. The check values
+   of the pieces are then combined in order with crc32_combine_op(), using an
+   operator generated once for the piece length, or with adler32_combine64().
+   The result is the same as from crc32_z() or adler32_z() on the whole
+   buffer, whatever the number of threads.
+
+   The pieces are no shorter than PIECE_MIN, so that the time to start a
+   thread is small compared to the time to check a piece, and there are up to
+   PIECES_PER pieces per thread, to even out the load.
+ */
+
+#include "zthread.h"
+
+#define PIECE_MIN 1048576UL     /* fewest bytes in a piece */
+#define PIECES_PER 4            /* most pieces per thread */
+
+/* State shared by the threads. next may only be used while holding the lock.
+   Each val[k] is written by the one thread that took piece k. */
+typedef struct {
+    int adler;              /* true for Adler-32, false for CRC-32 */
+    const Bytef *buf;       /* data to check */
+    z_size_t len;           /* length of the data */
+    z_size_t piece;         /* length of all but the last piece */
+    unsigned pieces;        /* number of pieces */
+    z_lock lock;
+    unsigned next;          /* next piece to check */
+    uLong val[PIECES_PER * Z_MAX_THREADS];  /* check values of the pieces */
+} chk_state;
+
+/* ===========================================================================
+ * Check pieces until there are none left. This is run by each of the threads.
+ */
+local void chk_work OF((voidpf arg));
+local void chk_work(arg)
+    voidpf arg;
+{
+    chk_state *chk = (chk_state *)arg;
+    const Bytef *next;
+    z_size_t len;
+    unsigned k;
+
+    z_acquire(&chk->lock);
+    while (chk->next < chk->pieces) {
+        k = chk->next++;
+        z_release(&chk->lock);
+        next = chk->buf + k * chk->piece;
+        len = k == chk->pieces - 1 ? chk->len - k * chk->piece : chk->piece;
+        chk->val[k] = chk->adler ? adler32_z(1L, next, len) :
+                                   crc32_z(0L, next, len);
+        z_acquire(&chk->lock);
+    }
+    z_release(&chk->lock);
+}
+
+/* ===========================================================================
+ * Return the check value val updated with buf[0..len-1], computed with up to
+ * threads threads, for Adler-32 if adler is true, otherwise for CRC-32.
+ */
+local uLong chk_parallel OF((int adler, uLong val, const Bytef *buf,
+                             z_size_t len, int threads));
+local uLong chk_parallel(adler, val, buf, len, threads)
+    int adler;
+    uLong val;
+    const Bytef *buf;
+    z_size_t len;
+    int threads;
+{
+    chk_state chk;
+    uLong op = 0;
+    unsigned k;
+
+    /* see how many threads are worth starting */
+    threads = z_threads(threads);
+    if (buf == Z_NULL || threads == 1 || len < 2 * PIECE_MIN ||
+        z_lock_init(&chk.lock))
+        return adler ? adler32_z(val, buf, len) : crc32_z(val, buf, len);
+    chk.pieces = PIECES_PER * (unsigned)threads;
+    if (len / PIECE_MIN < chk.pieces)
+        chk.pieces = (unsigned)(len / PIECE_MIN);
+    chk.piece = (len - 1) / chk.pieces + 1;
+    chk.pieces = (unsigned)((len - 1) / chk.piece + 1);
+    if ((unsigned)threads > chk.pieces)
+        threads = (int)chk.pieces;
+
+    /* check the pieces */
+    chk.adler = adler;
+    chk.buf = buf;
+    chk.len = len;
+    chk.next = 0;
+    z_run(threads, chk_work, &chk);
+    z_lock_free(&chk.lock);
+
+    /* combine the check values in order */
+    if (!adler)
+        op = crc32_combine_gen64((z_off64_t)chk.piece);
+    for (k = 0; k < chk.pieces - 1; k++)
+        val = adler ? adler32_combine64(val, chk.val[k],
+                                        (z_off64_t)chk.piece) :
+                      crc32_combine_op(val, chk.val[k], op);
+    len -= k * chk.piece;
+    return adler ? adler32_combine64(val, chk.val[k], (z_off64_t)len) :
+                   crc32_combine64(val, chk.val[k], (z_off64_t)len);
+}
+
+/* ========================================================================= */
+uLong ZEXPORT crc32_parallel(crc, buf, len, threads)
+    uLong crc;
+    const Bytef *buf;
+    z_size_t len;
+    int threads;
+{
+    return chk_parallel(0, crc, buf, len, threads);
+}
+
+/* ========================================================================= */
+uLong ZEXPORT adler32_parallel(adler, buf, len, threads)
+    uLong adler;
+    const Bytef *buf;
+    z_size_t len;
+    int threads;
+{
+    return chk_parallel(1, adler, buf, len, threads);
+}
@@ -0,0 +1,370 @@
+/* pcompress.c -- compress a memory buffer using several threads
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/*
+   compressParallel() cuts the input into chunks of a fixed size and deflates
+   the chunks independently, as many at once as there are threads. Each chunk
+   is primed with the window's worth of input that precedes it using
+   deflateSetDictionary(), so little compression is lost at the cuts. All but
+   the last chunk end with a sync flush, which leaves the chunk on a byte
+   boundary without marking the last block, so the compressed chunks can be
+   simply concatenated. The check values of the chunks are combined in order
+   with adler32_combine() or crc32_combine_op(), and the wrapper is written
+   around the result as deflate() would, making one ordinary zlib or gzip
+   stream.
+
+   The chunks are written to dest in order as they complete, by whichever
+   thread completes the next one. A thread does not start a chunk that would
+   get more than twice as many chunks ahead of the writing as there are
+   threads, which bounds the memory used for compressed chunks waiting to be
+   written. The compressed data depends only on the source, level, windowBits,
+   and chunkSize, and not on the number of threads or their timing.
+ */
+
+#include "zthread.h"
+
+#define CHUNK_DEFAULT 131072UL  /* chunk size if chunkSize is zero */
+#define CHUNK_MAX 1073741824UL  /* largest chunk size (so it fits a z_off_t) */
+
+/* A compressed chunk waiting to be written. Chunk k goes in slot k % slots. */
+typedef struct {
+    Bytef *buf;         /* compressed data, CHUNK_BOUND(chunk) bytes */
+    uLong len;          /* length of the compressed data */
+    uLong check;        /* adler32 or crc32 of the uncompressed data */
+    int done;           /* true if the chunk is ready to be written */
+} par_slot;
+
+/* State shared by the threads. The values after lock may only be used while
+   holding the lock, except for dest[have..] while writing is set. */
+typedef struct {
+    const Bytef *source;    /* input */
+    uLong sourceLen;        /* length of the input */
+    uLong chunk;            /* uncompressed size of all but the last chunk */
+    uLong chunks;           /* number of chunks, at least one */
+    int level;              /* compression level */
+    int bits;               /* log base 2 of the window size */
+    int wrap;               /* 0 for raw, 1 for zlib, 2 for gzip */
+    uLong op;               /* crc32_combine_op() operator for chunk bytes */
+    Bytef *dest;            /* output */
+    uLong size;             /* space in dest */
+    par_slot *slot;         /* compressed chunks */
+    unsigned slots;         /* number of slots */
+    uLong bound;            /* size of each slot's buffer */
+    z_lock lock;
+    uLong next;             /* next chunk to compress */
+    uLong out;              /* next chunk to write */
+    int writing;            /* true if a thread is writing chunks to dest */
+    uLong have;             /* bytes written to dest so far */
+    uLong check;            /* combined check value of the written chunks */
+    int err;                /* Z_OK, or the first error */
+} par_state;
+
+/* Upper bound on the raw deflate output for a chunk of len bytes that ends
+   with a sync flush, using deflateBound()'s bounds for the default memLevel
+   and the given window size, plus five bytes for the flush. */
+#define CHUNK_BOUND(len, bits) ((bits) == MAX_WBITS ? \
+    (len) + ((len) >> 12) + ((len) >> 14) + ((len) >> 25) + 7 + 5 : \
+    (len) + (((len) + 7) >> 3) + (((len) + 63) >> 6) + 5 + 5)
+
+/* ===========================================================================
+ * Decode windowBits as deflateInit2() does, setting *wrap, and return the
+ * window bits, or zero if windowBits is not valid.
+ */
+local int par_bits OF((int windowBits, int *wrap));
+local int par_bits(windowBits, wrap)
+    int windowBits;
+    int *wrap;
+{
+    *wrap = 1;
+    if (windowBits < 0) {
+        *wrap = 0;
+        if (windowBits < -15)
+            return 0;
+        windowBits = -windowBits;
+    }
+#ifndef NO_GZIP
+    else if (windowBits > 15) {
+        *wrap = 2;
+        windowBits -= 16;
+    }
+#endif
+    if (windowBits < 8 || windowBits > 15 || (windowBits == 8 && *wrap != 1))
+        return 0;
+    return windowBits == 8 ? 9 : windowBits;
+}
+
+/* ===========================================================================
+ * Return the chunk size to use for chunkSize.
+ */
+local uLong par_chunk OF((uLong chunkSize));
+local uLong par_chunk(chunkSize)
+    uLong chunkSize;
+{
+    return chunkSize == 0 ? CHUNK_DEFAULT :
+           chunkSize > CHUNK_MAX ? CHUNK_MAX : chunkSize;
+}
+
+/* ===========================================================================
+ * Compress chunk k into slot, using strm, which was initialized for raw
+ * deflate with the parameters in par. Return Z_OK or an error.
+ */
+local int par_deflate OF((par_state *par, z_streamp strm, uLong k,
+                          par_slot *slot));
+local int par_deflate(par, strm, k, slot)
+    par_state *par;
+    z_streamp strm;
+    uLong k;
+    par_slot *slot;
+{
+    const Bytef *next;
+    uLong len;
+    uInt dict;
+    int last, ret;
+
+    next = par->source + k * par->chunk;
+    last = k == par->chunks - 1;
+    len = last ? par->sourceLen - k * par->chunk : par->chunk;
+
+    ret = deflateReset(strm);
+    if (ret == Z_OK && k) {
+        dict = k * par->chunk < (1UL << par->bits) ?
+               (uInt)(k * par->chunk) : 1U << par->bits;
+        ret = deflateSetDictionary(strm, next - dict, dict);
+    }
+    if (ret != Z_OK)
+        return ret;
+    strm->next_in = (z_const Bytef *)next;
+    strm->avail_in = (uInt)len;
+    strm->next_out = slot->buf;
+    strm->avail_out = (uInt)par->bound;
+    ret = deflate(strm, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (last ? ret != Z_STREAM_END : ret != Z_OK || strm->avail_out == 0)
+        return ret == Z_OK ? Z_BUF_ERROR : ret;
+    slot->len = par->bound - strm->avail_out;
+    if (par->wrap == 2)
+        slot->check = crc32_z(0, next, (z_size_t)len);
+    else if (par->wrap == 1)
+        slot->check = adler32_z(1, next, (z_size_t)len);
+    return Z_OK;
+}
+
+/* ===========================================================================
+ * Write the completed chunks that are next in order to dest. Called with the
+ * lock held and writing clear. The lock is released during the copies.
+ */
+local void par_write OF((par_state *par));
+local void par_write(par)
+    par_state *par;
+{
+    par_slot *slot;
+    uLong len;
+
+    par->writing = 1;
+    while (par->err == Z_OK && par->out < par->chunks &&
+           par->slot[par->out % par->slots].done) {
+        slot = par->slot + par->out % par->slots;
+        if (slot->len > par->size - par->have) {
+            par->err = Z_BUF_ERROR;
+            break;
+        }
+        z_release(&par->lock);
+        zmemcpy(par->dest + par->have, slot->buf, slot->len);
+        z_acquire(&par->lock);
+        len = par->out == par->chunks - 1 ?
+              par->sourceLen - par->out * par->chunk : par->chunk;
+        if (par->wrap == 2)
+            par->check = len == par->chunk ?
+                crc32_combine_op(par->check, slot->check, par->op) :
+                crc32_combine(par->check, slot->check, (z_off_t)len);
+        else if (par->wrap == 1)
+            par->check = adler32_combine(par->check, slot->check,
+                                         (z_off_t)len);
+        par->have += slot->len;
+        slot->done = 0;
+        par->out++;
+    }
+    par->writing = 0;
+    z_wake(&par->lock);
+}
+
+/* ===========================================================================
+ * Compress and write chunks until there are none left or there is an error.
+ * This is run by each of the threads.
+ */
+local void par_work OF((voidpf arg));
+local void par_work(arg)
+    voidpf arg;
+{
+    par_state *par = (par_state *)arg;
+    z_stream strm;
+    par_slot *slot;
+    uLong k;
+    int init, ret;
+
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    init = deflateInit2(&strm, par->level, Z_DEFLATED, -par->bits,
+                        DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    z_acquire(&par->lock);
+    if (init != Z_OK && par->err == Z_OK)
+        par->err = init;
+    for (;;) {
+        while (par->err == Z_OK && par->next < par->chunks &&
+               par->next - par->out >= par->slots)
+            z_wait(&par->lock);
+        if (par->err != Z_OK || par->next == par->chunks)
+            break;
+        k = par->next++;
+        slot = par->slot + k % par->slots;
+        z_release(&par->lock);
+        ret = par_deflate(par, &strm, k, slot);
+        z_acquire(&par->lock);
+        if (ret != Z_OK) {
+            if (par->err == Z_OK)
+                par->err = ret;
+            break;
+        }
+        slot->done = 1;
+        if (!par->writing)
+            par_write(par);
+    }
+    z_wake(&par->lock);
+    z_release(&par->lock);
+    if (init == Z_OK)
+        deflateEnd(&strm);
+}
+
+/* ===========================================================================
+ */
+int ZEXPORT compressParallel(dest, destLen, source, sourceLen, level,
+                             windowBits, threads, chunkSize)
+    Bytef *dest;
+    uLongf *destLen;
+    const Bytef *source;
+    uLong sourceLen;
+    int level;
+    int windowBits;
+    int threads;
+    uLong chunkSize;
+{
+    par_state par;
+    unsigned n;
+    uLong head, trail;
+
+    par.size = *destLen;
+    *destLen = 0;
+    if (level == Z_DEFAULT_COMPRESSION)
+        level = 6;
+    par.bits = par_bits(windowBits, &par.wrap);
+    if (level < 0 || level > Z_OPTIMAL_COMPRESSION || par.bits == 0)
+        return Z_STREAM_ERROR;
+#ifdef FASTEST
+    if (level != 0) level = 1;
+#endif
+    par.level = level;
+    par.source = source;
+    par.sourceLen = sourceLen;
+    par.chunk = par_chunk(chunkSize);
+    par.chunks = sourceLen == 0 ? 1 : (sourceLen - 1) / par.chunk + 1;
+    par.bound = CHUNK_BOUND(par.chunk, par.bits);
+    if (par.bound != (uInt)par.bound)
+        return Z_STREAM_ERROR;
+    par.dest = dest;
+
+    /* write the header */
+    head = par.wrap == 2 ? 10 : par.wrap == 1 ? 2 : 0;
+    trail = par.wrap == 2 ? 8 : par.wrap == 1 ? 4 : 0;
+    if (par.size < head + trail)
+        return Z_BUF_ERROR;
+    if (par.wrap == 1) {
+        uInt header = (Z_DEFLATED + ((par.bits - 8) << 4)) << 8;
+
+        header |= (level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6;
+        header += 31 - (header % 31);
+        dest[0] = (Bytef)(header >> 8);
+        dest[1] = (Bytef)header;
+        par.check = adler32(0L, Z_NULL, 0);
+    }
+    else if (par.wrap == 2) {
+        dest[0] = 31;
+        dest[1] = 139;
+        dest[2] = 8;
+        dest[3] = dest[4] = dest[5] = dest[6] = dest[7] = 0;
+        dest[8] = level >= 9 ? 2 : level < 2 ? 4 : 0;
+        dest[9] = OS_CODE;
+        par.check = crc32(0L, Z_NULL, 0);
+        par.op = crc32_combine_gen((z_off_t)par.chunk);
+    }
+    par.size -= trail;
+    par.have = head;
+
+    /* compress the chunks, with up to 2 * threads in progress or waiting */
+    threads = z_threads(threads);
+    if ((uLong)threads > par.chunks)
+        threads = (int)par.chunks;
+    par.slots = par.chunks < 2 * (unsigned)threads ? (unsigned)par.chunks :
+                                                     2 * (unsigned)threads;
+    par.slot = (par_slot *)malloc(par.slots * sizeof(par_slot));
+    if (par.slot == NULL)
+        return Z_MEM_ERROR;
+    par.err = Z_OK;
+    for (n = 0; n < par.slots; n++) {
+        par.slot[n].done = 0;
+        par.slot[n].buf = (Bytef *)malloc((size_t)par.bound);
+        if (par.slot[n].buf == NULL)
+            par.err = Z_MEM_ERROR;
+    }
+    if (par.err == Z_OK && z_lock_init(&par.lock))
+        par.err = Z_MEM_ERROR;
+    if (par.err == Z_OK) {
+        par.next = 0;
+        par.out = 0;
+        par.writing = 0;
+        z_run(threads, par_work, &par);
+        z_lock_free(&par.lock);
+    }
+    for (n = 0; n < par.slots; n++)
+        free(par.slot[n].buf);
+    free(par.slot);
+
+    /* write the trailer */
+    *destLen = par.have;
+    if (par.err != Z_OK)
+        return par.err;
+    if (par.wrap == 1) {
+        dest[par.have++] = (Bytef)(par.check >> 24);
+        dest[par.have++] = (Bytef)(par.check >> 16);
+        dest[par.have++] = (Bytef)(par.check >> 8);
+        dest[par.have++] = (Bytef)par.check;
+    }
+    else if (par.wrap == 2) {
+        for (n = 0; n < 4; n++)
+            dest[par.have++] = (Bytef)(par.check >> (8 * n));
+        for (n = 0; n < 4; n++)
+            dest[par.have++] = (Bytef)(sourceLen >> (8 * n));
+    }
+    *destLen = par.have;
+    return Z_OK;
+}
+
+/* ===========================================================================
+ */
+uLong ZEXPORT compressParallelBound(sourceLen, windowBits, chunkSize)
+    uLong sourceLen;
+    int windowBits;
+    uLong chunkSize;
+{
+    int bits, wrap;
+    uLong chunk, rest;
+
+    bits = par_bits(windowBits, &wrap);
+    if (bits == 0)
+        bits = 9;               /* for the largest bound */
+    chunk = par_chunk(chunkSize);
+    rest = sourceLen % chunk;
+    return (wrap == 2 ? 18 : wrap == 1 ? 6 : 0) +
+           (sourceLen / chunk) * CHUNK_BOUND(chunk, bits) +
+           (rest || sourceLen == 0 ? CHUNK_BOUND(rest, bits) : 0);
+}
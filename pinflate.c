@@ -0,0 +1,1088 @@
+/* pinflate.c -- decompress a memory buffer using several threads
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/*
+   inflateParallel() cuts the deflate data of a stream into chunks of
+   PIN_CHUNK compressed bytes, and decodes a round of chunks at once, one per
+   thread. Only the first chunk of a round is known to start on a block. For
+   each of the other chunks, the first bit position in the chunk where there
+   is a dynamic or stored block header, followed by a block that decodes
+   without error, is taken as a guess of where a block starts.
+
+   Each chunk is decoded from its guess without knowing the window of output
+   that precedes it. The decoded symbols are 16 bits, either a literal byte,
+   or for a match that reaches back before the start of the chunk, 256 plus
+   the position of the byte in that unknown window. A chunk is decoded until
+   it gets to a block boundary that is the guess of a later chunk, or that is
+   past the end of the round.
+
+   The chunks are then linked, starting from the first one, each to the
+   chunk whose guess it ended on. A wrong guess is never linked to, and its
+   work is lost. Along that chain, each chunk's window is made from the window
+   of the chunk before and that chunk's output. Then the window references in
+   all of the chunks are resolved and the check values computed, again in
+   parallel. The output is delivered in order, and the next round starts
+   where the last chunk in the chain stopped.
+
+   If a chunk in the chain could not be decoded, for invalid data or for too
+   much output, decoding continues from its start with inflate(), which
+   reports any error, up to the end of the round. inflate() also does all of
+   the work if there is only one thread or too little input to share.
+ */
+
+#include "zthread.h"
+#include "inftrees.h"
+#include "inffixed.h"
+
+#define PIN_CHUNK 1048576UL     /* compressed bytes per chunk */
+#define PIN_OUT (16 * PIN_CHUNK)    /* symbols after which to stop a chunk */
+#define PIN_WIN 32768U          /* largest window */
+#define PIN_BUF 65536U          /* output buffer for inflate() */
+#define PIN_LENBITS 10          /* root bits for literal/length tables */
+#define PIN_DISTBITS 8          /* root bits for distance tables */
+#define PIN_NONE ((z_size_t)-1) /* no bit position */
+#define PIN_ROOM (258 + 3)      /* room for a match copied four at a time */
+#define PIN_TRAIL 8             /* longest trailer, for gzip */
+
+/* How decoding of a chunk stopped */
+#define PIN_NEXT 1      /* at the guess of chunk next */
+#define PIN_SPLIT 2     /* at a block boundary past the round or PIN_OUT */
+#define PIN_LAST 3      /* at the end of the last block */
+#define PIN_FAIL 4      /* on invalid data or too much output */
+
+/* Bit buffer, at least 32 bits */
+#ifdef Z_U8
+   typedef Z_U8 pin_bits;
+#  define PIN_FILL 56
+#else
+   typedef unsigned long pin_bits;
+#  define PIN_FILL 24
+#endif
+
+/* A chunk of the round. win is only used for chunks in the chain. */
+typedef struct {
+    z_size_t start;         /* bit position of the first block, or PIN_NONE */
+    z_size_t end;           /* bit position where decoding stopped */
+    int stop;               /* how decoding stopped, or 0 if not yet */
+    unsigned next;          /* chunk that starts at end for PIN_NEXT */
+    unsigned short *sym;    /* decoded symbols, resolved to bytes in place */
+    z_size_t size;          /* allocated symbols at sym */
+    z_size_t have;          /* decoded symbols */
+    unsigned low;           /* lowest window position referenced */
+    unsigned char *map;     /* 256 bytes then win, to look up symbols */
+    unsigned char *win;     /* window before the chunk, PIN_WIN bytes */
+    unsigned wlen;          /* valid bytes at the end of win */
+    uLong check;            /* check value of the output */
+} pin_chunk;
+
+/* State shared by the threads. task may only be used while holding the
+   lock. Each chunk is used by the one thread that took its task. */
+typedef struct {
+    const Bytef *data;      /* deflate data of the current stream */
+    z_size_t len;           /* bytes from data to the end of the input */
+    int wrap;               /* 0 for raw, 1 for zlib, 2 for gzip */
+    unsigned bits;          /* log base 2 of the window size */
+    out_func out;           /* where to deliver the output */
+    void FAR *out_desc;     /* first argument of out() */
+    uLong check;            /* check value of the output so far */
+    uLong total;            /* bytes of output so far */
+    unsigned char *win;     /* last output, right-aligned, PIN_WIN bytes */
+    unsigned wlen;          /* valid bytes at the end of win */
+    unsigned char *buf;     /* output buffer for inflate(), PIN_BUF bytes */
+    z_size_t pos;           /* bit position of the next block to decode */
+    z_size_t tail;          /* byte offset just after the last block */
+    int done;               /* true if the last block has been decoded */
+    int threads;            /* number of threads */
+    pin_chunk *chunk;       /* chunks of the round, one per thread */
+    unsigned chunks;        /* number of chunks in the round */
+    z_size_t stop;          /* bit position of the end of the round */
+    unsigned *chain;        /* chunks linked from the first chunk */
+    unsigned links;         /* number of chunks in the chain */
+    int phase;              /* 0 to search, 1 to decode, 2 to resolve */
+    z_lock lock;
+    unsigned task;          /* next task to take */
+} pin_state;
+
+/* Decoder for one thread. codes[] holds the dynamic tables. */
+typedef struct {
+    const Bytef *buf;       /* input */
+    z_size_t len;           /* bytes at buf */
+    z_size_t next;          /* next byte to load into hold */
+    pin_bits hold;          /* bit buffer, zero above the bits in it */
+    unsigned bits;          /* bits in hold */
+    int last;               /* true if the block is the last block */
+    unsigned stored;        /* length of a stored block, else 65536 */
+    const code FAR *lcode;  /* literal/length table */
+    const code FAR *dcode;  /* distance table */
+    unsigned lmask;         /* mask for the root literal/length index */
+    unsigned dmask;         /* mask for the root distance index */
+    code codes[ENOUGH_LENS_ROOT(PIN_LENBITS) +
+               ENOUGH_DISTS_ROOT(PIN_DISTBITS)];
+    unsigned short lens[320];   /* code lengths */
+    unsigned short work[288];   /* work area for inflate_table() */
+} pin_dec;
+
+/* Bit access for pin_header() and pin_block(), with the bit buffer in local
+   variables. A lack of input is an error. */
+#define PIN_PULL() \
+    do { \
+        if (next == len) \
+            return -1; \
+        hold += (pin_bits)buf[next++] << bits; \
+        bits += 8; \
+    } while (0)
+#define PIN_NEED(n) \
+    do { \
+        while (bits < (unsigned)(n)) \
+            PIN_PULL(); \
+    } while (0)
+#define PIN_BITS(n) ((unsigned)hold & ((1U << (n)) - 1))
+#define PIN_DROP(n) \
+    do { \
+        hold >>= (n); \
+        bits -= (unsigned)(n); \
+    } while (0)
+#define PIN_LOAD() \
+    do { \
+        buf = d->buf; \
+        len = d->len; \
+        next = d->next; \
+        hold = d->hold; \
+        bits = d->bits; \
+    } while (0)
+#define PIN_SAVE() \
+    do { \
+        d->next = next; \
+        d->hold = hold; \
+        d->bits = bits; \
+    } while (0)
+
+/* ===========================================================================
+ * Set d to read from bit position pos.
+ */
+local void pin_seek OF((pin_dec *d, z_size_t pos));
+local void pin_seek(d, pos)
+    pin_dec *d;
+    z_size_t pos;
+{
+    d->next = pos >> 3;
+    d->hold = 0;
+    d->bits = 0;
+    if ((pos & 7) && d->next < d->len) {
+        d->hold = d->buf[d->next++] >> (pos & 7);
+        d->bits = 8 - (unsigned)(pos & 7);
+    }
+}
+
+/* ===========================================================================
+ * Return the bit position of d.
+ */
+#define pin_tell(d) ((d)->next * 8 - (d)->bits)
+
+/* ===========================================================================
+ * Read a block header from d and set up to decode the block. If search is
+ * true, only accept dynamic and stored blocks. Return 0 on success, or -1 if
+ * the header is invalid or incomplete.
+ */
+local int pin_header OF((pin_dec *d, int search));
+local int pin_header(d, search)
+    pin_dec *d;
+    int search;
+{
+    static const unsigned short order[19] = /* permutation of code lengths */
+        {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    const Bytef *buf;
+    z_size_t len, next;
+    pin_bits hold;
+    unsigned bits;
+    unsigned nlen, ndist, ncode, have, root, copy, val;
+    code here;
+    code FAR *tab;
+
+    PIN_LOAD();
+    PIN_NEED(3);
+    d->last = (int)PIN_BITS(1);
+    switch (PIN_BITS(3) >> 1) {
+    case 0:                             /* stored */
+        PIN_DROP(3);
+        PIN_DROP(bits & 7);
+        PIN_NEED(32);
+        if ((PIN_BITS(16) ^ 0xffff) != ((unsigned)(hold >> 16) & 0xffff))
+            return -1;
+        d->stored = PIN_BITS(16);
+        PIN_DROP(32);
+        next -= bits >> 3;              /* give back the whole bytes */
+        hold = 0;
+        bits = 0;
+        break;
+    case 1:                             /* fixed */
+        if (search)
+            return -1;
+        PIN_DROP(3);
+        d->stored = 65536U;
+        d->lcode = lenfix;
+        d->lmask = 511;
+        d->dcode = distfix;
+        d->dmask = 31;
+        break;
+    case 2:                             /* dynamic */
+        PIN_DROP(3);
+        PIN_NEED(14);
+        nlen = PIN_BITS(5) + 257;
+        PIN_DROP(5);
+        ndist = PIN_BITS(5) + 1;
+        PIN_DROP(5);
+        ncode = PIN_BITS(4) + 4;
+        PIN_DROP(4);
+        if (nlen > 286 || ndist > 30)
+            return -1;
+        for (have = 0; have < ncode; have++) {
+            PIN_NEED(3);
+            d->lens[order[have]] = (unsigned short)PIN_BITS(3);
+            PIN_DROP(3);
+        }
+        while (have < 19)
+            d->lens[order[have++]] = 0;
+        for (copy = 0, have = 0; have < 19; have++)
+            if (d->lens[have])
+                copy += 128U >> d->lens[have];
+        if (copy != 128)                /* not complete, so invalid */
+            return -1;
+        tab = d->codes;
+        root = 7;
+        if (inflate_table(CODES, d->lens, 19, &tab, &root, d->work))
+            return -1;
+        have = 0;
+        while (have < nlen + ndist) {
+            for (;;) {
+                here = d->codes[PIN_BITS(root)];
+                if (here.bits <= bits) break;
+                PIN_PULL();
+            }
+            PIN_DROP(here.bits);
+            if (here.val < 16) {
+                d->lens[have++] = here.val;
+                continue;
+            }
+            if (here.val == 16) {
+                PIN_NEED(2);
+                if (have == 0)
+                    return -1;
+                val = d->lens[have - 1];
+                copy = 3 + PIN_BITS(2);
+                PIN_DROP(2);
+            }
+            else if (here.val == 17) {
+                PIN_NEED(3);
+                val = 0;
+                copy = 3 + PIN_BITS(3);
+                PIN_DROP(3);
+            }
+            else {
+                PIN_NEED(7);
+                val = 0;
+                copy = 11 + PIN_BITS(7);
+                PIN_DROP(7);
+            }
+            if (have + copy > nlen + ndist)
+                return -1;
+            while (copy--)
+                d->lens[have++] = (unsigned short)val;
+        }
+        if (d->lens[256] == 0)
+            return -1;
+        tab = d->codes;
+        root = PIN_LENBITS;
+        if (inflate_table(LENS, d->lens, nlen, &tab, &root, d->work))
+            return -1;
+        d->lcode = d->codes;
+        d->lmask = (1U << root) - 1;
+        d->dcode = tab;
+        root = PIN_DISTBITS;
+        if (inflate_table(DISTS, d->lens + nlen, ndist, &tab, &root,
+                          d->work))
+            return -1;
+        d->dmask = (1U << root) - 1;
+        d->stored = 65536U;
+        break;
+    default:                            /* invalid */
+        return -1;
+    }
+    PIN_SAVE();
+    return 0;
+}
+
+/* ===========================================================================
+ * Make room for at least need more symbols in c. Return 0 on success, or -1
+ * if there is not enough memory or the chunk would get too large.
+ */
+local int pin_room OF((pin_chunk *c, z_size_t need));
+local int pin_room(c, need)
+    pin_chunk *c;
+    z_size_t need;
+{
+    z_size_t size;
+    unsigned short *sym;
+
+    if (c->size - c->have >= need)
+        return 0;
+    if (c->have + need > 2 * PIN_OUT)
+        return -1;
+    size = c->size ? 2 * c->size : PIN_OUT >> 4;
+    while (size - c->have < need)
+        size <<= 1;
+    sym = (unsigned short *)realloc(c->sym, (size_t)size * sizeof(*sym));
+    if (sym == NULL)
+        return -1;
+    c->sym = sym;
+    c->size = size;
+    return 0;
+}
+
+/* ===========================================================================
+ * Decode the block whose header was just read from d, appending its symbols
+ * to c. Distances up to wsize are allowed, and those that reach back before
+ * the start of c are decoded as window references. Return 0 at the end of
+ * the block, or -1 on invalid data, lack of input, or lack of room.
+ */
+local int pin_block OF((pin_dec *d, pin_chunk *c, unsigned wsize));
+local int pin_block(d, c, wsize)
+    pin_dec *d;
+    pin_chunk *c;
+    unsigned wsize;
+{
+    const Bytef *buf;
+    z_size_t len, next;
+    pin_bits hold;
+    unsigned bits;
+    unsigned short *out, *limit, *from;
+    const code FAR *lcode = d->lcode;
+    const code FAR *dcode = d->dcode;
+    unsigned lmask = d->lmask;
+    unsigned dmask = d->dmask;
+    code here;
+    unsigned op, n, dist;
+    z_size_t have;
+
+    PIN_LOAD();
+    if (d->stored < 65536U) {           /* stored: copy the bytes */
+        n = d->stored;
+        if (len - next < n || pin_room(c, n))
+            return -1;
+        out = c->sym + c->have;
+        c->have += n;
+        while (n--)
+            *out++ = buf[next++];
+        PIN_SAVE();
+        return 0;
+    }
+    if (pin_room(c, PIN_ROOM))
+        return -1;
+    out = c->sym + c->have;
+    limit = c->sym + c->size - PIN_ROOM;
+    for (;;) {
+        if (out > limit) {
+            c->have = (z_size_t)(out - c->sym);
+            if (pin_room(c, PIN_ROOM))
+                return -1;
+            out = c->sym + c->have;
+            limit = c->sym + c->size - PIN_ROOM;
+        }
+        while (bits <= PIN_FILL && next < len) {
+            hold += (pin_bits)buf[next++] << bits;
+            bits += 8;
+        }
+        here = lcode[(unsigned)hold & lmask];
+        if (here.op == 0 && here.bits <= bits) {
+            /* up to three literals before filling the bit buffer again */
+            PIN_DROP(here.bits);
+            *out++ = here.val;
+            here = lcode[(unsigned)hold & lmask];
+            if (here.op == 0 && here.bits <= bits) {
+                PIN_DROP(here.bits);
+                *out++ = here.val;
+                here = lcode[(unsigned)hold & lmask];
+                if (here.op == 0 && here.bits <= bits) {
+                    PIN_DROP(here.bits);
+                    *out++ = here.val;
+                    continue;
+                }
+            }
+        }
+      dolen:
+        if (here.bits > bits)
+            return -1;
+        PIN_DROP(here.bits);
+        op = here.op;
+        if (op == 0) {                  /* literal */
+            *out++ = here.val;
+            continue;
+        }
+        if ((op & 16) == 0) {
+            if ((op & 64) == 0) {       /* 2nd level length code */
+                for (;;) {
+                    here = lcode[here.val + PIN_BITS(op)];
+                    if (here.bits <= bits) break;
+                    PIN_PULL();
+                }
+                goto dolen;
+            }
+            if (op & 32)                /* end of block */
+                break;
+            return -1;                  /* invalid literal/length code */
+        }
+        n = here.val;                   /* length base */
+        op &= 15;                       /* number of extra bits */
+        if (op) {
+            PIN_NEED(op);
+            n += PIN_BITS(op);
+            PIN_DROP(op);
+        }
+        for (;;) {
+            here = dcode[(unsigned)hold & dmask];
+            if (here.bits <= bits) break;
+            PIN_PULL();
+        }
+      dodist:
+        PIN_DROP(here.bits);
+        op = here.op;
+        if ((op & 16) == 0) {
+            if ((op & 64) == 0) {       /* 2nd level distance code */
+                for (;;) {
+                    here = dcode[here.val + PIN_BITS(op)];
+                    if (here.bits <= bits) break;
+                    PIN_PULL();
+                }
+                goto dodist;
+            }
+            return -1;                  /* invalid distance code */
+        }
+        dist = here.val;                /* distance base */
+        op &= 15;                       /* number of extra bits */
+        if (op) {
+            PIN_NEED(op);
+            dist += PIN_BITS(op);
+            PIN_DROP(op);
+        }
+        if (dist > wsize)
+            return -1;
+        have = (z_size_t)(out - c->sym);
+        if (dist <= have) {             /* copy from the chunk */
+            from = out - dist;
+            if (dist >= 4)              /* four at a time, maybe over */
+                do {
+                    zmemcpy(out, from, 4 * sizeof(*out));
+                    out += 4;
+                    from += 4;
+                } while (n > 4 ? (n -= 4) : (out -= 4 - n, 0));
+            else
+                do {
+                    *out++ = *from++;
+                } while (--n);
+        }
+        else {                          /* some from the unknown window */
+            op = PIN_WIN - (unsigned)(dist - have);
+            if (op < c->low)
+                c->low = op;
+            do {
+                *out++ = (unsigned short)(256 + op++);
+            } while (--n && op < PIN_WIN);
+            from = c->sym;
+            while (n--)
+                *out++ = *from++;
+        }
+    }
+    c->have = (z_size_t)(out - c->sym);
+    PIN_SAVE();
+    return 0;
+}
+
+/* ===========================================================================
+ * Find the first bit position in from..to-1 that starts a dynamic or stored
+ * block that decodes without error, followed by a valid block header, or if
+ * it is marked as the last block, by no more than a trailer before the end
+ * of the input. A false last block would otherwise be taken about once every
+ * 2^19 bits, when a stored length happens to match its complement. A true
+ * last block followed by more input is not taken, and is just decoded by an
+ * earlier chunk. Set c->start to the position found, or to PIN_NONE if there
+ * is none, with the first block decoded into c.
+ */
+local void pin_find OF((pin_state *s, pin_dec *d, pin_chunk *c,
+                        z_size_t from, z_size_t to));
+local void pin_find(s, d, c, from, to)
+    pin_state *s;
+    pin_dec *d;
+    pin_chunk *c;
+    z_size_t from;
+    z_size_t to;
+{
+    z_size_t pos, at;
+    unsigned head;
+    int last;
+
+    for (pos = from; pos < to; pos++) {
+        /* quickly skip the positions that can't be a block of interest:
+           fixed or invalid block types, or too many codes */
+        at = pos >> 3;
+        head = s->data[at];
+        if (at + 1 < s->len)
+            head += (unsigned)s->data[at + 1] << 8;
+        if (at + 2 < s->len)
+            head += (unsigned)s->data[at + 2] << 16;
+        head >>= pos & 7;
+        if ((head & 6) == 4 ? ((head >> 3) & 0x1f) > 29 ||
+                              ((head >> 8) & 0x1f) > 29 :
+                              (head & 6) != 0)
+            continue;
+
+        /* decode the block and the header after it */
+        pin_seek(d, pos);
+        if (pin_header(d, 1))
+            continue;
+        last = d->last;
+        c->have = 0;
+        c->low = PIN_WIN;
+        if (pin_block(d, c, 1U << s->bits))
+            continue;
+        c->end = pin_tell(d);
+        if (last ? ((c->end + 7) >> 3) + PIN_TRAIL < s->len :
+                   pin_header(d, 0))
+            continue;
+        c->start = pos;
+        c->stop = last ? PIN_LAST : 0;
+        return;
+    }
+    c->start = PIN_NONE;
+}
+
+/* ===========================================================================
+ * Decode chunk k from c->end, where its decoding left off, until a block
+ * boundary that is the guess of a later chunk, or that is past the round or
+ * after PIN_OUT symbols, or until the end of the last block.
+ */
+local void pin_decode OF((pin_state *s, pin_dec *d, unsigned k));
+local void pin_decode(s, d, k)
+    pin_state *s;
+    pin_dec *d;
+    unsigned k;
+{
+    pin_chunk *c = s->chunk + k;
+    z_size_t pos = c->end;
+    unsigned j = k + 1;
+
+    while (c->stop == 0) {
+        if (pos != c->start) {
+            while (j < s->chunks && (s->chunk[j].start == PIN_NONE ||
+                                     s->chunk[j].start < pos))
+                j++;
+            if (j < s->chunks && s->chunk[j].start == pos) {
+                c->stop = PIN_NEXT;
+                c->next = j;
+                break;
+            }
+            if (pos >= s->stop || c->have >= PIN_OUT) {
+                c->stop = PIN_SPLIT;
+                break;
+            }
+        }
+        pin_seek(d, pos);
+        if (pin_header(d, 0) || pin_block(d, c, 1U << s->bits)) {
+            c->stop = PIN_FAIL;
+            break;
+        }
+        pos = pin_tell(d);
+        if (d->last)
+            c->stop = PIN_LAST;
+    }
+    c->end = pos;
+}
+
+/* ===========================================================================
+ * Resolve the window references of c in place to bytes, using c->win, and
+ * compute the check value.
+ */
+local void pin_resolve OF((pin_state *s, pin_chunk *c));
+local void pin_resolve(s, c)
+    pin_state *s;
+    pin_chunk *c;
+{
+    unsigned char *out = (unsigned char *)c->sym;
+    unsigned short *sym = c->sym;
+    unsigned char *map = c->map;
+    z_size_t n;
+
+    for (n = 0; n < c->have; n++)
+        out[n] = map[sym[n]];
+    if (s->wrap == 2)
+        c->check = crc32_z(0L, out, c->have);
+    else if (s->wrap == 1)
+        c->check = adler32_z(1L, out, c->have);
+}
+
+/* ===========================================================================
+ * Take tasks for the current phase until there are none left. This is run
+ * by each of the threads.
+ */
+local void pin_work OF((voidpf arg));
+local void pin_work(arg)
+    voidpf arg;
+{
+    pin_state *s = (pin_state *)arg;
+    pin_dec *d = Z_NULL;
+    z_size_t from, to;
+    unsigned k, tasks;
+
+    if (s->phase != 2) {
+        d = (pin_dec *)malloc(sizeof(pin_dec));
+        if (d == NULL)
+            return;             /* leave the tasks to the other threads */
+        d->buf = s->data;
+        d->len = s->len;
+    }
+    tasks = s->phase == 2 ? s->links : s->chunks;
+    z_acquire(&s->lock);
+    while (s->task < tasks) {
+        k = s->task++;
+        z_release(&s->lock);
+        if (s->phase == 0) {
+            from = (s->pos >> 3) + k * PIN_CHUNK;
+            to = from + PIN_CHUNK < s->len ? from + PIN_CHUNK : s->len;
+            pin_find(s, d, s->chunk + k, from << 3, to << 3);
+        }
+        else if (s->phase == 1) {
+            if (s->chunk[k].start != PIN_NONE)
+                pin_decode(s, d, k);
+        }
+        else
+            pin_resolve(s, s->chunk + s->chain[k]);
+        z_acquire(&s->lock);
+    }
+    z_release(&s->lock);
+    free(d);
+}
+
+/* ===========================================================================
+ * Run pin_work() for phase on the threads, with the calling thread taking
+ * any tasks left if no decoder could be allocated. Return Z_OK or
+ * Z_MEM_ERROR.
+ */
+local int pin_run OF((pin_state *s, int phase, unsigned first));
+local int pin_run(s, phase, first)
+    pin_state *s;
+    int phase;
+    unsigned first;
+{
+    unsigned tasks = phase == 2 ? s->links : s->chunks;
+
+    s->phase = phase;
+    s->task = first;
+    z_run(tasks - first < (unsigned)s->threads ? (int)(tasks - first) :
+          s->threads, pin_work, s);
+    return s->task < tasks ? Z_MEM_ERROR : Z_OK;
+}
+
+/* ===========================================================================
+ * Append len bytes at buf to the window.
+ */
+local void pin_window OF((pin_state *s, const unsigned char *buf,
+                          z_size_t len));
+local void pin_window(s, buf, len)
+    pin_state *s;
+    const unsigned char *buf;
+    z_size_t len;
+{
+    if (len >= PIN_WIN)
+        zmemcpy(s->win, buf + len - PIN_WIN, PIN_WIN);
+    else {
+        memmove(s->win, s->win + len, PIN_WIN - (unsigned)len);
+        zmemcpy(s->win + PIN_WIN - len, buf, (unsigned)len);
+    }
+    s->wlen = len < (1U << s->bits) - s->wlen ? s->wlen + (unsigned)len :
+                                                 1U << s->bits;
+}
+
+/* ===========================================================================
+ * Deliver len bytes of output at buf, updating the check value and the
+ * total. The check value of the bytes is check if known, or else computed.
+ * Return Z_OK, or Z_BUF_ERROR if out() failed.
+ */
+local int pin_deliver OF((pin_state *s, unsigned char *buf, z_size_t len,
+                          int known, uLong check));
+local int pin_deliver(s, buf, len, known, check)
+    pin_state *s;
+    unsigned char *buf;
+    z_size_t len;
+    int known;
+    uLong check;
+{
+    z_size_t n;
+
+    if (len == 0)
+        return Z_OK;
+    if (s->wrap == 2)
+        s->check = known ? crc32_combine64(s->check, check, (z_off64_t)len) :
+                           crc32_z(s->check, buf, len);
+    else if (s->wrap == 1)
+        s->check = known ? adler32_combine64(s->check, check,
+                                             (z_off64_t)len) :
+                           adler32_z(s->check, buf, len);
+    s->total += (uLong)len;
+    for (n = 0; n < len; n += PIN_BUF)
+        if (s->out(s->out_desc, buf + n, len - n < PIN_BUF ?
+                   (unsigned)(len - n) : PIN_BUF))
+            return Z_BUF_ERROR;
+    return Z_OK;
+}
+
+/* ===========================================================================
+ * Decompress with inflate() from bit position pos, given the window, up to
+ * the first block boundary at or past stop, setting s->pos, or to the end
+ * of the last block, setting s->tail and s->done. Return Z_OK or an error.
+ */
+local int pin_stream OF((pin_state *s, z_size_t pos, z_size_t stop));
+local int pin_stream(s, pos, stop)
+    pin_state *s;
+    z_size_t pos;
+    z_size_t stop;
+{
+    z_stream strm;
+    z_size_t at, left;
+    unsigned have;
+    int ret;
+
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    ret = inflateInit2(&strm, -(int)s->bits);
+    if (ret != Z_OK)
+        return ret;
+    if (s->wlen)
+        ret = inflateSetDictionary(&strm, s->win + PIN_WIN - s->wlen,
+                                   s->wlen);
+    at = pos >> 3;
+    if (ret == Z_OK && (pos & 7)) {
+        if (at == s->len)
+            ret = Z_DATA_ERROR;
+        else
+            ret = inflatePrime(&strm, 8 - (int)(pos & 7),
+                               s->data[at++] >> (pos & 7));
+    }
+    strm.next_in = (z_const Bytef *)s->data + at;
+    strm.avail_in = 0;
+    left = s->len - at;
+    while (ret == Z_OK) {
+        if (strm.avail_in == 0) {
+            strm.avail_in = left > (uInt)-1 ? (uInt)-1 : (uInt)left;
+            left -= strm.avail_in;
+        }
+        strm.next_out = s->buf;
+        strm.avail_out = PIN_BUF;
+        ret = inflate(&strm, Z_BLOCK);
+        have = PIN_BUF - strm.avail_out;
+        if (have) {
+            pin_window(s, s->buf, have);
+            if (pin_deliver(s, s->buf, have, 0, 0) != Z_OK) {
+                ret = Z_BUF_ERROR;
+                break;
+            }
+        }
+        if (ret == Z_STREAM_END) {
+            s->tail = (z_size_t)(strm.next_in - s->data);
+            s->done = 1;
+            ret = Z_OK;
+            break;
+        }
+        if (ret == Z_BUF_ERROR && strm.avail_in == 0 && left == 0)
+            ret = Z_DATA_ERROR;         /* input ended before the stream */
+        else if (ret == Z_BUF_ERROR)
+            ret = Z_OK;
+        if (ret == Z_OK && stop != PIN_NONE && (strm.data_type & 128)) {
+            pos = (z_size_t)(strm.next_in - s->data) * 8 -
+                  (strm.data_type & 7);
+            if (pos >= stop) {
+                s->pos = pos;
+                break;
+            }
+        }
+    }
+    inflateEnd(&strm);
+    return ret;
+}
+
+/* ===========================================================================
+ * Decode a round of chunks in parallel, starting at s->pos, and deliver the
+ * output of the chain. Return Z_OK or an error.
+ */
+local int pin_round OF((pin_state *s));
+local int pin_round(s)
+    pin_state *s;
+{
+    pin_chunk *c;
+    z_size_t first, n;
+    unsigned k, i;
+    int ret;
+
+    /* set up the chunks, the first one starting on the block at s->pos */
+    first = s->pos >> 3;
+    s->chunks = (unsigned)s->threads;
+    if ((s->len - first - 1) / PIN_CHUNK + 1 < s->chunks)
+        s->chunks = (unsigned)((s->len - first - 1) / PIN_CHUNK + 1);
+    s->stop = s->len - first > s->chunks * PIN_CHUNK ?
+              (first + s->chunks * PIN_CHUNK) << 3 : PIN_NONE;
+    for (k = 0; k < s->chunks; k++) {
+        c = s->chunk + k;
+        c->start = c->end = k ? PIN_NONE : s->pos;
+        c->stop = 0;
+        c->have = 0;
+        c->low = PIN_WIN;
+    }
+
+    /* guess where the other chunks start, then decode all of them */
+    ret = pin_run(s, 0, 1);
+    if (ret == Z_OK)
+        ret = pin_run(s, 1, 0);
+    if (ret != Z_OK)
+        return ret;
+
+    /* link the chain, giving each chunk the window before it */
+    s->links = 0;
+    k = 0;
+    for (;;) {
+        c = s->chunk + k;
+        if (c->stop == PIN_FAIL || c->low < PIN_WIN - s->wlen)
+            break;
+        zmemcpy(c->win, s->win, PIN_WIN);
+        c->wlen = s->wlen;
+        n = c->have < PIN_WIN ? c->have : PIN_WIN;
+        memmove(s->win, s->win + n, PIN_WIN - (unsigned)n);
+        for (i = 0; i < n; i++)
+            s->win[PIN_WIN - n + i] = c->map[c->sym[c->have - n + i]];
+        s->wlen = c->have < (1U << s->bits) - s->wlen ?
+                  s->wlen + (unsigned)c->have : 1U << s->bits;
+        s->chain[s->links++] = k;
+        if (c->stop != PIN_NEXT)
+            break;
+        k = c->next;
+    }
+
+    /* resolve the chain's output in parallel and deliver it in order */
+    if (s->links > 1)
+        ret = pin_run(s, 2, 0);
+    else if (s->links)
+        pin_resolve(s, s->chunk + s->chain[0]);
+    for (i = 0; ret == Z_OK && i < s->links; i++) {
+        c = s->chunk + s->chain[i];
+        ret = pin_deliver(s, (unsigned char *)c->sym, c->have, 1, c->check);
+    }
+    if (ret != Z_OK)
+        return ret;
+
+    /* continue after the last chunk in the chain, or with inflate() from the
+       start of the chunk that could not be used */
+    c = s->chunk + k;
+    if (i == 0 || s->chain[i - 1] != k)
+        return pin_stream(s, c->start, s->stop);
+    if (c->stop == PIN_LAST) {
+        s->tail = (c->end + 7) >> 3;
+        s->done = 1;
+    }
+    else
+        s->pos = c->end;
+    return Z_OK;
+}
+
+/* ===========================================================================
+ * Decode the zlib or gzip header at buf[0..len-1], as wrap permits (1 for
+ * zlib, 2 for gzip, 3 for either, or 0 for none), for a window of up to
+ * 1 << bits bytes (bits zero for what the header says), setting s->wrap,
+ * s->bits, and *head to the length of the header. Return Z_OK, or
+ * Z_DATA_ERROR if the header is invalid or incomplete.
+ */
+local int pin_head OF((pin_state *s, const Bytef *buf, z_size_t len,
+                       int wrap, unsigned bits, z_size_t *head));
+local int pin_head(s, buf, len, wrap, bits, head)
+    pin_state *s;
+    const Bytef *buf;
+    z_size_t len;
+    int wrap;
+    unsigned bits;
+    z_size_t *head;
+{
+    z_size_t n;
+    unsigned flags;
+
+    if (wrap == 0) {                    /* raw */
+        s->wrap = 0;
+        s->bits = bits;
+        *head = 0;
+        return Z_OK;
+    }
+    if ((wrap & 2) && len >= 2 && buf[0] == 31 && buf[1] == 139) {
+        s->wrap = 2;                    /* gzip */
+        s->bits = bits ? bits : MAX_WBITS;
+        if (len < 10 || buf[2] != Z_DEFLATED || (buf[3] & 0xe0))
+            return Z_DATA_ERROR;
+        flags = buf[3];
+        n = 10;
+        if (flags & 4) {                /* extra field */
+            if (len - n < 2 ||
+                len - n - 2 < (unsigned)(buf[n] + (buf[n + 1] << 8)))
+                return Z_DATA_ERROR;
+            n += 2 + buf[n] + (buf[n + 1] << 8);
+        }
+        if (flags & 8) {                /* file name */
+            while (n < len && buf[n] != 0)
+                n++;
+            if (n++ == len)
+                return Z_DATA_ERROR;
+        }
+        if (flags & 16) {               /* comment */
+            while (n < len && buf[n] != 0)
+                n++;
+            if (n++ == len)
+                return Z_DATA_ERROR;
+        }
+        if (flags & 2) {                /* header crc */
+            if (len - n < 2 || (crc32_z(0L, buf, n) & 0xffff) !=
+                               buf[n] + ((unsigned)buf[n + 1] << 8))
+                return Z_DATA_ERROR;
+            n += 2;
+        }
+        *head = n;
+        return Z_OK;
+    }
+    if ((wrap & 1) == 0 || len < 2 || (buf[0] & 0xf) != Z_DEFLATED ||
+        ((buf[0] << 8) + buf[1]) % 31 || (buf[0] >> 4) + 8U > 15 ||
+        (bits && (buf[0] >> 4) + 8U > bits) || (buf[1] & 0x20))
+        return Z_DATA_ERROR;
+    s->wrap = 1;                        /* zlib */
+    s->bits = bits ? bits : (buf[0] >> 4) + 8U;
+    *head = 2;
+    return Z_OK;
+}
+
+/* ===========================================================================
+ */
+int ZEXPORT inflateParallel(source, sourceLen, windowBits, out, out_desc,
+                            threads)
+    const Bytef *source;
+    z_size_t *sourceLen;
+    int windowBits;
+    out_func out;
+    void FAR *out_desc;
+    int threads;
+{
+    pin_state s;
+    z_size_t len, used, head, n;
+    unsigned k;
+    int wrap, par, ret;
+    uLong check, total;
+
+    /* decode windowBits as inflateInit2() does */
+    len = *sourceLen;
+    *sourceLen = 0;
+    if (windowBits < 0) {
+        wrap = 0;
+        windowBits = -windowBits;
+    }
+    else {
+        wrap = (windowBits >> 4) + 1;
+        windowBits &= 15;
+    }
+    if (out == Z_NULL || wrap > 3 ||
+        (windowBits == 0 ? wrap == 0 : windowBits < 8 || windowBits > 15))
+        return Z_STREAM_ERROR;
+
+    /* allocate the windows and the chunks, with no chunks if there is only
+       one thread or any allocation for the chunks fails */
+    s.out = out;
+    s.out_desc = out_desc;
+    s.threads = z_threads(threads);
+    s.win = (unsigned char *)malloc(PIN_WIN);
+    s.buf = (unsigned char *)malloc(PIN_BUF);
+    s.chunk = Z_NULL;
+    s.chain = Z_NULL;
+    par = 0;
+    if (s.threads > 1 && len >= 2 * PIN_CHUNK && len <= PIN_NONE >> 4) {
+        s.chunk = (pin_chunk *)calloc((size_t)s.threads, sizeof(pin_chunk));
+        s.chain = (unsigned *)malloc((size_t)s.threads * sizeof(unsigned));
+        par = s.chunk != Z_NULL && s.chain != Z_NULL;
+        for (k = 0; par && k < (unsigned)s.threads; k++) {
+            s.chunk[k].map = (unsigned char *)malloc(256 + PIN_WIN);
+            if (s.chunk[k].map == NULL) {
+                par = 0;
+                break;
+            }
+            for (n = 0; n < 256; n++)
+                s.chunk[k].map[n] = (unsigned char)n;
+            s.chunk[k].win = s.chunk[k].map + 256;
+        }
+        if (par && z_lock_init(&s.lock))
+            par = 0;
+    }
+    ret = s.win == NULL || s.buf == NULL ? Z_MEM_ERROR : Z_OK;
+
+    /* decompress the streams, continuing with another gzip stream if one
+       follows */
+    used = 0;
+    while (ret == Z_OK) {
+        ret = pin_head(&s, source + used, len - used, wrap,
+                       (unsigned)windowBits, &head);
+        if (ret != Z_OK)
+            break;
+        s.data = source + used + head;
+        s.len = len - used - head;
+        s.check = s.wrap == 1 ? 1L : 0L;
+        s.total = 0;
+        s.wlen = 0;
+        s.pos = 0;
+        s.done = 0;
+        do {
+            ret = par && s.len - (s.pos >> 3) >= 2 * PIN_CHUNK ?
+                  pin_round(&s) : pin_stream(&s, s.pos, PIN_NONE);
+        } while (ret == Z_OK && !s.done);
+        if (ret != Z_OK)
+            break;
+
+        /* check the trailer */
+        used += head + s.tail;
+        n = s.wrap == 2 ? 8 : s.wrap == 1 ? 4 : 0;
+        if (len - used < n) {
+            ret = Z_DATA_ERROR;
+            break;
+        }
+        check = total = 0;
+        for (k = 0; k < 4 && s.wrap; k++)
+            if (s.wrap == 2) {
+                check += (uLong)source[used + k] << (8 * k);
+                total += (uLong)source[used + 4 + k] << (8 * k);
+            }
+            else
+                check = (check << 8) + source[used + k];
+        if (check != s.check ||
+            (s.wrap == 2 && total != (s.total & 0xffffffffUL))) {
+            ret = Z_DATA_ERROR;
+            break;
+        }
+        used += n;
+        *sourceLen = used;
+        if (s.wrap != 2 || len - used < 2 || source[used] != 31 ||
+            source[used + 1] != 139)
+            break;
+    }
+
+    /* free the windows and the chunks */
+    if (par)
+        z_lock_free(&s.lock);
+    if (s.chunk != Z_NULL)
+        for (k = 0; k < (unsigned)s.threads; k++) {
+            free(s.chunk[k].map);
+            free(s.chunk[k].sym);
+        }
+    free(s.chunk);
+    free(s.chain);
+    free(s.buf);
+    free(s.win);
+    return ret;
+}
@@ -44,6 +44,7 @@ void test_large_inflate OF((Byte *compr, uLong comprLen,
 void test_flush         OF((Byte *compr, uLong *comprLen));
 void test_sync          OF((Byte *compr, uLong comprLen,
                             Byte *uncompr, uLong uncomprLen));
+void test_sync_search   OF((void));
 void test_dict_deflate  OF((Byte *compr, uLong comprLen));
 void test_dict_inflate  OF((Byte *compr, uLong comprLen,
                             Byte *uncompr, uLong uncomprLen));
@@ -79,8 +80,34 @@ static free_func zfree = (free_func)0;
 
 void test_compress      OF((Byte *compr, uLong comprLen,
                             Byte *uncompr, uLong uncomprLen));
+void test_compress_parallel OF((void));
+void test_split         OF((void));
+void test_tune          OF((void));
+void test_keep_output   OF((void));
+int  par_put            OF((void FAR *desc, unsigned char FAR *buf,
+                            unsigned len));
+void test_inflate_parallel OF((void));
+int  uncompress_ref     OF((Byte *dest, uLong *destLen, const Byte *source,
+                            uLong *sourceLen));
+void test_inflate_buffer OF((void));
+void put_bits           OF((Byte *buf, uLong *pos, unsigned val, int n,
+                            int rev));
+unsigned back_in        OF((void FAR *desc,
+                            z_const unsigned char FAR **buf));
+int  back_out           OF((void FAR *desc, unsigned char FAR *buf,
+                            unsigned len));
+void test_inflate_back  OF((void));
+void *poison_alloc      OF((void *q, unsigned n, unsigned m));
+void poison_free        OF((void *q, void *p));
+void test_check_unused  OF((void));
+void test_crc32         OF((void));
+void test_crc32c        OF((void));
+void test_adler32       OF((void));
+void test_check_copy    OF((void));
+void test_check_parallel OF((void));
 void test_gzio          OF((const char *fname,
                             Byte *uncompr, uLong uncomprLen));
+void test_gzio_threads  OF((const char *fname));
 
 /* ===========================================================================
  * Test compress() and uncompress()
@@ -108,6 +135,967 @@ void test_compress(compr, comprLen, uncompr, uncomprLen)
     }
 }
 
+/* ===========================================================================
+ * Test compressParallel() with zlib and gzip wrappers, at level 6 and at an
+ * optimal level, and check that the result does not depend on the number of
+ * threads
+ */
+void test_compress_parallel()
+{
+    int err, wbits, level;
+    uLong k, x = 1, len = 100000L, bound, comprLen, oneLen;
+    Byte *data, *compr, *one, *out;
+    z_stream d_stream;
+
+    data = (Byte*)malloc(len);
+    out = (Byte*)malloc(len);
+    bound = compressParallelBound(len, 31, 16384);
+    compr = (Byte*)malloc(bound);
+    one = (Byte*)malloc(bound);
+    if (data == Z_NULL || out == Z_NULL || compr == Z_NULL || one == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (k = 0; k < len; k++) {     /* some matches, some literals */
+        x = x * 1103515245L + 12345;
+        data[k] = k >= 1000 && (x >> 20) % 4 ? data[k - 999 + (x >> 16) % 3] :
+                                               (Byte)hello[(x >> 16) % 13];
+    }
+
+    for (wbits = 15, level = 6; wbits <= 31; wbits += 16, level = 11) {
+        comprLen = bound;
+        err = compressParallel(compr, &comprLen, data, len, level, wbits,
+                               4, 16384);
+        CHECK_ERR(err, "compressParallel");
+        oneLen = bound;
+        err = compressParallel(one, &oneLen, data, len, level, wbits,
+                               1, 16384);
+        CHECK_ERR(err, "compressParallel");
+        if (comprLen != oneLen || memcmp(compr, one, comprLen)) {
+            fprintf(stderr, "compressParallel depends on threads\n");
+            exit(1);
+        }
+
+        d_stream.zalloc = zalloc;
+        d_stream.zfree = zfree;
+        d_stream.opaque = (voidpf)0;
+        err = inflateInit2(&d_stream, wbits);
+        CHECK_ERR(err, "inflateInit2");
+        d_stream.next_in = compr;
+        d_stream.avail_in = (uInt)comprLen;
+        d_stream.next_out = out;
+        d_stream.avail_out = (uInt)len;
+        err = inflate(&d_stream, Z_FINISH);
+        if (err != Z_STREAM_END || d_stream.avail_in != 0 ||
+            d_stream.total_out != len || memcmp(out, data, len)) {
+            fprintf(stderr, "bad compressParallel\n");
+            exit(1);
+        }
+        err = inflateEnd(&d_stream);
+        CHECK_ERR(err, "inflateEnd");
+    }
+    printf("compressParallel(): %lu -> %lu\n", len, comprLen);
+
+    free(one);
+    free(compr);
+    free(out);
+    free(data);
+}
+
+/* ===========================================================================
+ * Test deflateSplit() on data that alternates between two alphabets, which
+ * should compress better when the blocks are split
+ */
+void test_split()
+{
+    int err, parts;
+    uLong k, x = 1, len = 65536L, bound, comprLen[2];
+    Byte *data, *compr, *out;
+    z_stream c_stream, d_stream;
+
+    data = (Byte*)malloc(len);
+    out = (Byte*)malloc(len);
+    bound = compressBound(len);
+    compr = (Byte*)malloc(bound);
+    if (data == Z_NULL || out == Z_NULL || compr == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (k = 0; k < len; k++) {     /* text, then bytes 128..191, and so on */
+        x = x * 1103515245L + 12345;
+        data[k] = k & 8192 ? (Byte)(128 + (x >> 16) % 64) :
+                  k >= 1000 && (x >> 20) % 4 ? data[k - 999 + (x >> 16) % 3] :
+                                               (Byte)hello[(x >> 16) % 13];
+    }
+
+    for (parts = 1; parts <= 16; parts += 15) {
+        c_stream.zalloc = zalloc;
+        c_stream.zfree = zfree;
+        c_stream.opaque = (voidpf)0;
+        err = deflateInit(&c_stream, Z_DEFAULT_COMPRESSION);
+        CHECK_ERR(err, "deflateInit");
+        err = deflateSplit(&c_stream, parts);
+        CHECK_ERR(err, "deflateSplit");
+        c_stream.next_in = data;
+        c_stream.avail_in = (uInt)len;
+        c_stream.next_out = compr;
+        c_stream.avail_out = (uInt)bound;
+        err = deflate(&c_stream, Z_FINISH);
+        if (err != Z_STREAM_END) {
+            fprintf(stderr, "deflate should report Z_STREAM_END\n");
+            exit(1);
+        }
+        comprLen[parts > 1] = c_stream.total_out;
+        err = deflateEnd(&c_stream);
+        CHECK_ERR(err, "deflateEnd");
+
+        d_stream.zalloc = zalloc;
+        d_stream.zfree = zfree;
+        d_stream.opaque = (voidpf)0;
+        err = inflateInit(&d_stream);
+        CHECK_ERR(err, "inflateInit");
+        d_stream.next_in = compr;
+        d_stream.avail_in = (uInt)c_stream.total_out;
+        d_stream.next_out = out;
+        d_stream.avail_out = (uInt)len;
+        err = inflate(&d_stream, Z_FINISH);
+        if (err != Z_STREAM_END || d_stream.total_out != len ||
+            memcmp(out, data, len)) {
+            fprintf(stderr, "bad deflateSplit\n");
+            exit(1);
+        }
+        err = inflateEnd(&d_stream);
+        CHECK_ERR(err, "inflateEnd");
+    }
+    if (comprLen[1] >= comprLen[0]) {
+        fprintf(stderr, "deflateSplit did not help: %lu -> %lu\n",
+                comprLen[0], comprLen[1]);
+        exit(1);
+    }
+    printf("deflateSplit(): %lu -> %lu\n", comprLen[0], comprLen[1]);
+
+    free(compr);
+    free(out);
+    free(data);
+}
+
+/* ===========================================================================
+ * Test inflateTune() with larger root tables and with kept tables, on many
+ * small dynamic blocks that repeat their codes, here by having the same
+ * literals in each block and no matches
+ */
+void test_tune()
+{
+    static const int tune[2][3] = {{11, 8, 4}, {9, 6, 1}};
+    int err, t;
+    uLong k, x = 1, len = 65536L, bound;
+    Byte *data, *compr, *out;
+    z_stream c_stream, d_stream;
+
+    data = (Byte*)malloc(len);
+    out = (Byte*)malloc(len);
+    bound = compressBound(len) + 5 * (len >> 10);
+    compr = (Byte*)malloc(bound);
+    if (data == Z_NULL || out == Z_NULL || compr == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (k = 0; k < len; k++) {     /* each 1K a shuffle of the one before */
+        x = x * 1103515245L + 12345;
+        data[k] = k < 1024 ? (Byte)hello[(x >> 16) % 13] :
+                  data[(k & ~1023L) - 1024 + ((k * 7 + 3) & 1023)];
+    }
+
+    c_stream.zalloc = zalloc;
+    c_stream.zfree = zfree;
+    c_stream.opaque = (voidpf)0;
+    err = deflateInit2(&c_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15, 8,
+                       Z_HUFFMAN_ONLY);
+    CHECK_ERR(err, "deflateInit2");
+    c_stream.next_out = compr;
+    c_stream.avail_out = (uInt)bound;
+    for (k = 0; k < len; k += 1024) {
+        c_stream.next_in = data + k;
+        c_stream.avail_in = 1024;
+        err = deflate(&c_stream, k + 1024 < len ? Z_BLOCK : Z_FINISH);
+        if (err == Z_STREAM_END) break;
+        CHECK_ERR(err, "deflate");
+    }
+    err = deflateEnd(&c_stream);
+    CHECK_ERR(err, "deflateEnd");
+
+    for (t = 0; t < 2; t++) {
+        d_stream.zalloc = zalloc;
+        d_stream.zfree = zfree;
+        d_stream.opaque = (voidpf)0;
+        err = inflateInit(&d_stream);
+        CHECK_ERR(err, "inflateInit");
+        err = inflateTune(&d_stream, tune[t][0], tune[t][1], tune[t][2]);
+        CHECK_ERR(err, "inflateTune");
+        d_stream.next_in = compr;
+        d_stream.avail_in = (uInt)c_stream.total_out;
+        d_stream.next_out = out;
+        d_stream.avail_out = (uInt)len;
+        err = inflate(&d_stream, Z_FINISH);
+        if (err != Z_STREAM_END || d_stream.total_out != len ||
+            memcmp(out, data, len)) {
+            fprintf(stderr, "bad inflateTune\n");
+            exit(1);
+        }
+        err = inflateEnd(&d_stream);
+        CHECK_ERR(err, "inflateEnd");
+    }
+    printf("inflateTune(): OK\n");
+
+    free(compr);
+    free(out);
+    free(data);
+}
+
+/* ===========================================================================
+ * Test inflateKeepOutput() with output that continues and that does not
+ */
+void test_keep_output()
+{
+    int err, t;
+    uLong k, n, x = 1, len = 262144L, bound, piece;
+    Byte *data, *compr, *out, other[1000];
+    z_stream d_stream;
+
+    data = (Byte*)malloc(len);
+    out = (Byte*)malloc(len);
+    bound = compressBound(len);
+    compr = (Byte*)malloc(bound);
+    if (data == Z_NULL || out == Z_NULL || compr == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (k = 0; k < len; k++) {     /* matches both near and far back */
+        x = x * 1103515245L + 12345;
+        data[k] = k < 32768 || (x >> 16) % 8 == 0 ?
+                  (Byte)hello[(x >> 16) % 13] :
+                  data[k - 1 - (x >> 20) % ((x >> 16) & 1 ? 32 : 32768)];
+    }
+    err = compress(compr, &bound, data, len);
+    CHECK_ERR(err, "compress");
+
+    for (t = 0; t < 2; t++) {
+        d_stream.zalloc = zalloc;
+        d_stream.zfree = zfree;
+        d_stream.opaque = (voidpf)0;
+        err = inflateInit(&d_stream);
+        CHECK_ERR(err, "inflateInit");
+        err = inflateKeepOutput(&d_stream, 1);
+        CHECK_ERR(err, "inflateKeepOutput");
+        d_stream.next_in = compr;
+        d_stream.avail_in = 0;
+        d_stream.next_out = out;
+        for (k = 0, n = 0; k < len; k += piece, n++) {
+            /* small pieces of input and output, the output continuing in
+               place, or for t == 1 every other piece going to a separate
+               buffer, so that the kept output must be copied */
+            piece = len - k < 1000 ? len - k : 1000;
+            d_stream.next_out = t && (n & 1) ? other : out + k;
+            d_stream.avail_out = (uInt)piece;
+            if (d_stream.avail_in == 0)
+                d_stream.avail_in = (uInt)(bound - d_stream.total_in < 300 ?
+                                           bound - d_stream.total_in : 300);
+            err = inflate(&d_stream, Z_NO_FLUSH);
+            piece -= d_stream.avail_out;
+            if (t && (n & 1))
+                memcpy(out + k, other, piece);
+            if (err == Z_STREAM_END) break;
+            CHECK_ERR(err, "inflate");
+        }
+        if (err != Z_STREAM_END || d_stream.total_out != len ||
+            memcmp(out, data, len)) {
+            fprintf(stderr, "bad inflateKeepOutput\n");
+            exit(1);
+        }
+        err = inflateEnd(&d_stream);
+        CHECK_ERR(err, "inflateEnd");
+    }
+    printf("inflateKeepOutput(): OK\n");
+
+    free(compr);
+    free(out);
+    free(data);
+}
+
+/* ===========================================================================
+ * Output function for inflateParallel(), appending to a buffer of len bytes
+ */
+static Byte *par_out;
+static uLong par_have, par_len;
+
+int par_put(desc, buf, len)
+    void FAR *desc;
+    unsigned char FAR *buf;
+    unsigned len;
+{
+    (void)desc;
+    if (par_len - par_have < len)
+        return 1;
+    memcpy(par_out + par_have, buf, len);
+    par_have += len;
+    return 0;
+}
+
+/* ===========================================================================
+ * Test inflateParallel() on two gzip streams, the first long enough to be
+ * decompressed in parallel, then with the first one corrupted, once in a
+ * byte and once with garbage in its second chunk
+ */
+void test_inflate_parallel()
+{
+    int err;
+    uLong k, x = 1, len = 6000000L, bound, comprLen, moreLen;
+    z_size_t used;
+    Byte *data, *compr, *ref;
+    z_stream d_stream;
+
+    data = (Byte*)malloc(len);
+    par_out = (Byte*)malloc(len + 14);
+    bound = compressParallelBound(len, 31, 0) + 100;
+    compr = (Byte*)malloc(bound);
+    if (data == Z_NULL || par_out == Z_NULL || compr == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (k = 0; k < len; k++) {     /* mostly literals, with some matches */
+        x = x * 1103515245L + 12345;
+        data[k] = k < 32768 || (x >> 16) % 4 ? (Byte)((x >> 20) % 32) :
+                  data[k - 1 - (x >> 17) % 32768];
+    }
+    comprLen = bound;
+    err = compressParallel(compr, &comprLen, data, len, 1, 31, 0, 0);
+    CHECK_ERR(err, "compressParallel");
+    moreLen = bound - comprLen;
+    err = compressParallel(compr + comprLen, &moreLen, (const Bytef*)hello,
+                           14, 6, 31, 0, 0);
+    CHECK_ERR(err, "compressParallel");
+
+    compr[comprLen + moreLen] = 0;  /* ignored after the streams */
+    used = comprLen + moreLen + 1;
+    par_have = 0;
+    par_len = len + 14;
+    err = inflateParallel(compr, &used, 31, par_put, Z_NULL, 4);
+    CHECK_ERR(err, "inflateParallel");
+    if (used != comprLen + moreLen || par_have != len + 14 ||
+        memcmp(par_out, data, len) || strcmp((char*)par_out + len, hello)) {
+        fprintf(stderr, "bad inflateParallel\n");
+        exit(1);
+    }
+
+    compr[comprLen / 2] ^= 0x10;
+    used = comprLen + moreLen;
+    par_have = 0;
+    err = inflateParallel(compr, &used, 31, par_put, Z_NULL, 4);
+    if (err != Z_DATA_ERROR && err != Z_BUF_ERROR) {
+        fprintf(stderr, "inflateParallel should report corrupt data\n");
+        exit(1);
+    }
+    compr[comprLen / 2] ^= 0x10;
+
+    /* garbage in the second chunk, where what is delivered before the error
+       must be what inflate() gives */
+    for (k = 1300000L; k < 1300000L + 65536L; k++) {
+        x = x * 1103515245L + 12345;
+        compr[k] = (Byte)(x >> 16);
+    }
+    ref = (Byte*)malloc(len + 14);
+    if (ref == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    d_stream.zalloc = zalloc;
+    d_stream.zfree = zfree;
+    d_stream.opaque = (voidpf)0;
+    err = inflateInit2(&d_stream, 31);
+    CHECK_ERR(err, "inflateInit2");
+    d_stream.next_in = compr;
+    d_stream.avail_in = (uInt)comprLen;
+    d_stream.next_out = ref;
+    d_stream.avail_out = (uInt)(len + 14);
+    do {
+        err = inflate(&d_stream, Z_NO_FLUSH);
+    } while (err == Z_OK);
+    inflateEnd(&d_stream);
+    used = comprLen + moreLen;
+    par_have = 0;
+    err = inflateParallel(compr, &used, 31, par_put, Z_NULL, 2);
+    if ((err != Z_DATA_ERROR && err != Z_BUF_ERROR) ||
+        par_have > d_stream.total_out || memcmp(par_out, ref, par_have)) {
+        fprintf(stderr, "inflateParallel delivered wrong data before an "
+                        "error\n");
+        exit(1);
+    }
+    printf("inflateParallel(): %lu -> %lu\n", comprLen, len);
+
+    free(ref);
+    free(compr);
+    free(par_out);
+    free(data);
+}
+
+/* ===========================================================================
+ * uncompress2() as it was before inflateBuffer(), with inflate()
+ */
+int uncompress_ref(dest, destLen, source, sourceLen)
+    Byte *dest;
+    uLong *destLen;
+    const Byte *source;
+    uLong *sourceLen;
+{
+    z_stream stream;
+    int err;
+    uLong left;
+    Byte buf[1];
+
+    left = *destLen;
+    if (left == 0) {
+        left = 1;
+        dest = buf;
+    }
+    stream.zalloc = zalloc;
+    stream.zfree = zfree;
+    stream.opaque = (voidpf)0;
+    stream.next_in = (z_const Bytef *)source;
+    stream.avail_in = (uInt)*sourceLen;
+    err = inflateInit(&stream);
+    if (err != Z_OK)
+        return err;
+    stream.next_out = dest;
+    stream.avail_out = (uInt)left;
+    do {
+        err = inflate(&stream, Z_NO_FLUSH);
+    } while (err == Z_OK);
+    *sourceLen -= stream.avail_in;
+    if (dest != buf)
+        *destLen = stream.total_out;
+    else if (stream.total_out && err == Z_BUF_ERROR)
+        stream.avail_out = 1;
+    inflateEnd(&stream);
+    return err == Z_STREAM_END ? Z_OK :
+           err == Z_NEED_DICT ? Z_DATA_ERROR :
+           err == Z_BUF_ERROR && stream.avail_out ? Z_DATA_ERROR : err;
+}
+
+/* ===========================================================================
+ * Test inflateBuffer() on a gzip stream, whole, with one byte too little
+ * room for the output, and cut short, and that uncompress2() with it gives
+ * what it did with inflate() for every mix of too little room and input
+ */
+void test_inflate_buffer()
+{
+    int err, level, ret;
+    uLong k, x = 1, len = 262144L, bound, comprLen, outLen, used;
+    uLong n, m, refLen, refUsed;
+    Byte *data, *compr, *out;
+    z_stream c_stream;
+
+    data = (Byte*)malloc(len);
+    out = (Byte*)malloc(len);
+    bound = deflateBound(Z_NULL, len) + 18;
+    compr = (Byte*)malloc(bound);
+    if (data == Z_NULL || out == Z_NULL || compr == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (k = 0; k < len; k++) {     /* matches both near and far back */
+        x = x * 1103515245L + 12345;
+        data[k] = k < 32768 || (x >> 16) % 8 == 0 ?
+                  (Byte)hello[(x >> 16) % 13] :
+                  data[k - 1 - (x >> 20) % ((x >> 16) & 1 ? 32 : 32768)];
+    }
+    c_stream.zalloc = zalloc;
+    c_stream.zfree = zfree;
+    c_stream.opaque = (voidpf)0;
+    err = deflateInit2(&c_stream, 6, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY);
+    CHECK_ERR(err, "deflateInit2");
+    c_stream.next_in = data;
+    c_stream.avail_in = (uInt)len;
+    c_stream.next_out = compr;
+    c_stream.avail_out = (uInt)bound;
+    err = deflate(&c_stream, Z_FINISH);
+    if (err != Z_STREAM_END) {
+        fprintf(stderr, "deflate should report Z_STREAM_END\n");
+        exit(1);
+    }
+    comprLen = c_stream.total_out;
+    err = deflateEnd(&c_stream);
+    CHECK_ERR(err, "deflateEnd");
+
+    compr[comprLen] = 0;            /* not used */
+    outLen = len;
+    used = comprLen + 1;
+    err = inflateBuffer(out, &outLen, compr, &used, 47);
+    CHECK_ERR(err, "inflateBuffer");
+    if (outLen != len || used != comprLen || memcmp(out, data, len)) {
+        fprintf(stderr, "bad inflateBuffer\n");
+        exit(1);
+    }
+
+    outLen = len - 1;
+    used = comprLen;
+    err = inflateBuffer(out, &outLen, compr, &used, 31);
+    if (err != Z_BUF_ERROR || outLen != len - 1 ||
+        memcmp(out, data, len - 1)) {
+        fprintf(stderr, "inflateBuffer should fill the output and report "
+                        "Z_BUF_ERROR\n");
+        exit(1);
+    }
+
+    outLen = len;
+    used = comprLen / 2;
+    err = inflateBuffer(out, &outLen, compr, &used, 31);
+    if (err != Z_DATA_ERROR || used != comprLen / 2 || outLen == 0 ||
+        outLen >= len || memcmp(out, data, outLen)) {
+        fprintf(stderr, "inflateBuffer should report Z_DATA_ERROR\n");
+        exit(1);
+    }
+
+    /* stored and compressed zlib streams, where a stored block that is cut
+       short is copied as far as it goes */
+    for (level = 0; level <= 6; level += 6) {
+        comprLen = bound;
+        err = compress2(compr, &comprLen, data, len / 4, level);
+        CHECK_ERR(err, "compress2");
+        for (n = 0; n < 9; n++)
+            for (m = 0; m < 9; m++) {
+                outLen = n == 0 ? 0 : n == 8 ? len / 4 + 1 :
+                         n * (len / 4) / 7 - (n & 1);
+                used = m == 8 ? comprLen + 1 : m * comprLen / 7 - (m & 1);
+                refLen = outLen;
+                refUsed = used;
+                err = uncompress2(out, &outLen, compr, &used);
+                ret = uncompress_ref(out + len / 2, &refLen, compr, &refUsed);
+                if (err != ret || outLen != refLen || used != refUsed ||
+                    memcmp(out, out + len / 2, outLen)) {
+                    fprintf(stderr, "uncompress2 differs from inflate: "
+                            "%d %lu %lu, %d %lu %lu\n", err, outLen, used,
+                            ret, refLen, refUsed);
+                    exit(1);
+                }
+                if (n == 0 && m >= 7 && (err != Z_DATA_ERROR || outLen)) {
+                    fprintf(stderr, "uncompress2 should report Z_DATA_ERROR "
+                            "for no room\n");
+                    exit(1);
+                }
+            }
+    }
+    printf("inflateBuffer(): OK\n");
+
+    free(compr);
+    free(out);
+    free(data);
+}
+
+/* ===========================================================================
+ * Write the low n bits of val to the deflate data at buf, at bit *pos, and
+ * advance *pos, reversing the bits first if rev is true as for a code.
+ */
+void put_bits(buf, pos, val, n, rev)
+    Byte *buf;
+    uLong *pos;
+    unsigned val;
+    int n, rev;
+{
+    int k;
+
+    for (k = 0; k < n; k++, (*pos)++) {
+        if (val >> (rev ? n - 1 - k : k) & 1)
+            buf[*pos >> 3] |= (Byte)(1 << (*pos & 7));
+    }
+}
+
+/* ===========================================================================
+ * Input and output functions for inflateBack(), with all of the input given
+ * at the start, and the output appended at *desc
+ */
+unsigned back_in(desc, buf)
+    void FAR *desc;
+    z_const unsigned char FAR **buf;
+{
+    (void)desc;
+    (void)buf;
+    return 0;
+}
+
+int back_out(desc, buf, len)
+    void FAR *desc;
+    unsigned char FAR *buf;
+    unsigned len;
+{
+    Byte **out = (Byte **)desc;
+
+    memcpy(*out, buf, len);
+    *out += len;
+    return 0;
+}
+
+/* ===========================================================================
+ * Test that inflateBack(), whose output is its window, agrees with inflate()
+ * on matches from as far back as the window allows, after the window has
+ * wrapped around
+ */
+void test_inflate_back()
+{
+    int err;
+    uLong k, x = 1, pos, len, outLen;
+    Byte *compr, *out, *back, *next;
+    unsigned char *window;
+    z_stream d_stream;
+
+    compr = (Byte*)calloc(50000L, 1);
+    out = (Byte*)malloc(80000L);
+    back = (Byte*)malloc(80000L);
+    window = (unsigned char *)malloc(32768L);
+    if (compr == Z_NULL || out == Z_NULL || back == Z_NULL ||
+        window == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    /* a stored block of 40000 random bytes */
+    compr[0] = 0;
+    compr[1] = (Byte)40000L;
+    compr[2] = (Byte)(40000L >> 8);
+    compr[3] = (Byte)~compr[1];
+    compr[4] = (Byte)~compr[2];
+    for (k = 0; k < 40000L; k++) {
+        x = x * 1103515245L + 12345;
+        compr[5 + k] = (Byte)(x >> 16);
+    }
+
+    /* then a last fixed block of matches of length 3 to 10 at distance 1,
+       each followed by one of length 3 from 32768 down to 32757 back, which
+       is what a chunked copy of the first might write past its end, then a
+       literal and a match from 32768 back, and then a match of length 20
+       from 32767 down to 32753 back, which starts in the window just ahead
+       of where it is written for inflateBack() */
+    pos = (5 + 40000L) << 3;
+    put_bits(compr, &pos, 1, 1, 0);
+    put_bits(compr, &pos, 1, 2, 0);
+    len = 0;
+    for (k = 0; k < 600; k++) {
+        put_bits(compr, &pos, k % 8 + 1, 7, 1);         /* 257..264 */
+        put_bits(compr, &pos, 0, 5, 1);                 /* distance 1 */
+        put_bits(compr, &pos, 1, 7, 1);                 /* length 3 */
+        put_bits(compr, &pos, 29, 5, 1);                /* 24577.. */
+        put_bits(compr, &pos, 8191 - k % 12, 13, 0);
+        put_bits(compr, &pos, 0x30 + k % 64, 8, 1);     /* one literal */
+        put_bits(compr, &pos, 1, 7, 1);                 /* length 3 */
+        put_bits(compr, &pos, 29, 5, 1);                /* 32768 back */
+        put_bits(compr, &pos, 8191, 13, 0);
+        put_bits(compr, &pos, 13, 7, 1);                /* length 20 */
+        put_bits(compr, &pos, 1, 2, 0);
+        put_bits(compr, &pos, 29, 5, 1);                /* 32767.. back */
+        put_bits(compr, &pos, 8190 - k % 15, 13, 0);
+        len += k % 8 + 3 + 3 + 1 + 3 + 20;
+    }
+    put_bits(compr, &pos, 0, 7, 1);                     /* end of block */
+    len += 40000L;
+
+    d_stream.zalloc = zalloc;
+    d_stream.zfree = zfree;
+    d_stream.opaque = (voidpf)0;
+    err = inflateInit2(&d_stream, -15);
+    CHECK_ERR(err, "inflateInit2");
+    d_stream.next_in = compr;
+    d_stream.avail_in = (uInt)((pos + 7) >> 3);
+    d_stream.next_out = out;
+    d_stream.avail_out = 80000;
+    err = inflate(&d_stream, Z_FINISH);
+    outLen = d_stream.total_out;
+    if (err != Z_STREAM_END || outLen != len) {
+        fprintf(stderr, "inflate failed on matches 32768 back\n");
+        exit(1);
+    }
+    err = inflateEnd(&d_stream);
+    CHECK_ERR(err, "inflateEnd");
+
+    err = inflateBackInit(&d_stream, 15, window);
+    CHECK_ERR(err, "inflateBackInit");
+    d_stream.next_in = compr;
+    d_stream.avail_in = (uInt)((pos + 7) >> 3);
+    next = back;
+    err = inflateBack(&d_stream, back_in, Z_NULL, back_out, &next);
+    if (err != Z_STREAM_END || (uLong)(next - back) != outLen ||
+        memcmp(back, out, outLen)) {
+        fprintf(stderr, "inflateBack() differs from inflate()\n");
+        exit(1);
+    }
+    err = inflateBackEnd(&d_stream);
+    CHECK_ERR(err, "inflateBackEnd");
+    printf("inflateBack(): OK\n");
+
+    free(window);
+    free(back);
+    free(out);
+    free(compr);
+}
+
+/* ===========================================================================
+ * Allocate memory filled with garbage, so that reads of anything that was
+ * never initialized show up
+ */
+void *poison_alloc(q, n, m)
+    void *q;
+    unsigned n, m;
+{
+    void *p;
+
+    (void)q;
+    p = malloc((size_t)n * m);
+    if (p != NULL)
+        memset(p, 0xab, (size_t)n * m);
+    return p;
+}
+
+void poison_free(q, p)
+    void *q;
+    void *p;
+{
+    (void)q;
+    free(p);
+}
+
+/* ===========================================================================
+ * Test that inflate() leaves strm->adler alone when it computes no check
+ * value: for a raw stream, and for a zlib stream after inflateValidate(0)
+ */
+void test_check_unused()
+{
+    int err, wbits;
+    Byte *data, *compr, *out;
+    uLong k, comprLen;
+    z_stream c_stream, d_stream;
+
+    data = (Byte*)malloc(20000L);
+    compr = (Byte*)malloc(30000L);
+    out = (Byte*)malloc(20000L);
+    if (data == Z_NULL || compr == Z_NULL || out == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (k = 0; k < 20000L; k++)
+        data[k] = (Byte)("0123456789 hello world\n"[k % 23] + k / 997);
+
+    for (wbits = -15; wbits <= 15; wbits += 30) {
+        c_stream.zalloc = zalloc;
+        c_stream.zfree = zfree;
+        c_stream.opaque = (voidpf)0;
+        err = deflateInit2(&c_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                           wbits, 8, Z_DEFAULT_STRATEGY);
+        CHECK_ERR(err, "deflateInit2");
+        c_stream.next_in = data;
+        c_stream.avail_in = 20000;
+        c_stream.next_out = compr;
+        c_stream.avail_out = 30000;
+        err = deflate(&c_stream, Z_FINISH);
+        if (err != Z_STREAM_END) {
+            fprintf(stderr, "deflate should report Z_STREAM_END\n");
+            exit(1);
+        }
+        comprLen = c_stream.total_out;
+        err = deflateEnd(&c_stream);
+        CHECK_ERR(err, "deflateEnd");
+
+        d_stream.zalloc = poison_alloc;
+        d_stream.zfree = poison_free;
+        d_stream.opaque = (voidpf)0;
+        d_stream.adler = 0;             /* left alone for a raw stream */
+        err = inflateInit2(&d_stream, wbits);
+        CHECK_ERR(err, "inflateInit2");
+        if (wbits > 0) {
+            err = inflateValidate(&d_stream, 0);
+            CHECK_ERR(err, "inflateValidate");
+        }
+        d_stream.next_in = compr;
+        d_stream.avail_in = (uInt)comprLen;
+        d_stream.next_out = out;
+        d_stream.avail_out = 20000;
+        err = inflate(&d_stream, Z_FINISH);
+        if (err != Z_STREAM_END || d_stream.total_out != 20000L ||
+            memcmp(out, data, 20000)) {
+            fprintf(stderr, "inflate failed without a check value\n");
+            exit(1);
+        }
+        if (d_stream.adler != (wbits > 0 ? 1 : 0)) {
+            fprintf(stderr, "inflate set an unused check value: %lx\n",
+                    d_stream.adler);
+            exit(1);
+        }
+        err = inflateEnd(&d_stream);
+        CHECK_ERR(err, "inflateEnd");
+    }
+    printf("inflate() without a check value: OK\n");
+
+    free(out);
+    free(compr);
+    free(data);
+}
+
+/* ===========================================================================
+ * Test that crc32_z() on a whole buffer, which may use the folding code for
+ * the processor, agrees with crc32() a byte at a time, which does not, for
+ * every length up to 4096 and each alignment
+ */
+void test_crc32()
+{
+    static Byte data[4096 + 16];
+    static uLong run[4096 + 1];
+    uLong k, x = 1, off, len;
+
+    for (k = 0; k < sizeof(data); k++) {
+        x = x * 1103515245L + 12345;
+        data[k] = (Byte)(x >> 16);
+    }
+    for (off = 0; off < 16; off++) {
+        run[0] = crc32(0L, Z_NULL, 0);
+        for (len = 1; len <= 4096; len++)
+            run[len] = crc32(run[len - 1], data + off + len - 1, 1);
+        for (len = 0; len <= 4096; len++)
+            if (crc32_z(0L, data + off, len) != run[len]) {
+                fprintf(stderr, "bad crc32 at offset %lu, length %lu\n",
+                        off, len);
+                exit(1);
+            }
+    }
+    printf("crc32_z(): %08lx\n", run[4096]);
+}
+
+/* ===========================================================================
+ * Test crc32c_z() on the standard check string, on a whole buffer against a
+ * byte at a time for lengths that cross the interleaved batches, and
+ * crc32c_combine() on two halves
+ */
+void test_crc32c()
+{
+    static Byte data[100000 + 8];
+    uLong k, x = 1, off, len, end, run, crc1, crc2;
+
+    if (crc32c_z(0L, (const Bytef *)"123456789", 9) != 0xe3069283UL) {
+        fprintf(stderr, "bad crc32c check value\n");
+        exit(1);
+    }
+    for (k = 0; k < sizeof(data); k++) {
+        x = x * 1103515245L + 12345;
+        data[k] = (Byte)(x >> 16);
+    }
+    for (off = 0; off < 8; off += 3) {
+        run = crc32c_z(0L, Z_NULL, 0);
+        for (len = 0, end = 0; len <= 100000; len++) {
+            if (len == end) {
+                if (crc32c_z(0L, data + off, len) != run) {
+                    fprintf(stderr, "bad crc32c at offset %lu, length %lu\n",
+                            off, len);
+                    exit(1);
+                }
+                end += end < 100 ? 1 : 997;
+            }
+            run = crc32c_z(run, data + off + len, 1);
+        }
+    }
+    crc1 = crc32c_z(0L, data, 40000);
+    crc2 = crc32c_z(0L, data + 40000, 60000);
+    if (crc32c_combine(crc1, crc2, 60000) != crc32c_z(0L, data, 100000)) {
+        fprintf(stderr, "bad crc32c_combine\n");
+        exit(1);
+    }
+    printf("crc32c_z(): %08lx\n", run);
+}
+
+/* ===========================================================================
+ * Test that adler32_z() on a whole buffer agrees with adler32() a byte at a
+ * time, for lengths that cross the vector and modulo block sizes, with bytes
+ * of all ones to make the sums as large as possible, and each alignment
+ */
+void test_adler32()
+{
+    static Byte data[12000 + 32];
+    uLong run, off, len, end;
+
+    memset(data, 0xff, sizeof(data));
+    for (off = 0; off < 32; off += 7) {
+        run = adler32(0L, Z_NULL, 0);
+        for (len = 0, end = 0; len <= 12000; len++) {
+            if (len == end) {
+                if (adler32_z(1L, data + off, len) != run) {
+                    fprintf(stderr, "bad adler32 at offset %lu, length %lu\n",
+                            off, len);
+                    exit(1);
+                }
+                end += end < 100 ? 1 : 31;
+            }
+            run = adler32(run, data + off + len, 1);
+        }
+    }
+    printf("adler32_z(): %08lx\n", run);
+}
+
+/* ===========================================================================
+ * Test that crc32_copy() and adler32_copy() copy the data and compute the
+ * same check values as crc32_z() and adler32_z(), over several chunks
+ */
+void test_check_copy()
+{
+    static Byte src[10007], dst[10007];
+    uLong k, x = 1, crc, adler;
+
+    for (k = 0; k < sizeof(src); k++) {
+        x = x * 1103515245L + 12345;
+        src[k] = (Byte)(x >> 16);
+    }
+    crc = crc32_copy(crc32_copy(0L, Z_NULL, Z_NULL, 0), dst, src, 10007);
+    if (crc != crc32_z(0L, src, 10007) || memcmp(dst, src, 10007)) {
+        fprintf(stderr, "bad crc32_copy\n");
+        exit(1);
+    }
+    memset(dst, 0, sizeof(dst));
+    adler = adler32_copy(adler32_copy(0L, Z_NULL, Z_NULL, 0), dst + 1,
+                         src + 1, 10006);
+    if (adler != adler32_z(1L, src + 1, 10006) ||
+        memcmp(dst + 1, src + 1, 10006)) {
+        fprintf(stderr, "bad adler32_copy\n");
+        exit(1);
+    }
+    printf("crc32_copy(): %08lx, adler32_copy(): %08lx\n", crc, adler);
+}
+
+/* ===========================================================================
+ * Test that crc32_parallel() and adler32_parallel() agree with crc32_z() and
+ * adler32_z() for a buffer long enough to be cut into uneven pieces
+ */
+void test_check_parallel()
+{
+    uLong k, x = 1, len = 5000001L, crc, adler;
+    Byte *data;
+
+    data = (Byte*)malloc(len);
+    if (data == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (k = 0; k < len; k++) {
+        x = x * 1103515245L + 12345;
+        data[k] = (Byte)(x >> 16);
+    }
+    crc = crc32_z(12345L, data, len);
+    adler = adler32_z(12345L, data, len);
+    if (crc32_parallel(12345L, data, len, 3) != crc ||
+        adler32_parallel(12345L, data, len, 3) != adler ||
+        crc32_parallel(12345L, data, len, 0) != crc ||
+        adler32_parallel(12345L, data, len, 0) != adler) {
+        fprintf(stderr, "parallel check value differs\n");
+        exit(1);
+    }
+    printf("crc32_parallel(): %08lx, adler32_parallel(): %08lx\n", crc,
+           adler);
+    free(data);
+}
+
 /* ===========================================================================
  * Test read/write of .gz files
  */
@@ -192,6 +1180,92 @@ void test_gzio(fname, uncompr, uncomprLen)
 #endif
 }
 
+/* ===========================================================================
+ * Test reading a .gz file of many gzip streams with gzthreads()
+ */
+void test_gzio_threads(fname)
+    const char *fname; /* compressed file name */
+{
+#ifdef NO_GZCOMPRESS
+    fprintf(stderr, "NO_GZCOMPRESS -- gz* functions cannot compress\n");
+#else
+    int err, c;
+    uLong k, n, x = 1, len = 4000000L;
+    Byte *data, *out;
+    gzFile file;
+
+    data = (Byte*)malloc(len);
+    out = (Byte*)malloc(len);
+    if (data == Z_NULL || out == Z_NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (k = 0; k < len; k++) {     /* mostly literals, with some matches */
+        x = x * 1103515245L + 12345;
+        data[k] = k < 32768 || (x >> 16) % 4 ? (Byte)((x >> 20) % 32) :
+                  data[k - 1 - (x >> 17) % 32768];
+    }
+
+    /* write a gzip stream for each piece of uneven length */
+    file = gzopen(fname, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "gzopen error\n");
+        exit(1);
+    }
+    for (k = 0; k < len; k += n) {
+        n = 20000 + (k / 7) % 50000;
+        if (n > len - k)
+            n = len - k;
+        if (gzwrite(file, data + k, (unsigned)n) != (int)n ||
+            gzflush(file, Z_FINISH) != Z_OK) {
+            fprintf(stderr, "gzwrite err: %s\n", gzerror(file, &err));
+            exit(1);
+        }
+    }
+    gzclose(file);
+
+    /* read it back in uneven pieces, with a gzungetc() along the way */
+    file = gzopen(fname, "rb");
+    if (file == NULL || gzthreads(file, 4) != 0) {
+        fprintf(stderr, "gzopen error\n");
+        exit(1);
+    }
+    for (k = 0; k < len; k += n) {
+        n = 1 + (k / 3) % 70000;
+        if (n > len - k)
+            n = len - k;
+        if (gzread(file, out + k, (unsigned)n) != (int)n) {
+            fprintf(stderr, "gzread err: %s\n", gzerror(file, &err));
+            exit(1);
+        }
+        if (k == 1000000L) {
+            c = gzgetc(file);
+            if (c != data[k + n] || gzungetc(c, file) != c) {
+                fprintf(stderr, "gzgetc error\n");
+                exit(1);
+            }
+        }
+    }
+    if (gzread(file, out, 1) != 0 || !gzeof(file) || memcmp(out, data, len)) {
+        fprintf(stderr, "bad gzread with threads\n");
+        exit(1);
+    }
+
+    /* read it all at once after a rewind */
+    memset(out, 0, len);
+    if (gzrewind(file) != 0 || gzread(file, out, (unsigned)len) != (int)len ||
+        memcmp(out, data, len)) {
+        fprintf(stderr, "bad gzread with threads after gzrewind\n");
+        exit(1);
+    }
+    gzclose(file);
+    printf("gzread() with gzthreads(): OK\n");
+
+    free(out);
+    free(data);
+#endif
+}
+
 #endif /* Z_SOLO */
 
 /* ===========================================================================
@@ -319,6 +1393,27 @@ void test_large_deflate(compr, comprLen, uncompr, uncomprLen)
     err = deflate(&c_stream, Z_NO_FLUSH);
     CHECK_ERR(err, "deflate");
 
+    /* Then to a middle level, which matches differently from the last: */
+    deflateParams(&c_stream, 5, Z_DEFAULT_STRATEGY);
+    c_stream.next_in = uncompr;
+    c_stream.avail_in = (uInt)uncomprLen;
+    err = deflate(&c_stream, Z_NO_FLUSH);
+    CHECK_ERR(err, "deflate");
+
+    /* Then to optimal parsing, which takes the input in chunks: */
+    deflateParams(&c_stream, Z_OPTIMAL_COMPRESSION, Z_DEFAULT_STRATEGY);
+    c_stream.next_in = uncompr;
+    c_stream.avail_in = (uInt)uncomprLen;
+    err = deflate(&c_stream, Z_NO_FLUSH);
+    CHECK_ERR(err, "deflate");
+
+    /* And to the quick strategy, which keeps its block open across calls: */
+    deflateParams(&c_stream, Z_BEST_SPEED, Z_QUICK);
+    c_stream.next_in = uncompr;
+    c_stream.avail_in = (uInt)uncomprLen;
+    err = deflate(&c_stream, Z_NO_FLUSH);
+    CHECK_ERR(err, "deflate");
+
     err = deflate(&c_stream, Z_FINISH);
     if (err != Z_STREAM_END) {
         fprintf(stderr, "deflate should report Z_STREAM_END\n");
@@ -361,7 +1456,7 @@ void test_large_inflate(compr, comprLen, uncompr, uncomprLen)
     err = inflateEnd(&d_stream);
     CHECK_ERR(err, "inflateEnd");
 
-    if (d_stream.total_out != 2*uncomprLen + comprLen/2) {
+    if (d_stream.total_out != 5*uncomprLen + comprLen/2) {
         fprintf(stderr, "bad large inflate: %ld\n", d_stream.total_out);
         exit(1);
     } else {
@@ -450,6 +1545,54 @@ void test_sync(compr, comprLen, uncompr, uncomprLen)
     printf("after inflateSync(): hel%s\n", (char *)uncompr);
 }
 
+/* ===========================================================================
+ * Test that inflateSync() stops just after the first 00 00 ff ff marker at
+ * each offset, past near misses, with the input given in pieces of several
+ * sizes so that a partial marker is carried from one call to the next
+ */
+void test_sync_search()
+{
+    static const Byte miss[] = {0, 0, 0, 0xff, 0, 0xff, 0xff, 0, 0, 0, 0xff};
+    static Byte data[300];
+    z_stream d_stream;
+    uLong x = 1;
+    uInt off, piece, k, used;
+    int err;
+
+    for (off = 0; off < 100; off++) {
+        for (k = 0; k < sizeof(data); k++) {
+            x = x * 1103515245UL + 12345;
+            data[k] = (Byte)((x >> 16) & 0x7e) + 1;    /* not 0 or ff */
+        }
+        memcpy(data + off % 37, miss, sizeof(miss));
+        memcpy(data + off + 50, "\0\0\377\377", 4);
+        for (piece = 1; piece < sizeof(data); piece += piece < 8 ? 1 : 61) {
+            d_stream.zalloc = zalloc;
+            d_stream.zfree = zfree;
+            d_stream.opaque = (voidpf)0;
+            err = inflateInit2(&d_stream, -MAX_WBITS);
+            CHECK_ERR(err, "inflateInit2");
+            d_stream.next_in = data;
+            used = 0;
+            do {
+                d_stream.avail_in = piece < sizeof(data) - used ? piece :
+                                    (uInt)sizeof(data) - used;
+                err = inflateSync(&d_stream);
+                used = (uInt)(d_stream.next_in - data);
+            } while (err == Z_DATA_ERROR && used < sizeof(data));
+            CHECK_ERR(err, "inflateSync");
+            if (used != off + 54) {
+                fprintf(stderr, "inflateSync stopped at %u, not %u\n",
+                        used, off + 54);
+                exit(1);
+            }
+            err = inflateEnd(&d_stream);
+            CHECK_ERR(err, "inflateEnd");
+        }
+    }
+    printf("inflateSync() search: OK\n");
+}
+
 /* ===========================================================================
  * Test deflate() with preset dictionary
  */
@@ -576,9 +1719,23 @@ int main(argc, argv)
     (void)argv;
 #else
     test_compress(compr, comprLen, uncompr, uncomprLen);
+    test_compress_parallel();
+    test_split();
+    test_tune();
+    test_keep_output();
+    test_inflate_parallel();
+    test_inflate_buffer();
+    test_inflate_back();
+    test_check_unused();
+    test_crc32();
+    test_crc32c();
+    test_adler32();
+    test_check_copy();
+    test_check_parallel();
 
     test_gzio((argc > 1 ? argv[1] : TESTFILE),
               uncompr, uncomprLen);
+    test_gzio_threads(argc > 1 ? argv[1] : TESTFILE);
 #endif
 
     test_deflate(compr, comprLen);
@@ -589,6 +1746,7 @@ int main(argc, argv)
 
     test_flush(compr, &comprLen);
     test_sync(compr, comprLen, uncompr, uncomprLen);
+    test_sync_search();
     comprLen = uncomprLen;
 
     test_dict_deflate(compr, comprLen);
@@ -341,6 +341,8 @@ void gz_compress      OF((FILE   *in, gzFile out));
 int  gz_compress_mmap OF((FILE   *in, gzFile out));
 #endif
 void gz_uncompress    OF((gzFile in, FILE   *out));
+int  gz_put           OF((void *out, unsigned char *buf, unsigned len));
+int  gz_uncompress_all OF((FILE  *in, FILE   *out));
 void file_compress    OF((char  *file, char *mode));
 void file_uncompress  OF((char  *file));
 int  main             OF((int argc, char *argv[]));
@@ -435,6 +437,9 @@ void gz_uncompress(in, out)
     int len;
     int err;
 
+#ifndef Z_SOLO
+    gzthreads(in, 0);       /* decompress gzip members in parallel */
+#endif
     for (;;) {
         len = gzread(in, buf, sizeof(buf));
         if (len < 0) error (gzerror(in, &err));
@@ -449,6 +454,81 @@ void gz_uncompress(in, out)
     if (gzclose(in) != Z_OK) error("failed gzclose");
 }
 
+/* ===========================================================================
+ * Write decompressed data for inflateParallel(). Return non-zero on error.
+ */
+int gz_put(out, buf, len)
+    void *out;
+    unsigned char *buf;
+    unsigned len;
+{
+    return fwrite(buf, 1, len, (FILE *)out) != len;
+}
+
+/* ===========================================================================
+ * Try uncompressing the whole gzip input file at once with inflateParallel().
+ * Return Z_OK if success, closing both files, or Z_ERRNO if the input is not
+ * a gzip file that can be read all at once, leaving it at its start and
+ * writing nothing.
+ */
+int gz_uncompress_all(in, out)
+    FILE   *in;
+    FILE   *out;
+{
+    unsigned char *buf;
+    z_size_t len, used;
+    int err;
+#ifdef USE_MMAP
+    struct stat sb;
+
+    /* map the whole file */
+    if (fstat(fileno(in), &sb) < 0 || sb.st_size < 2 ||
+        (z_size_t)sb.st_size != (size_t)sb.st_size)
+        return Z_ERRNO;
+    len = (z_size_t)sb.st_size;
+    buf = (unsigned char *)mmap((caddr_t)0, len, PROT_READ, MAP_SHARED,
+                                fileno(in), (off_t)0);
+    if (buf == (unsigned char *)(-1)) return Z_ERRNO;
+#else
+    long size;
+
+    /* read the whole file */
+    if (fseek(in, 0L, SEEK_END) || (size = ftell(in)) < 2 ||
+        fseek(in, 0L, SEEK_SET))
+        return Z_ERRNO;
+    len = (z_size_t)size;
+    buf = (unsigned char *)malloc(len);
+    if (buf == NULL) return Z_ERRNO;
+    if (fread(buf, 1, len, in) != len) {
+        free(buf);
+        rewind(in);
+        return Z_ERRNO;
+    }
+#endif
+
+    /* decompress it, if it is gzip */
+    err = Z_ERRNO;
+    if (buf[0] == 31 && buf[1] == 139) {
+        used = len;
+        err = inflateParallel(buf, &used, 31, gz_put, out, 0);
+        if (err == Z_BUF_ERROR) error("failed fwrite");
+        if (err != Z_OK) error(err == Z_MEM_ERROR ? "out of memory" :
+                                                    "invalid compressed data");
+    }
+#ifdef USE_MMAP
+    munmap(buf, len);
+#else
+    free(buf);
+#endif
+    if (err != Z_OK) {
+        rewind(in);
+        return err;
+    }
+    fclose(in);
+    if (fclose(out)) error("failed fclose");
+    return Z_OK;
+}
+
 
 /* ===========================================================================
  * Compress the given file: create a corresponding .gz file and remove the
@@ -498,7 +578,7 @@ void file_uncompress(file)
 {
     local char buf[MAX_NAME_LEN];
     char *infile, *outfile;
-    FILE  *out;
+    FILE  *raw, *out;
     gzFile in;
     unsigned len = strlen(file);
 
@@ -526,6 +606,20 @@ void file_uncompress(file)
         strcat(infile, GZ_SUFFIX);
 #endif
     }
+    raw = fopen(infile, "rb");
+    if (raw != NULL) {
+        out = fopen(outfile, "wb");
+        if (out == NULL) {
+            perror(file);
+            exit(1);
+        }
+        if (gz_uncompress_all(raw, out) == Z_OK) {
+            unlink(infile);
+            return;
+        }
+        fclose(out);
+        fclose(raw);
+    }
     in = gzopen(infile, "rb");
     if (in == NULL) {
         fprintf(stderr, "%s: can't gzopen %s\n", prog, infile);
@@ -544,12 +638,13 @@ void file_uncompress(file)
 
 
 /* ===========================================================================
- * Usage:  minigzip [-c] [-d] [-f] [-h] [-r] [-1 to -9] [files...]
+ * Usage:  minigzip [-c] [-d] [-f] [-h] [-r] [-q] [-1 to -9] [files...]
  *   -c : write to standard output
  *   -d : decompress
  *   -f : compress with Z_FILTERED
  *   -h : compress with Z_HUFFMAN_ONLY
  *   -r : compress with Z_RLE
+ *   -q : compress with Z_QUICK
  *   -1 to -9 : compression level
  */
 
@@ -592,6 +687,8 @@ int main(argc, argv)
         outmode[3] = 'h';
       else if (strcmp(*argv, "-r") == 0)
         outmode[3] = 'R';
+      else if (strcmp(*argv, "-q") == 0)
+        outmode[3] = 'Q';
       else if ((*argv)[0] == '-' && (*argv)[1] >= '1' && (*argv)[1] <= '9' &&
                (*argv)[2] == 0)
         outmode[2] = (*argv)[1];
@@ -620,6 +717,13 @@ int main(argc, argv)
         do {
             if (uncompr) {
                 if (copyout) {
+                    FILE * in = fopen(*argv, "rb");
+
+                    if (in != NULL) {
+                        if (gz_uncompress_all(in, stdout) == Z_OK)
+                            continue;
+                        fclose(in);
+                    }
                     file = gzopen(*argv, "rb");
                     if (file == NULL)
                         fprintf(stderr, "%s: can't gzopen %s\n", prog, *argv);
@@ -0,0 +1,796 @@
+/* zbench.c -- micro-benchmarks of zlib's internal routines
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* Usage: zbench [name ...]
+
+   Run the named benchmarks, or all of them if none are named. Each one times
+   the portable C version of an internal routine and each of the vectorized
+   versions that the processor supports, checks that they all produce the
+   same result, and prints the time per call and the speedup over C (over the
+   braided calculation for crc32). crc32 and adler32 are timed for a range of
+   lengths. The syncsearch benchmark instead times inflateSync() against a
+   byte-at-a-time search, the quick benchmark compares the Z_QUICK strategy
+   with level 1, the levels benchmark compares the speed and size of levels 1
+   to 12, the block benchmark times the sending of a block of symbols from
+   each level, and the inflate benchmark times decompression of the output of
+   a few levels.
+
+   This reaches into the library's internals, so it must be linked with the
+   static library. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "deflate.h"
+
+/* -- timing -- */
+
+/* Return the processor time used so far, in nanoseconds. */
+local double now OF((void));
+local double now()
+{
+    return (double)clock() * (1e9 / CLOCKS_PER_SEC);
+}
+
+/* Fill buf[0..len-1] with pseudo-random bytes from a fixed seed, so that every
+   run and every version sees the same data. */
+local void fill_random OF((unsigned char *buf, size_t len));
+local void fill_random(buf, len)
+    unsigned char *buf;
+    size_t len;
+{
+    unsigned long x = 1;
+
+    while (len--) {
+        x = x * 1103515245UL + 12345;
+        *buf++ = (unsigned char)(x >> 16);
+    }
+}
+
+/* Print one result line, with the speedup relative to base if base is not
+   zero. */
+local void report OF((const char *name, double ns, double base));
+local void report(name, ns, base)
+    const char *name;
+    double ns;
+    double base;
+{
+    if (base > 0)
+        printf("  %-8s %12.1f ns  %5.2fx\n", name, ns, base / ns);
+    else
+        printf("  %-8s %12.1f ns\n", name, ns);
+}
+
+/* -- slide_hash -- */
+
+#define SLIDE_ENTRIES 65536U    /* head[] plus prev[] for the default state */
+#define SLIDE_WSIZE 32768U
+#define SLIDE_REPS 20000
+
+typedef void (*slide_func) OF((Posf *, unsigned, uInt));
+
+/* Return the average time in nanoseconds to slide a table, starting from a
+   fresh copy of orig each time so that the values stay realistic. The cost of
+   the copy is measured separately and removed. If slide is NULL, return the
+   time for just the copy. The final table is left in tab. */
+local double time_slide OF((slide_func slide, Posf *tab, const Posf *orig));
+local double time_slide(slide, tab, orig)
+    slide_func slide;
+    Posf *tab;
+    const Posf *orig;
+{
+    int i;
+    double start;
+
+    start = now();
+    for (i = 0; i < SLIDE_REPS; i++) {
+        memcpy(tab, orig, SLIDE_ENTRIES * sizeof(Pos));
+        if (slide != NULL)
+            slide(tab, SLIDE_ENTRIES, SLIDE_WSIZE);
+    }
+    return (now() - start) / SLIDE_REPS;
+}
+
+local void bench_slide OF((void));
+local void bench_slide()
+{
+    static const struct {
+        const char *name;
+        slide_func slide;
+        unsigned need;
+    } kern[] = {
+#ifdef Z_X86_SIMD
+        {"sse2", slide_hash_sse2, Z_CPU_SSE2},
+        {"avx2", slide_hash_avx2, Z_CPU_AVX2},
+#endif
+#ifdef Z_ARM_SIMD
+        {"neon", slide_hash_neon, Z_CPU_NEON},
+#endif
+        {NULL, NULL, 0}
+    };
+    Posf *orig, *ref, *tab;
+    double copy, base, ns;
+    int k;
+
+    orig = malloc(SLIDE_ENTRIES * sizeof(Pos));
+    ref = malloc(SLIDE_ENTRIES * sizeof(Pos));
+    tab = malloc(SLIDE_ENTRIES * sizeof(Pos));
+    if (orig == NULL || ref == NULL || tab == NULL) {
+        fprintf(stderr, "zbench: out of memory\n");
+        exit(1);
+    }
+    fill_random((unsigned char *)orig, SLIDE_ENTRIES * sizeof(Pos));
+
+    printf("slide_hash: %u entries, window %u, time per slide\n",
+           SLIDE_ENTRIES, SLIDE_WSIZE);
+    copy = time_slide(NULL, tab, orig);
+    base = time_slide(slide_hash_c, ref, orig) - copy;
+    report("c", base, 0);
+    for (k = 0; kern[k].name != NULL; k++) {
+#if defined(Z_X86_SIMD) || defined(Z_ARM_SIMD)
+        if ((z_cpu_features() & kern[k].need) == 0)
+            continue;
+#endif
+        ns = time_slide(kern[k].slide, tab, orig) - copy;
+        if (memcmp(tab, ref, SLIDE_ENTRIES * sizeof(Pos))) {
+            fprintf(stderr, "zbench: slide_hash_%s result differs from C\n",
+                    kern[k].name);
+            exit(1);
+        }
+        report(kern[k].name, ns, base);
+    }
+    free(tab);
+    free(ref);
+    free(orig);
+}
+
+/* -- crc32 and adler32 -- */
+
+#define CHECK_MAX 1048576U      /* longest buffer to check */
+#define CHECK_BYTES 33554432.0  /* bytes to check for each timing */
+
+typedef unsigned long (*check_func) OF((unsigned long,
+                                        const unsigned char FAR *, z_size_t));
+
+typedef struct {
+    const char *name;
+    check_func check;
+    unsigned need;
+} check_kern;
+
+/* Return the average time in nanoseconds to compute the check value of
+   buf[0..len-1] with check, and set *got to the check value. */
+local double time_check OF((check_func check, const unsigned char *buf,
+                            unsigned len, unsigned long *got));
+local double time_check(check, buf, len, got)
+    check_func check;
+    const unsigned char *buf;
+    unsigned len;
+    unsigned long *got;
+{
+    long i, reps = (long)(CHECK_BYTES / len);
+    unsigned long val = 0;
+    double start;
+
+    start = now();
+    for (i = 0; i < reps; i++)
+        val = check(val, buf, len);
+    *got = val;
+    return (now() - start) / reps;
+}
+
+/* Time the check value named what with the base version, called name, and
+   with each of the versions in kern[] that the processor supports, for
+   lengths from 16 bytes to CHECK_MAX. */
+local void bench_check OF((const char *what, const char *name, check_func base,
+                           const check_kern *kern));
+local void bench_check(what, name, base, kern)
+    const char *what;
+    const char *name;
+    check_func base;
+    const check_kern *kern;
+{
+    unsigned char *buf;
+    unsigned len;
+    unsigned long ref, got;
+    double ns, ref_ns;
+    int k;
+
+    buf = malloc(CHECK_MAX + 1);
+    if (buf == NULL) {
+        fprintf(stderr, "zbench: out of memory\n");
+        exit(1);
+    }
+    fill_random(buf, CHECK_MAX + 1);
+
+    printf("%s: time per call by length, from an odd address\n", what);
+    for (len = 16; len <= CHECK_MAX; len <<= 4) {
+        printf(" %u bytes\n", len);
+        ref_ns = time_check(base, buf + 1, len, &ref);
+        report(name, ref_ns, 0);
+        for (k = 0; kern[k].name != NULL; k++) {
+#if defined(Z_X86_SIMD) || defined(Z_ARM_SIMD)
+            if ((z_cpu_features() & kern[k].need) == 0)
+                continue;
+#endif
+            ns = time_check(kern[k].check, buf + 1, len, &got);
+            if (got != ref) {
+                fprintf(stderr, "zbench: %s_%s result differs from %s\n",
+                        what, kern[k].name, name);
+                exit(1);
+            }
+            report(kern[k].name, ns, ref_ns);
+        }
+    }
+    free(buf);
+}
+
+local void bench_crc32 OF((void));
+local void bench_crc32()
+{
+    static const check_kern kern[] = {
+#ifdef Z_X86_SIMD
+        {"pclmul", crc32_pclmul, Z_CPU_PCLMUL},
+#  ifdef Z_X86_AVX512
+        {"vpclmul", crc32_vpclmul, Z_CPU_VPCLMUL},
+#  endif
+#endif
+        {NULL, NULL, 0}
+    };
+
+    bench_check("crc32", "braid", crc32_base, kern);
+}
+
+local void bench_crc32c OF((void));
+local void bench_crc32c()
+{
+    static const check_kern kern[] = {
+#ifdef Z_X86_SIMD
+        {"sse42", crc32c_sse42, Z_CPU_SSE42},
+#endif
+        {NULL, NULL, 0}
+    };
+
+    bench_check("crc32c", "base", crc32c_base, kern);
+}
+
+local void bench_adler32 OF((void));
+local void bench_adler32()
+{
+    static const check_kern kern[] = {
+#ifdef Z_X86_SIMD
+        {"ssse3", adler32_ssse3, Z_CPU_SSSE3},
+        {"avx2", adler32_avx2, Z_CPU_AVX2},
+#endif
+#ifdef Z_ARM_SIMD
+        {"neon", adler32_neon, Z_CPU_NEON},
+#endif
+        {NULL, NULL, 0}
+    };
+
+    bench_check("adler32", "c", adler32_base, kern);
+}
+
+/* -- deflate_quick -- */
+
+#define QUICK_LEN 1048576U
+#define QUICK_REPS 20
+
+/* Fill buf[0..len-1] with words drawn pseudo-randomly from a small vocabulary,
+   which compresses about as well as ordinary text. */
+local void fill_words OF((unsigned char *buf, size_t len));
+local void fill_words(buf, len)
+    unsigned char *buf;
+    size_t len;
+{
+    static const char *const word[16] = {
+        "the", "of", "compression", "and", "window", "a", "match", "to",
+        "in", "string", "is", "literal", "that", "block", "for", "distance"
+    };
+    unsigned long x = 1;
+    const char *w;
+
+    while (len) {
+        x = x * 1103515245UL + 12345;
+        for (w = word[(x >> 16) & 15]; *w && len; len--)
+            *buf++ = (unsigned char)*w++;
+        if (len) {
+            *buf++ = (x >> 24) % 12 ? ' ' : '\n';
+            len--;
+        }
+    }
+}
+
+/* Return the average time in nanoseconds to compress len bytes from in to out
+   with level and strategy, and set *got to the compressed length. */
+local double time_deflate OF((int level, int strategy, const unsigned char *in,
+                              unsigned len, unsigned char *out, unsigned size,
+                              uLong *got));
+local double time_deflate(level, strategy, in, len, out, size, got)
+    int level;
+    int strategy;
+    const unsigned char *in;
+    unsigned len;
+    unsigned char *out;
+    unsigned size;
+    uLong *got;
+{
+    z_stream strm;
+    int i;
+    double start;
+
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    if (deflateInit2(&strm, level, Z_DEFLATED, 15, 8, strategy) != Z_OK) {
+        fprintf(stderr, "zbench: deflateInit2 failed\n");
+        exit(1);
+    }
+    start = now();
+    for (i = 0; i < QUICK_REPS; i++) {
+        deflateReset(&strm);
+        strm.next_in = (z_const Bytef *)in;
+        strm.avail_in = len;
+        strm.next_out = out;
+        strm.avail_out = size;
+        if (deflate(&strm, Z_FINISH) != Z_STREAM_END) {
+            fprintf(stderr, "zbench: deflate failed\n");
+            exit(1);
+        }
+    }
+    start = (now() - start) / QUICK_REPS;
+    *got = strm.total_out;
+    deflateEnd(&strm);
+    return start;
+}
+
+local void bench_quick OF((void));
+local void bench_quick()
+{
+    unsigned char *in, *out, *back;
+    unsigned size = (unsigned)compressBound(QUICK_LEN) + QUICK_LEN / 8;
+    uLong fast, quick, len = QUICK_LEN;
+    double base, ns;
+
+    in = malloc(QUICK_LEN);
+    out = malloc(size);
+    back = malloc(QUICK_LEN);
+    if (in == NULL || out == NULL || back == NULL) {
+        fprintf(stderr, "zbench: out of memory\n");
+        exit(1);
+    }
+    fill_words(in, QUICK_LEN);
+
+    printf("deflate: %u bytes of text, time per compression\n", QUICK_LEN);
+    base = time_deflate(1, Z_DEFAULT_STRATEGY, in, QUICK_LEN, out, size,
+                        &fast);
+    report("level 1", base, 0);
+    ns = time_deflate(1, Z_QUICK, in, QUICK_LEN, out, size, &quick);
+    if (uncompress(back, &len, out, quick) != Z_OK || len != QUICK_LEN ||
+        memcmp(back, in, QUICK_LEN)) {
+        fprintf(stderr, "zbench: Z_QUICK output does not decompress\n");
+        exit(1);
+    }
+    report("quick", ns, base);
+    printf("  compressed to %lu with level 1, %lu with quick\n", fast, quick);
+    free(back);
+    free(out);
+    free(in);
+}
+
+/* -- compression levels -- */
+
+local void bench_levels OF((void));
+local void bench_levels()
+{
+    unsigned char *in, *out, *back;
+    unsigned size = (unsigned)compressBound(QUICK_LEN);
+    uLong got, len;
+    double base = 0, ns;
+    int level;
+
+    in = malloc(QUICK_LEN);
+    out = malloc(size);
+    back = malloc(QUICK_LEN);
+    if (in == NULL || out == NULL || back == NULL) {
+        fprintf(stderr, "zbench: out of memory\n");
+        exit(1);
+    }
+    fill_words(in, QUICK_LEN);
+
+    printf("deflate: %u bytes of text, time per compression by level\n",
+           QUICK_LEN);
+    for (level = 1; level <= Z_OPTIMAL_COMPRESSION; level++) {
+        ns = time_deflate(level, Z_DEFAULT_STRATEGY, in, QUICK_LEN, out, size,
+                          &got);
+        len = QUICK_LEN;
+        if (uncompress(back, &len, out, got) != Z_OK || len != QUICK_LEN ||
+            memcmp(back, in, QUICK_LEN)) {
+            fprintf(stderr, "zbench: level %d output does not decompress\n",
+                    level);
+            exit(1);
+        }
+        if (level == 1)
+            base = ns;
+        printf("  level %2d %12.1f ns  %5.2fx  %8lu bytes\n", level, ns,
+               base / ns, got);
+    }
+    free(back);
+    free(out);
+    free(in);
+}
+
+/* -- compress_block -- */
+
+#define BLOCK_PIECE 1024U
+#define BLOCK_REPS 200
+
+/* A block of symbols and their counts, as left by deflate with memLevel 9 */
+typedef struct {
+    ct_data ltree[HEAP_SIZE];
+    ct_data dtree[2*D_CODES+1];
+    uInt sym_next;
+    uch sym_buf[3 * 32768U];
+} block_copy;
+
+/* Deflate text from in at level, a piece at a time, until at least a quarter
+   of the symbol buffer is full, without a block having been emitted. Save the
+   block in blk, and return the number of input bytes that it covers. */
+local unsigned fill_block OF((z_stream *strm, int level,
+                              const unsigned char *in, unsigned char *out,
+                              block_copy *blk));
+local unsigned fill_block(strm, level, in, out, blk)
+    z_stream *strm;
+    int level;
+    const unsigned char *in;
+    unsigned char *out;
+    block_copy *blk;
+{
+    deflate_state *s;
+
+    strm->zalloc = Z_NULL;
+    strm->zfree = Z_NULL;
+    strm->opaque = Z_NULL;
+    if (deflateInit2(strm, level, Z_DEFLATED, 15, 9, Z_DEFAULT_STRATEGY) !=
+            Z_OK) {
+        fprintf(stderr, "zbench: deflateInit2 failed\n");
+        exit(1);
+    }
+    s = (deflate_state *)strm->state;
+    strm->next_in = (z_const Bytef *)in;
+    strm->next_out = out;
+    strm->avail_out = BLOCK_PIECE;
+    while (s->sym_next < s->sym_end >> 2) {
+        strm->avail_in = BLOCK_PIECE;
+        if (deflate(strm, Z_NO_FLUSH) != Z_OK || strm->total_out > 2 ||
+            s->pending) {
+            fprintf(stderr, "zbench: level %d emitted a block early\n", level);
+            exit(1);
+        }
+    }
+    memcpy(blk->ltree, s->dyn_ltree, sizeof(blk->ltree));
+    memcpy(blk->dtree, s->dyn_dtree, sizeof(blk->dtree));
+    blk->sym_next = s->sym_next;
+    memcpy(blk->sym_buf, s->sym_buf, s->sym_next);
+    return (unsigned)(s->strstart - s->block_start);
+}
+
+/* Return the average time in nanoseconds for _tr_flush_block() to build the
+   codes for the block in blk and send it, which is mostly compress_block().
+   The block is copied back each time, since sending it overwrites it, and
+   the time for that is measured and removed. Set *got to the size of the
+   block's output. */
+local double time_block OF((deflate_state *s, const block_copy *blk,
+                            uLong *got));
+local double time_block(s, blk, got)
+    deflate_state *s;
+    const block_copy *blk;
+    uLong *got;
+{
+    int i, pass;
+    double start, copy = 0;
+
+    for (pass = 0; pass < 2; pass++) {
+        start = now();
+        for (i = 0; i < BLOCK_REPS; i++) {
+            memcpy(s->dyn_ltree, blk->ltree, sizeof(blk->ltree));
+            memcpy(s->dyn_dtree, blk->dtree, sizeof(blk->dtree));
+            memcpy(s->sym_buf, blk->sym_buf, blk->sym_next);
+            s->sym_next = blk->sym_next;
+            s->pending = 0;
+            s->bi_buf = 0;
+            s->bi_valid = 0;
+            if (pass)
+                _tr_flush_block(s, (charf *)0, 0L, 0);
+        }
+        if (pass == 0)
+            copy = now() - start;
+        else
+            start = (now() - start - copy) / BLOCK_REPS;
+    }
+    *got = s->pending;
+    s->pending = 0;
+    return start;
+}
+
+local void bench_block OF((void));
+local void bench_block()
+{
+    unsigned char *in, *out;
+    block_copy *blk;
+    z_stream strm;
+    unsigned len;
+    uLong got;
+    double ns;
+    int level;
+
+    in = malloc(QUICK_LEN);
+    out = malloc(BLOCK_PIECE);
+    blk = malloc(sizeof(block_copy));
+    if (in == NULL || out == NULL || blk == NULL) {
+        fprintf(stderr, "zbench: out of memory\n");
+        exit(1);
+    }
+    fill_words(in, QUICK_LEN);
+
+    printf("compress_block: a block of text, time to send it by level\n");
+    for (level = 1; level <= Z_OPTIMAL_COMPRESSION; level++) {
+        len = fill_block(&strm, level, in, out, blk);
+        ns = time_block((deflate_state *)strm.state, blk, &got);
+        printf("  level %2d %12.1f ns  %7.1f MB/s  %5u symbols  %6lu bytes\n",
+               level, ns, len * 1e3 / ns, blk->sym_next / 3, got);
+        deflateEnd(&strm);
+    }
+    free(blk);
+    free(out);
+    free(in);
+}
+
+/* -- inflate -- */
+
+#define INFLATE_REPS 20
+#define INFLATE_PIECE 65536U    /* output space per inflate() call */
+
+/* Return the time to decompress the len bytes of zlib data at in to the
+   QUICK_LEN bytes at orig, giving inflate() piece bytes of output space at a
+   time, or all of it at once if piece is zero. */
+local double time_inflate OF((const unsigned char *in, unsigned len,
+                              const unsigned char *orig, unsigned char *out,
+                              unsigned piece));
+local double time_inflate(in, len, orig, out, piece)
+    const unsigned char *in;
+    unsigned len;
+    const unsigned char *orig;
+    unsigned char *out;
+    unsigned piece;
+{
+    z_stream strm;
+    int i, ret;
+    double start;
+
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.next_in = Z_NULL;
+    strm.avail_in = 0;
+    if (inflateInit(&strm) != Z_OK) {
+        fprintf(stderr, "zbench: inflateInit failed\n");
+        exit(1);
+    }
+    start = now();
+    for (i = 0; i < INFLATE_REPS; i++) {
+        inflateReset(&strm);
+        strm.next_in = (z_const Bytef *)in;
+        strm.avail_in = len;
+        strm.next_out = out;
+        do {
+            strm.avail_out = piece == 0 || QUICK_LEN - strm.total_out < piece ?
+                             QUICK_LEN - (unsigned)strm.total_out : piece;
+            ret = inflate(&strm, Z_NO_FLUSH);
+        } while (ret == Z_OK);
+        if (ret != Z_STREAM_END || strm.total_out != QUICK_LEN) {
+            fprintf(stderr, "zbench: inflate failed\n");
+            exit(1);
+        }
+    }
+    start = (now() - start) / INFLATE_REPS;
+    inflateEnd(&strm);
+    if (memcmp(out, orig, QUICK_LEN)) {
+        fprintf(stderr, "zbench: inflate output is wrong\n");
+        exit(1);
+    }
+    return start;
+}
+
+local void bench_inflate OF((void));
+local void bench_inflate()
+{
+    static const int levels[] = {1, 6, 9};
+    unsigned char *in, *out, *back;
+    unsigned size = (unsigned)compressBound(QUICK_LEN);
+    uLong got;
+    double all, part;
+    int k;
+
+    in = malloc(QUICK_LEN);
+    out = malloc(size);
+    back = malloc(QUICK_LEN);
+    if (in == NULL || out == NULL || back == NULL) {
+        fprintf(stderr, "zbench: out of memory\n");
+        exit(1);
+    }
+    fill_words(in, QUICK_LEN);
+
+    printf("inflate: %u bytes of text, time per decompression from level, "
+           "all at once and %uK at a time\n", QUICK_LEN, INFLATE_PIECE >> 10);
+    for (k = 0; k < 3; k++) {
+        time_deflate(levels[k], Z_DEFAULT_STRATEGY, in, QUICK_LEN, out, size,
+                     &got);
+        all = time_inflate(out, (unsigned)got, in, back, 0);
+        part = time_inflate(out, (unsigned)got, in, back, INFLATE_PIECE);
+        printf("  level %d  %12.1f ns %7.1f MB/s  %12.1f ns %7.1f MB/s\n",
+               levels[k], all, QUICK_LEN * 1e3 / all, part,
+               QUICK_LEN * 1e3 / part);
+    }
+    free(back);
+    free(out);
+    free(in);
+}
+
+/* -- syncsearch -- */
+
+#define SYNC_LEN 67108864U      /* bytes of random data to search */
+#define SYNC_GAP 1048573U       /* bytes between markers */
+#define SYNC_REPS 4
+
+/* The byte-at-a-time search for the 0, 0, 0xff, 0xff marker that inflateSync()
+   does without SIMD, as the reference for its speed and results. */
+local unsigned sync_c OF((unsigned *have, const unsigned char *buf,
+                          unsigned len));
+local unsigned sync_c(have, buf, len)
+    unsigned *have;
+    const unsigned char *buf;
+    unsigned len;
+{
+    unsigned got = *have, next = 0;
+
+    while (next < len && got < 4) {
+        if ((int)(buf[next]) == (got < 2 ? 0 : 0xff))
+            got++;
+        else if (buf[next])
+            got = 0;
+        else
+            got = 4 - got;
+        next++;
+    }
+    *have = got;
+    return next;
+}
+
+/* Return the average time in nanoseconds to find all of the markers in
+   buf[0..len-1], with inflateSync() if lib is true or else with sync_c(), and
+   set *sum to a hash of the offsets just past the markers found. */
+local double time_sync OF((int lib, const unsigned char *buf, unsigned len,
+                           unsigned long *sum));
+local double time_sync(lib, buf, len, sum)
+    int lib;
+    const unsigned char *buf;
+    unsigned len;
+    unsigned long *sum;
+{
+    int i;
+    unsigned have, next;
+    unsigned long val = 0;
+    z_stream strm;
+    double start;
+
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    if (inflateInit2(&strm, -15) != Z_OK) {
+        fprintf(stderr, "zbench: inflateInit2() failed\n");
+        exit(1);
+    }
+    start = now();
+    for (i = 0; i < SYNC_REPS; i++) {
+        if (lib) {
+            inflateReset(&strm);
+            strm.next_in = (z_const Bytef *)buf;
+            strm.avail_in = len;
+            while (inflateSync(&strm) == Z_OK)
+                val = val * 31 + (len - strm.avail_in);
+        }
+        else {
+            have = 0;
+            next = 0;
+            while (next < len) {
+                next += sync_c(&have, buf + next, len - next);
+                if (have == 4) {
+                    val = val * 31 + next;
+                    have = 0;
+                }
+            }
+        }
+    }
+    start = (now() - start) / SYNC_REPS;
+    inflateEnd(&strm);
+    *sum = val;
+    return start;
+}
+
+local void bench_sync OF((void));
+local void bench_sync()
+{
+    unsigned char *buf;
+    unsigned pos;
+    unsigned long ref, got;
+    double base;
+
+    buf = malloc(SYNC_LEN);
+    if (buf == NULL) {
+        fprintf(stderr, "zbench: out of memory\n");
+        exit(1);
+    }
+    fill_random(buf, SYNC_LEN);
+    for (pos = SYNC_GAP; pos + 4 <= SYNC_LEN; pos += SYNC_GAP)
+        memcpy(buf + pos, "\0\0\377\377", 4);
+
+    printf("syncsearch: %u bytes with a marker every %u, time per pass\n",
+           SYNC_LEN, SYNC_GAP);
+    base = time_sync(0, buf, SYNC_LEN, &ref);
+    report("c", base, 0);
+    report("inflate", time_sync(1, buf, SYNC_LEN, &got), base);
+    if (got != ref) {
+        fprintf(stderr, "zbench: inflateSync() result differs from C\n");
+        exit(1);
+    }
+    free(buf);
+}
+
+/* -- driver -- */
+
+local const struct {
+    const char *name;
+    void (*run) OF((void));
+} bench[] = {
+    {"slide", bench_slide},
+    {"crc32", bench_crc32},
+    {"crc32c", bench_crc32c},
+    {"adler32", bench_adler32},
+    {"quick", bench_quick},
+    {"levels", bench_levels},
+    {"block", bench_block},
+    {"inflate", bench_inflate},
+    {"sync", bench_sync},
+    {NULL, NULL}
+};
+
+int main OF((int argc, char *argv[]));
+int main(argc, argv)
+    int argc;
+    char *argv[];
+{
+    int i, k, found;
+
+    for (k = 0; argc < 2 && bench[k].name != NULL; k++)
+        bench[k].run();
+    for (i = 1; i < argc; i++) {
+        found = 0;
+        for (k = 0; bench[k].name != NULL; k++)
+            if (strcmp(argv[i], bench[k].name) == 0) {
+                bench[k].run();
+                found = 1;
+            }
+        if (!found) {
+            fprintf(stderr, "zbench: unknown benchmark %s -- choose from:",
+                    argv[i]);
+            for (k = 0; bench[k].name != NULL; k++)
+                fprintf(stderr, " %s", bench[k].name);
+            fputc('\n', stderr);
+            return 1;
+        }
+    }
+    return 0;
+}
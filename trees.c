@@ -110,6 +110,20 @@ local int base_length[LENGTH_CODES];
 local int base_dist[D_CODES];
 /* First normalized distance for each code (0 = distance of 1) */
 
+ulg _quick_lit[LITERALS];
+/* Static code for each literal, shifted up four bits, over its length */
+
+ulg _quick_len[MAX_MATCH-MIN_MATCH+1];
+/* Static length code and extra bits for each normalized match length,
+ * shifted up four bits, over their total length
+ */
+
+ulg _quick_dist[DIST_CODE_LEN];
+/* For each index into _dist_code, the static distance code in the low five
+ * bits, the number of extra bits in the next four, and the base distance
+ * of the code above that
+ */
+
 #else
 #  include "trees.h"
 #endif /* GEN_TREES_H */
@@ -147,11 +161,20 @@ local int  build_bl_tree  OF((deflate_state *s));
 local void send_all_trees OF((deflate_state *s, int lcodes, int dcodes,
                               int blcodes));
 local void compress_block OF((deflate_state *s, const ct_data *ltree,
-                              const ct_data *dtree));
+                              const ct_data *dtree, unsigned sx,
+                              unsigned end));
+local void send_block     OF((deflate_state *s, charf *buf, ulg stored_len,
+                              int last, unsigned sx, unsigned end));
+local unsigned lg16       OF((unsigned n));
+local ulg  split_cost     OF((const ush *lo, const ush *hi, const ush *code,
+                              int lits, int codes, int trees));
+local int  split_block    OF((deflate_state *s, unsigned *cut, ulg *at));
+local void count_syms     OF((deflate_state *s, unsigned sx, unsigned end));
 local int  detect_data_type OF((deflate_state *s));
 local unsigned bi_reverse OF((unsigned code, int len));
 local void bi_windup      OF((deflate_state *s));
 local void bi_flush       OF((deflate_state *s));
+local void put_buf        OF((uchf *put, bi_t bits));
 
 #ifdef GEN_TREES_H
 local void gen_trees_header OF((void));
@@ -176,6 +199,26 @@ local void gen_trees_header OF((void));
     put_byte(s, (uch)((ush)(w) >> 8)); \
 }
 
+/* ===========================================================================
+ * Write the Buf_size bits of bits LSB first at put.
+ * IN assertion: there is enough room in pendingBuf.
+ */
+local void put_buf(put, bits)
+    uchf *put;
+    bi_t bits;
+{
+    put[0] = (uch)bits;
+    put[1] = (uch)(bits >> 8);
+    put[2] = (uch)(bits >> 16);
+    put[3] = (uch)(bits >> 24);
+#if Buf_size == 64
+    put[4] = (uch)(bits >> 32);
+    put[5] = (uch)(bits >> 40);
+    put[6] = (uch)(bits >> 48);
+    put[7] = (uch)(bits >> 56);
+#endif
+}
+
 /* ===========================================================================
  * Send a value on a given number of bits.
  * IN assertion: length <= 16 and value fits in length bits.
@@ -192,17 +235,17 @@ local void send_bits(s, value, length)
     Assert(length > 0 && length <= 15, "invalid length");
     s->bits_sent += (ulg)length;
 
-    /* If not enough room in bi_buf, use (valid) bits from bi_buf and
-     * (16 - bi_valid) bits from value, leaving (width - (16-bi_valid))
-     * unused bits in value.
+    /* If not enough room in bi_buf, fill it with (Buf_size - bi_valid) bits
+     * from value and write it out, leaving the rest of value in bi_buf. So
+     * there are always fewer than Buf_size bits in bi_buf.
      */
-    if (s->bi_valid > (int)Buf_size - length) {
-        s->bi_buf |= (ush)value << s->bi_valid;
-        put_short(s, s->bi_buf);
-        s->bi_buf = (ush)value >> (Buf_size - s->bi_valid);
+    s->bi_buf |= (bi_t)value << s->bi_valid;
+    if (s->bi_valid >= (int)Buf_size - length) {
+        put_buf(s->pending_buf + s->pending, s->bi_buf);
+        s->pending += Buf_size >> 3;
+        s->bi_buf = (bi_t)value >> (Buf_size - s->bi_valid);
         s->bi_valid += length - Buf_size;
     } else {
-        s->bi_buf |= (ush)value << s->bi_valid;
         s->bi_valid += length;
     }
 }
@@ -210,14 +253,14 @@ local void send_bits(s, value, length)
 
 #define send_bits(s, value, length) \
 { int len = length;\
-  if (s->bi_valid > (int)Buf_size - len) {\
-    int val = (int)value;\
-    s->bi_buf |= (ush)val << s->bi_valid;\
-    put_short(s, s->bi_buf);\
-    s->bi_buf = (ush)val >> (Buf_size - s->bi_valid);\
+  bi_t val = (bi_t)(value);\
+  s->bi_buf |= val << s->bi_valid;\
+  if (s->bi_valid >= (int)Buf_size - len) {\
+    put_buf(s->pending_buf + s->pending, s->bi_buf);\
+    s->pending += Buf_size >> 3;\
+    s->bi_buf = val >> (Buf_size - s->bi_valid);\
     s->bi_valid += len - Buf_size;\
   } else {\
-    s->bi_buf |= (ush)(value) << s->bi_valid;\
     s->bi_valid += len;\
   }\
 }
@@ -263,9 +306,11 @@ local void tr_static_init()
     Assert (length == 256, "tr_static_init: length != 256");
     /* Note that the length 255 (match length 258) can be represented
      * in two different ways: code 284 + 5 bits or code 285, so we
-     * overwrite length_code[255] to use the best encoding:
+     * overwrite length_code[255] to use the best encoding, whose base is
+     * then 255 so that it has no extra bits to send, like the others:
      */
     _length_code[length-1] = (uch)code;
+    base_length[code] = length-1;
 
     /* Initialize the mapping dist (0..32K) -> dist code (0..29) */
     dist = 0;
@@ -303,6 +348,22 @@ local void tr_static_init()
         static_dtree[n].Len = 5;
         static_dtree[n].Code = bi_reverse((unsigned)n, 5);
     }
+
+    /* Combine the static codes and extra bits for deflate_quick() */
+    for (n = 0; n < LITERALS; n++)
+        _quick_lit[n] = ((ulg)static_ltree[n].Code << 4) | static_ltree[n].Len;
+    for (n = 0; n < MAX_MATCH-MIN_MATCH+1; n++) {
+        code = _length_code[n];
+        bits = static_ltree[code + LITERALS+1].Len;
+        _quick_len[n] = (((ulg)static_ltree[code + LITERALS+1].Code |
+                          ((ulg)(n - base_length[code]) << bits)) << 4) |
+                        (ulg)(bits + extra_lbits[code]);
+    }
+    for (n = 0; n < DIST_CODE_LEN; n++) {
+        code = _dist_code[n];
+        _quick_dist[n] = ((ulg)base_dist[code] << 9) |
+                         ((ulg)extra_dbits[code] << 5) | static_dtree[code].Code;
+    }
     static_init_done = 1;
 
 #  ifdef GEN_TREES_H
@@ -369,6 +430,25 @@ void gen_trees_header()
                 SEPARATOR(i, D_CODES-1, 10));
     }
 
+    fprintf(header, "const ulg ZLIB_INTERNAL _quick_lit[LITERALS] = {\n");
+    for (i = 0; i < LITERALS; i++) {
+        fprintf(header, "%4lu%s", _quick_lit[i],
+                SEPARATOR(i, LITERALS-1, 12));
+    }
+
+    fprintf(header,
+        "const ulg ZLIB_INTERNAL _quick_len[MAX_MATCH-MIN_MATCH+1] = {\n");
+    for (i = 0; i < MAX_MATCH-MIN_MATCH+1; i++) {
+        fprintf(header, "%6lu%s", _quick_len[i],
+                SEPARATOR(i, MAX_MATCH-MIN_MATCH, 10));
+    }
+
+    fprintf(header, "const ulg ZLIB_INTERNAL _quick_dist[DIST_CODE_LEN] = {\n");
+    for (i = 0; i < DIST_CODE_LEN; i++) {
+        fprintf(header, "%8lu%s", _quick_dist[i],
+                SEPARATOR(i, DIST_CODE_LEN-1, 8));
+    }
+
     fclose(header);
 }
 #endif /* GEN_TREES_H */
@@ -905,15 +985,363 @@ void ZLIB_INTERNAL _tr_align(s)
     bi_flush(s);
 }
 
+/* ===========================================================================
+ * Start a block coded with the static trees for deflate_quick(). The block
+ * can span any number of calls of deflate(), in which deflate_quick() sends
+ * the symbols itself, until it is ended with _tr_quick_end().
+ */
+void ZLIB_INTERNAL _tr_quick_start(s, last)
+    deflate_state *s;
+    int last;         /* one if this is the last block for a file */
+{
+    send_bits(s, (STATIC_TREES<<1)+last, 3);
+}
+
+/* ===========================================================================
+ * End the block started by _tr_quick_start(). If it is the last block, align
+ * the output on a byte boundary.
+ */
+void ZLIB_INTERNAL _tr_quick_end(s, last)
+    deflate_state *s;
+    int last;         /* one if this is the last block for a file */
+{
+    send_code(s, END_BLOCK, static_ltree);
+    if (last)
+        bi_windup(s);
+#ifdef ZLIB_DEBUG
+    s->compressed_len = s->bits_sent;   /* length was not tallied in advance */
+#endif
+}
+
+/* ===========================================================================
+ * Set the cost in bits of each literal/length and distance code, including
+ * the extra bits, for a block with the symbol counts in ltree[] and dtree[].
+ * The codes are the ones that _tr_flush_block() would build for those counts,
+ * or the static codes for Z_FIXED. A code with no count is given one bit more
+ * than the longest code. The counts are overwritten, but the block in
+ * progress is not disturbed. This is the cost model for deflate_optimal().
+ */
+void ZLIB_INTERNAL _tr_costs(s, ltree, dtree, lcost, dcost)
+    deflate_state *s;
+    ct_data *ltree;   /* HEAP_SIZE counts of literal/length codes */
+    ct_data *dtree;   /* 2*D_CODES+1 counts of distance codes */
+    uchf *lcost;      /* L_CODES costs of literal/length codes */
+    uchf *dcost;      /* D_CODES costs of distance codes */
+{
+    tree_desc desc;
+    const ct_data *lt = ltree, *dt = dtree;
+    ulg opt_len = s->opt_len, static_len = s->static_len;
+    int n, lmax = 0, dmax = 0;
+
+    if (s->strategy == Z_FIXED) {
+        lt = static_ltree;
+        dt = static_dtree;
+    }
+    else {
+        desc.dyn_tree = ltree;
+        desc.stat_desc = &static_l_desc;
+        build_tree(s, &desc);
+        desc.dyn_tree = dtree;
+        desc.stat_desc = &static_d_desc;
+        build_tree(s, &desc);
+        s->opt_len = opt_len;
+        s->static_len = static_len;
+    }
+    for (n = 0; n < L_CODES; n++)
+        if (lt[n].Len > lmax)
+            lmax = lt[n].Len;
+    for (n = 0; n < D_CODES; n++)
+        if (dt[n].Len > dmax)
+            dmax = dt[n].Len;
+    for (n = 0; n < L_CODES; n++)
+        lcost[n] = (uch)((lt[n].Len ? lt[n].Len : lmax + 1) +
+                         (n > LITERALS ? extra_lbits[n - LITERALS - 1] : 0));
+    for (n = 0; n < D_CODES; n++)
+        dcost[n] = (uch)((dt[n].Len ? dt[n].Len : dmax + 1) +
+                         extra_dbits[n]);
+}
+
+/* ===========================================================================
+ * Count the symbols sym_buf[sx..end-1] in the trees, as _tr_tally() would
+ * have for a block holding only those symbols.
+ */
+local void count_syms(s, sx, end)
+    deflate_state *s;
+    unsigned sx;      /* first symbol in sym_buf */
+    unsigned end;     /* end of the symbols in sym_buf */
+{
+    unsigned dist, lc;
+    int n;
+
+    for (n = 0; n < L_CODES;  n++) s->dyn_ltree[n].Freq = 0;
+    for (n = 0; n < D_CODES;  n++) s->dyn_dtree[n].Freq = 0;
+    for (n = 0; n < BL_CODES; n++) s->bl_tree[n].Freq = 0;
+    s->dyn_ltree[END_BLOCK].Freq = 1;
+    s->opt_len = s->static_len = 0L;
+
+    while (sx < end) {
+        dist = s->sym_buf[sx++] & 0xff;
+        dist += (unsigned)(s->sym_buf[sx++] & 0xff) << 8;
+        lc = s->sym_buf[sx++];
+        if (dist == 0)
+            s->dyn_ltree[lc].Freq++;
+        else {
+            s->dyn_ltree[_length_code[lc]+LITERALS+1].Freq++;
+            s->dyn_dtree[d_code(dist - 1)].Freq++;
+        }
+    }
+}
+
+/* ===========================================================================
+ * Return 16 times the base two logarithm of n, to within one, or zero for
+ * n == 0. n must be less than 2^17.
+ */
+local unsigned lg16(n)
+    unsigned n;
+{
+    static const uch lg[32] = {
+        0, 0, 16, 25, 32, 37, 41, 45, 48, 51, 53, 55, 57, 59, 61, 63,
+        64, 65, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79, 79};
+    unsigned r = 0;
+
+    if (n >= 1 << 12) {
+        n >>= 8;
+        r += 128;
+    }
+    if (n >= 1 << 8) {
+        n >>= 4;
+        r += 64;
+    }
+    if (n >= 1 << 6) {
+        n >>= 2;
+        r += 32;
+    }
+    if (n >= 1 << 5) {
+        n >>= 1;
+        r += 16;
+    }
+    return r + lg[n];
+}
+
+/* ===========================================================================
+ * Estimate in 1/16 bits the length of a block with the symbol counts hi[]
+ * less lo[]: the entropy of the literal/length and of the distance codes,
+ * plus a rough size for the tree descriptions. The extra bits are left out,
+ * since they are the same however a block is split. The trees are left out
+ * too if trees is zero. Only the codes listed in code[] can have counts, the
+ * first lits of which are literal/length codes.
+ */
+local ulg split_cost(lo, hi, code, lits, codes, trees)
+    const ush *lo;      /* counts at the start of the block */
+    const ush *hi;      /* counts at the end of the block */
+    const ush *code;    /* codes used anywhere in the whole block */
+    int lits;           /* number of literal/length codes in code[] */
+    int codes;          /* number of codes in code[] */
+    int trees;          /* true to include the size of the trees */
+{
+    ulg cost = 0, sum;
+    unsigned f, used = 0;
+    int n;
+
+    sum = 1;                            /* for END_BLOCK */
+    for (n = 0; n < lits; n++)
+        if ((f = hi[code[n]] - lo[code[n]]) != 0) {
+            sum += f;
+            cost -= (ulg)f * lg16(f);
+            used++;
+        }
+    cost += sum * lg16((unsigned)sum);
+    sum = 0;
+    for (; n < codes; n++)
+        if ((f = hi[code[n]] - lo[code[n]]) != 0) {
+            sum += f;
+            cost -= (ulg)f * lg16(f);
+            used++;
+        }
+    cost += sum * lg16((unsigned)sum);
+    return trees ? cost + 16 * (SPLIT_TREES + 4 * (ulg)used) : cost;
+}
+
+/* ===========================================================================
+ * See if the symbols in sym_buf would be sent in fewer bits as up to
+ * s->split blocks, each with its own trees. The symbols are cut into
+ * SPLIT_SEGS segments, the length of every run of segments as a block is
+ * estimated with split_cost(), and the cheapest way to cover them all with
+ * at most s->split runs is found by dynamic programming. Return the number
+ * of blocks, with the start of each in sym_buf in cut[] and in the input in
+ * at[], and the ends of the last in cut[n] and at[n]. One is returned if
+ * splitting does not save enough to be worth it. seg_cost() estimates
+ * segments i..j-1 as a block.
+ */
+#define seg_cost(i, j, trees) \
+    split_cost(freq + (ulg)(i) * (L_CODES + D_CODES), \
+               freq + (ulg)(j) * (L_CODES + D_CODES), code, lits, codes, trees)
+
+local int split_block(s, cut, at)
+    deflate_state *s;
+    unsigned *cut;    /* SPLIT_SEGS+1 offsets in sym_buf */
+    ulg *at;          /* SPLIT_SEGS+1 offsets in the input */
+{
+    ushf *freq = s->split_freq;
+    ush code[L_CODES+D_CODES];          /* codes used in the block */
+    unsigned seg[SPLIT_SEGS+1];         /* segment boundaries in sym_buf */
+    ulg in[SPLIT_SEGS+1];               /* segment boundaries in the input */
+    ulg run[SPLIT_SEGS+1][SPLIT_SEGS+1];  /* run[i][j]: segs i..j-1 */
+    ulg best[SPLIT_SEGS+1][SPLIT_SEGS+1]; /* best[p][j]: p blocks to seg j */
+    uch from[SPLIT_SEGS+1][SPLIT_SEGS+1]; /* where the last of those starts */
+    ulg cost, whole;
+    unsigned nsym = s->sym_next / 3, sx = 0, dist, lc;
+    int i, j, k, p, parts, most = s->split, lits, codes;
+
+    /* Fill freq[] with the running counts at each segment boundary */
+    zmemzero((Bytef *)freq, (L_CODES + D_CODES) * sizeof(ush));
+    seg[0] = 0;
+    in[0] = 0;
+    for (k = 1; k <= SPLIT_SEGS; k++) {
+        ushf *row = freq + (ulg)k * (L_CODES + D_CODES);
+
+        zmemcpy((Bytef *)row, (Bytef *)(row - (L_CODES + D_CODES)),
+                (L_CODES + D_CODES) * sizeof(ush));
+        in[k] = in[k - 1];
+        seg[k] = 3 * (unsigned)((ulg)nsym * k / SPLIT_SEGS);
+        while (sx < seg[k]) {
+            dist = s->sym_buf[sx++] & 0xff;
+            dist += (unsigned)(s->sym_buf[sx++] & 0xff) << 8;
+            lc = s->sym_buf[sx++];
+            if (dist == 0) {
+                row[lc]++;
+                in[k]++;
+            }
+            else {
+                row[_length_code[lc]+LITERALS+1]++;
+                row[L_CODES + d_code(dist - 1)]++;
+                in[k] += lc + MIN_MATCH;
+            }
+        }
+    }
+
+    /* Estimate every run of segments as a block */
+    freq += (ulg)SPLIT_SEGS * (L_CODES + D_CODES);
+    codes = 0;
+    for (k = 0; k < L_CODES; k++)
+        if (freq[k])
+            code[codes++] = (ush)k;
+    lits = codes;
+    for (; k < L_CODES + D_CODES; k++)
+        if (freq[k])
+            code[codes++] = (ush)k;
+    freq = s->split_freq;
+
+    /* Mixing symbols never lowers the entropy, so the segments sent alone
+     * with the smallest possible trees cost less than any split would. If
+     * that is not enough less than the whole, don't bother looking further.
+     */
+    whole = seg_cost(0, SPLIT_SEGS, 1);
+    cost = 2 * 16 * SPLIT_TREES;
+    for (k = 0; k < SPLIT_SEGS; k++)
+        cost += seg_cost(k, k + 1, 0);
+    if (whole < cost || whole - cost < (whole >> SPLIT_GAIN))
+        return 1;
+
+    for (i = 0; i < SPLIT_SEGS; i++)
+        for (j = i + 1; j <= SPLIT_SEGS; j++)
+            run[i][j] = seg_cost(i, j, 1);
+
+    /* Find the cheapest way to cover the segments with p runs, p <= most */
+    for (j = 0; j <= SPLIT_SEGS; j++)
+        best[1][j] = j ? run[0][j] : (ulg)-1;
+    for (p = 2; p <= most; p++) {
+        for (j = 0; j <= SPLIT_SEGS; j++) {
+            best[p][j] = (ulg)-1;
+            for (i = p - 1; i < j; i++) {
+                cost = best[p - 1][i] + run[i][j];
+                if (cost < best[p][j]) {
+                    best[p][j] = cost;
+                    from[p][j] = (uch)i;
+                }
+            }
+        }
+    }
+    parts = 1;
+    for (p = 2; p <= most; p++)
+        if (best[p][SPLIT_SEGS] < best[parts][SPLIT_SEGS])
+            parts = p;
+    if (parts == 1 ||
+        whole - best[parts][SPLIT_SEGS] < (whole >> SPLIT_GAIN))
+        return 1;
+
+    /* Follow the choices back to get the block boundaries */
+    j = SPLIT_SEGS;
+    for (p = parts; p > 0; p--) {
+        cut[p] = seg[j];
+        at[p] = in[j];
+        j = from[p][j];
+    }
+    cut[0] = 0;
+    at[0] = 0;
+    Tracev((stderr, "\nsplit %d: %lu -> %lu bytes", parts,
+            whole >> 7, best[parts][SPLIT_SEGS] >> 7));
+    return parts;
+}
+
 /* ===========================================================================
  * Determine the best encoding for the current block: dynamic trees, static
- * trees or store, and write out the encoded block.
+ * trees or store, and write out the encoded block. If deflateSplit() asked
+ * for it, first see if the block would be smaller as several blocks with
+ * their own trees, and if so send it that way.
  */
 void ZLIB_INTERNAL _tr_flush_block(s, buf, stored_len, last)
     deflate_state *s;
     charf *buf;       /* input block, or NULL if too old */
     ulg stored_len;   /* length of input block */
     int last;         /* one if this is the last block for a file */
+{
+    unsigned cut[SPLIT_SEGS+1];     /* where each part starts in sym_buf */
+    ulg at[SPLIT_SEGS+1];           /* and where it starts in buf */
+    int parts = 1, n;
+
+    /* Check if the file is binary or text */
+    if (s->level > 0 && s->strm->data_type == Z_UNKNOWN)
+        s->strm->data_type = detect_data_type(s);
+
+    if (s->level > 0 && s->split > 1 && s->strategy != Z_FIXED &&
+        s->sym_next >= 3 * SPLIT_MIN)
+        parts = split_block(s, cut, at);
+    if (parts == 1)
+        send_block(s, buf, stored_len, last, 0, s->sym_next);
+    else {
+        Assert(at[parts] == stored_len, "split lost input");
+        for (n = 0; n < parts; n++) {
+            count_syms(s, cut[n], cut[n + 1]);
+            send_block(s, buf == (charf *)0 ? buf : buf + at[n],
+                       at[n + 1] - at[n], last && n == parts - 1,
+                       cut[n], cut[n + 1]);
+        }
+    }
+    init_block(s);
+
+    if (last) {
+        bi_windup(s);
+#ifdef ZLIB_DEBUG
+        s->compressed_len += 7;  /* align on byte boundary */
+#endif
+    }
+    Tracev((stderr,"\ncomprlen %lu(%lu) ", s->compressed_len>>3,
+           s->compressed_len-7*last));
+}
+
+/* ===========================================================================
+ * Determine the best encoding for the symbols sym_buf[sx..end-1], whose
+ * counts are in the trees: dynamic trees, static trees or store, and write
+ * out the encoded block.
+ */
+local void send_block(s, buf, stored_len, last, sx, end)
+    deflate_state *s;
+    charf *buf;       /* input block, or NULL if too old */
+    ulg stored_len;   /* length of input block */
+    int last;         /* one if this is the last block for a file */
+    unsigned sx;      /* first symbol in sym_buf */
+    unsigned end;     /* end of the symbols in sym_buf */
 {
     ulg opt_lenb, static_lenb; /* opt_len and static_len in bytes */
     int max_blindex = 0;  /* index of last bit length code of non zero freq */
@@ -921,10 +1349,6 @@ void ZLIB_INTERNAL _tr_flush_block(s, buf, stored_len, last)
     /* Build the Huffman trees unless a stored block is forced */
     if (s->level > 0) {
 
-        /* Check if the file is binary or text */
-        if (s->strm->data_type == Z_UNKNOWN)
-            s->strm->data_type = detect_data_type(s);
-
         /* Construct the literal and distance trees */
         build_tree(s, (tree_desc *)(&(s->l_desc)));
         Tracev((stderr, "\nlit data: dyn %ld, stat %ld", s->opt_len,
@@ -948,7 +1372,7 @@ void ZLIB_INTERNAL _tr_flush_block(s, buf, stored_len, last)
 
         Tracev((stderr, "\nopt %lu(%lu) stat %lu(%lu) stored %lu lit %u ",
                 opt_lenb, s->opt_len, static_lenb, s->static_len, stored_len,
-                s->sym_next / 3));
+                (end - sx) / 3));
 
         if (static_lenb <= opt_lenb) opt_lenb = static_lenb;
 
@@ -978,7 +1402,8 @@ void ZLIB_INTERNAL _tr_flush_block(s, buf, stored_len, last)
 #endif
         send_bits(s, (STATIC_TREES<<1)+last, 3);
         compress_block(s, (const ct_data *)static_ltree,
-                       (const ct_data *)static_dtree);
+                       (const ct_data *)static_dtree, sx, end);
+        send_code(s, END_BLOCK, static_ltree);
 #ifdef ZLIB_DEBUG
         s->compressed_len += 3 + s->static_len;
 #endif
@@ -987,7 +1412,8 @@ void ZLIB_INTERNAL _tr_flush_block(s, buf, stored_len, last)
         send_all_trees(s, s->l_desc.max_code+1, s->d_desc.max_code+1,
                        max_blindex+1);
         compress_block(s, (const ct_data *)s->dyn_ltree,
-                       (const ct_data *)s->dyn_dtree);
+                       (const ct_data *)s->dyn_dtree, sx, end);
+        send_code(s, END_BLOCK, s->dyn_ltree);
 #ifdef ZLIB_DEBUG
         s->compressed_len += 3 + s->opt_len;
 #endif
@@ -996,16 +1422,6 @@ void ZLIB_INTERNAL _tr_flush_block(s, buf, stored_len, last)
     /* The above check is made mod 2^32, for files larger than 512 MB
      * and uLong implemented on 32 bits.
      */
-    init_block(s);
-
-    if (last) {
-        bi_windup(s);
-#ifdef ZLIB_DEBUG
-        s->compressed_len += 7;  /* align on byte boundary */
-#endif
-    }
-    Tracev((stderr,"\ncomprlen %lu(%lu) ", s->compressed_len>>3,
-           s->compressed_len-7*last));
 }
 
 /* ===========================================================================
@@ -1038,53 +1454,77 @@ int ZLIB_INTERNAL _tr_tally (s, dist, lc)
 }
 
 /* ===========================================================================
- * Send the block data compressed using the given Huffman trees
+ * Send the symbols sym_buf[sx..end-1] compressed using the given Huffman
+ * trees. The caller sends the end of block code.
+ *
+ * The bit buffer is kept in local variables that the compiler can hold in
+ * registers, and is written out Buf_size bits at a time. A literal or length
+ * code is sent together with its extra bits, as is a distance code, which
+ * is at most 28 bits and so always fits.
  */
-local void compress_block(s, ltree, dtree)
+#define send_local(value, length) \
+    { int len = length; \
+      bi_t val = (bi_t)(value); \
+      bits |= val << n; \
+      if (n >= (int)Buf_size - len) { \
+          put_buf(put, bits); \
+          put += Buf_size >> 3; \
+          bits = val >> (Buf_size - n); \
+          n += len - Buf_size; \
+      } \
+      else \
+          n += len; \
+    }
+
+local void compress_block(s, ltree, dtree, sx, end)
     deflate_state *s;
     const ct_data *ltree; /* literal tree */
     const ct_data *dtree; /* distance tree */
+    unsigned sx;        /* running index in sym_buf */
+    unsigned end;       /* end of the symbols to send */
 {
     unsigned dist;      /* distance of matched string */
-    int lc;             /* match length or unmatched char (if dist == 0) */
-    unsigned sx = 0;    /* running index in sym_buf */
+    unsigned lc;        /* match length or unmatched char (if dist == 0) */
     unsigned code;      /* the code to send */
-    int extra;          /* number of extra bits to send */
+    bi_t bits = s->bi_buf;      /* local bit buffer */
+    int n = s->bi_valid;        /* number of bits in bits */
+    uchf *put = s->pending_buf + s->pending;    /* where to write bits */
 
-    if (s->sym_next != 0) do {
+    if (sx < end) do {
         dist = s->sym_buf[sx++] & 0xff;
         dist += (unsigned)(s->sym_buf[sx++] & 0xff) << 8;
         lc = s->sym_buf[sx++];
         if (dist == 0) {
-            send_code(s, lc, ltree); /* send a literal byte */
+            send_local(ltree[lc].Code, ltree[lc].Len); /* send a literal */
             Tracecv(isgraph(lc), (stderr," '%c' ", lc));
         } else {
-            /* Here, lc is the match length - MIN_MATCH */
+            /* Here, lc is the match length - MIN_MATCH. The extra bits are
+             * zero when there are none, for lengths and for distances.
+             */
             code = _length_code[lc];
-            send_code(s, code+LITERALS+1, ltree); /* send the length code */
-            extra = extra_lbits[code];
-            if (extra != 0) {
-                lc -= base_length[code];
-                send_bits(s, lc, extra);       /* send the extra length bits */
-            }
+            send_local(ltree[code+LITERALS+1].Code |
+                       (lc - base_length[code]) << ltree[code+LITERALS+1].Len,
+                       ltree[code+LITERALS+1].Len + extra_lbits[code]);
             dist--; /* dist is now the match distance - 1 */
             code = d_code(dist);
             Assert (code < D_CODES, "bad d_code");
 
-            send_code(s, code, dtree);       /* send the distance code */
-            extra = extra_dbits[code];
-            if (extra != 0) {
-                dist -= (unsigned)base_dist[code];
-                send_bits(s, dist, extra);   /* send the extra distance bits */
-            }
+            send_local(dtree[code].Code |
+                       (dist - (unsigned)base_dist[code]) << dtree[code].Len,
+                       dtree[code].Len + extra_dbits[code]);
         } /* literal or match pair ? */
 
         /* Check that the overlay between pending_buf and sym_buf is ok: */
-        Assert(s->pending < s->lit_bufsize + sx, "pendingBuf overflow");
-
-    } while (sx < s->sym_next);
+        Assert(put < s->sym_buf + sx, "pendingBuf overflow");
 
-    send_code(s, END_BLOCK, ltree);
+    } while (sx < end);
+#ifdef ZLIB_DEBUG
+    s->bits_sent += ((ulg)(put - s->pending_buf - s->pending) << 3) + n -
+                    s->bi_valid;
+#endif
+    s->pending = (ulg)(put - s->pending_buf);
+    s->bi_buf = bits;
+    s->bi_valid = n;
 }
 
 /* ===========================================================================
@@ -1152,11 +1592,7 @@ local unsigned bi_reverse(code, len)
 local void bi_flush(s)
     deflate_state *s;
 {
-    if (s->bi_valid == 16) {
-        put_short(s, s->bi_buf);
-        s->bi_buf = 0;
-        s->bi_valid = 0;
-    } else if (s->bi_valid >= 8) {
+    while (s->bi_valid >= 8) {
         put_byte(s, (Byte)s->bi_buf);
         s->bi_buf >>= 8;
         s->bi_valid -= 8;
@@ -1169,10 +1605,10 @@ local void bi_flush(s)
 local void bi_windup(s)
     deflate_state *s;
 {
-    if (s->bi_valid > 8) {
-        put_short(s, s->bi_buf);
-    } else if (s->bi_valid > 0) {
+    while (s->bi_valid > 0) {
         put_byte(s, (Byte)s->bi_buf);
+        s->bi_buf >>= 8;
+        s->bi_valid -= 8;
     }
     s->bi_buf = 0;
     s->bi_valid = 0;
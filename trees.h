@@ -117,7 +117,7 @@ const uch ZLIB_INTERNAL _length_code[MAX_MATCH-MIN_MATCH+1]= {
 
 local const int base_length[LENGTH_CODES] = {
 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 14, 16, 20, 24, 28, 32, 40, 48, 56,
-64, 80, 96, 112, 128, 160, 192, 224, 0
+64, 80, 96, 112, 128, 160, 192, 224, 255
 };
 
 local const int base_dist[D_CODES] = {
@@ -126,3 +126,124 @@ local const int base_dist[D_CODES] = {
  1024,  1536,  2048,  3072,  4096,  6144,  8192, 12288, 16384, 24576
 };
 
+const ulg ZLIB_INTERNAL _quick_lit[LITERALS] = {
+ 200, 2248, 1224, 3272,  712, 2760, 1736, 3784,  456, 2504, 1480, 3528,
+ 968, 3016, 1992, 4040,   40, 2088, 1064, 3112,  552, 2600, 1576, 3624,
+ 296, 2344, 1320, 3368,  808, 2856, 1832, 3880,  168, 2216, 1192, 3240,
+ 680, 2728, 1704, 3752,  424, 2472, 1448, 3496,  936, 2984, 1960, 4008,
+ 104, 2152, 1128, 3176,  616, 2664, 1640, 3688,  360, 2408, 1384, 3432,
+ 872, 2920, 1896, 3944,  232, 2280, 1256, 3304,  744, 2792, 1768, 3816,
+ 488, 2536, 1512, 3560, 1000, 3048, 2024, 4072,   24, 2072, 1048, 3096,
+ 536, 2584, 1560, 3608,  280, 2328, 1304, 3352,  792, 2840, 1816, 3864,
+ 152, 2200, 1176, 3224,  664, 2712, 1688, 3736,  408, 2456, 1432, 3480,
+ 920, 2968, 1944, 3992,   88, 2136, 1112, 3160,  600, 2648, 1624, 3672,
+ 344, 2392, 1368, 3416,  856, 2904, 1880, 3928,  216, 2264, 1240, 3288,
+ 728, 2776, 1752, 3800,  472, 2520, 1496, 3544,  984, 3032, 2008, 4056,
+ 313, 4409, 2361, 6457, 1337, 5433, 3385, 7481,  825, 4921, 2873, 6969,
+1849, 5945, 3897, 7993,  185, 4281, 2233, 6329, 1209, 5305, 3257, 7353,
+ 697, 4793, 2745, 6841, 1721, 5817, 3769, 7865,  441, 4537, 2489, 6585,
+1465, 5561, 3513, 7609,  953, 5049, 3001, 7097, 1977, 6073, 4025, 8121,
+ 121, 4217, 2169, 6265, 1145, 5241, 3193, 7289,  633, 4729, 2681, 6777,
+1657, 5753, 3705, 7801,  377, 4473, 2425, 6521, 1401, 5497, 3449, 7545,
+ 889, 4985, 2937, 7033, 1913, 6009, 3961, 8057,  249, 4345, 2297, 6393,
+1273, 5369, 3321, 7417,  761, 4857, 2809, 6905, 1785, 5881, 3833, 7929,
+ 505, 4601, 2553, 6649, 1529, 5625, 3577, 7673, 1017, 5113, 3065, 7161,
+2041, 6137, 4089, 8185
+};
+
+const ulg ZLIB_INTERNAL _quick_len[MAX_MATCH-MIN_MATCH+1] = {
+  1031,    519,   1543,    263,   1287,    775,   1799,    135,   1160,   3208,
+   648,   2696,   1672,   3720,    392,   2440,   1417,   3465,   5513,   7561,
+   905,   2953,   5001,   7049,   1929,   3977,   6025,   8073,     73,   2121,
+  4169,   6217,   1098,   3146,   5194,   7242,   9290,  11338,  13386,  15434,
+   586,   2634,   4682,   6730,   8778,  10826,  12874,  14922,   1610,   3658,
+  5706,   7754,   9802,  11850,  13898,  15946,    330,   2378,   4426,   6474,
+  8522,  10570,  12618,  14666,   1355,   3403,   5451,   7499,   9547,  11595,
+ 13643,  15691,  17739,  19787,  21835,  23883,  25931,  27979,  30027,  32075,
+   843,   2891,   4939,   6987,   9035,  11083,  13131,  15179,  17227,  19275,
+ 21323,  23371,  25419,  27467,  29515,  31563,   1867,   3915,   5963,   8011,
+ 10059,  12107,  14155,  16203,  18251,  20299,  22347,  24395,  26443,  28491,
+ 30539,  32587,     60,   4156,   8252,  12348,  16444,  20540,  24636,  28732,
+ 32828,  36924,  41020,  45116,  49212,  53308,  57404,  61500,   2109,   6205,
+ 10301,  14397,  18493,  22589,  26685,  30781,  34877,  38973,  43069,  47165,
+ 51261,  55357,  59453,  63549,  67645,  71741,  75837,  79933,  84029,  88125,
+ 92221,  96317, 100413, 104509, 108605, 112701, 116797, 120893, 124989, 129085,
+  1085,   5181,   9277,  13373,  17469,  21565,  25661,  29757,  33853,  37949,
+ 42045,  46141,  50237,  54333,  58429,  62525,  66621,  70717,  74813,  78909,
+ 83005,  87101,  91197,  95293,  99389, 103485, 107581, 111677, 115773, 119869,
+123965, 128061,   3133,   7229,  11325,  15421,  19517,  23613,  27709,  31805,
+ 35901,  39997,  44093,  48189,  52285,  56381,  60477,  64573,  68669,  72765,
+ 76861,  80957,  85053,  89149,  93245,  97341, 101437, 105533, 109629, 113725,
+117821, 121917, 126013, 130109,    573,   4669,   8765,  12861,  16957,  21053,
+ 25149,  29245,  33341,  37437,  41533,  45629,  49725,  53821,  57917,  62013,
+ 66109,  70205,  74301,  78397,  82493,  86589,  90685,  94781,  98877, 102973,
+107069, 111165, 115261, 119357, 123453,   2616
+};
+
+const ulg ZLIB_INTERNAL _quick_dist[DIST_CODE_LEN] = {
+       0,      528,     1032,     1560,     2084,     2084,     3124,     3124,
+    4172,     4172,     4172,     4172,     6236,     6236,     6236,     6236,
+    8290,     8290,     8290,     8290,     8290,     8290,     8290,     8290,
+   12402,    12402,    12402,    12402,    12402,    12402,    12402,    12402,
+   16522,    16522,    16522,    16522,    16522,    16522,    16522,    16522,
+   16522,    16522,    16522,    16522,    16522,    16522,    16522,    16522,
+   24730,    24730,    24730,    24730,    24730,    24730,    24730,    24730,
+   24730,    24730,    24730,    24730,    24730,    24730,    24730,    24730,
+   32934,    32934,    32934,    32934,    32934,    32934,    32934,    32934,
+   32934,    32934,    32934,    32934,    32934,    32934,    32934,    32934,
+   32934,    32934,    32934,    32934,    32934,    32934,    32934,    32934,
+   32934,    32934,    32934,    32934,    32934,    32934,    32934,    32934,
+   49334,    49334,    49334,    49334,    49334,    49334,    49334,    49334,
+   49334,    49334,    49334,    49334,    49334,    49334,    49334,    49334,
+   49334,    49334,    49334,    49334,    49334,    49334,    49334,    49334,
+   49334,    49334,    49334,    49334,    49334,    49334,    49334,    49334,
+   65742,    65742,    65742,    65742,    65742,    65742,    65742,    65742,
+   65742,    65742,    65742,    65742,    65742,    65742,    65742,    65742,
+   65742,    65742,    65742,    65742,    65742,    65742,    65742,    65742,
+   65742,    65742,    65742,    65742,    65742,    65742,    65742,    65742,
+   65742,    65742,    65742,    65742,    65742,    65742,    65742,    65742,
+   65742,    65742,    65742,    65742,    65742,    65742,    65742,    65742,
+   65742,    65742,    65742,    65742,    65742,    65742,    65742,    65742,
+   65742,    65742,    65742,    65742,    65742,    65742,    65742,    65742,
+   98526,    98526,    98526,    98526,    98526,    98526,    98526,    98526,
+   98526,    98526,    98526,    98526,    98526,    98526,    98526,    98526,
+   98526,    98526,    98526,    98526,    98526,    98526,    98526,    98526,
+   98526,    98526,    98526,    98526,    98526,    98526,    98526,    98526,
+   98526,    98526,    98526,    98526,    98526,    98526,    98526,    98526,
+   98526,    98526,    98526,    98526,    98526,    98526,    98526,    98526,
+   98526,    98526,    98526,    98526,    98526,    98526,    98526,    98526,
+   98526,    98526,    98526,    98526,    98526,    98526,    98526,    98526,
+       0,        0,   131297,   196849,   262409,   262409,   393497,   393497,
+  524581,   524581,   524581,   524581,   786741,   786741,   786741,   786741,
+ 1048909,  1048909,  1048909,  1048909,  1048909,  1048909,  1048909,  1048909,
+ 1573213,  1573213,  1573213,  1573213,  1573213,  1573213,  1573213,  1573213,
+ 2097507,  2097507,  2097507,  2097507,  2097507,  2097507,  2097507,  2097507,
+ 2097507,  2097507,  2097507,  2097507,  2097507,  2097507,  2097507,  2097507,
+ 3146099,  3146099,  3146099,  3146099,  3146099,  3146099,  3146099,  3146099,
+ 3146099,  3146099,  3146099,  3146099,  3146099,  3146099,  3146099,  3146099,
+ 4194699,  4194699,  4194699,  4194699,  4194699,  4194699,  4194699,  4194699,
+ 4194699,  4194699,  4194699,  4194699,  4194699,  4194699,  4194699,  4194699,
+ 4194699,  4194699,  4194699,  4194699,  4194699,  4194699,  4194699,  4194699,
+ 4194699,  4194699,  4194699,  4194699,  4194699,  4194699,  4194699,  4194699,
+ 6291867,  6291867,  6291867,  6291867,  6291867,  6291867,  6291867,  6291867,
+ 6291867,  6291867,  6291867,  6291867,  6291867,  6291867,  6291867,  6291867,
+ 6291867,  6291867,  6291867,  6291867,  6291867,  6291867,  6291867,  6291867,
+ 6291867,  6291867,  6291867,  6291867,  6291867,  6291867,  6291867,  6291867,
+ 8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,
+ 8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,
+ 8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,
+ 8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,
+ 8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,
+ 8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,
+ 8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,
+ 8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,  8389031,
+12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351,
+12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351,
+12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351,
+12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351,
+12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351,
+12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351,
+12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351,
+12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351, 12583351
+};
+
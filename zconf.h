@@ -20,25 +20,52 @@
 /* all linked symbols and init macros */
 #  define _dist_code            z__dist_code
 #  define _length_code          z__length_code
+#  define _quick_dist           z__quick_dist
+#  define _quick_len            z__quick_len
+#  define _quick_lit            z__quick_lit
 #  define _tr_align             z__tr_align
+#  define _tr_costs             z__tr_costs
 #  define _tr_flush_bits        z__tr_flush_bits
 #  define _tr_flush_block       z__tr_flush_block
 #  define _tr_init              z__tr_init
+#  define _tr_quick_end         z__tr_quick_end
+#  define _tr_quick_start       z__tr_quick_start
 #  define _tr_stored_block      z__tr_stored_block
 #  define _tr_tally             z__tr_tally
 #  define adler32               z_adler32
+#  define adler32_avx2          z_adler32_avx2
+#  define adler32_base          z_adler32_base
 #  define adler32_combine       z_adler32_combine
 #  define adler32_combine64     z_adler32_combine64
+#  define adler32_copy          z_adler32_copy
+#  define adler32_neon          z_adler32_neon
+#  define adler32_parallel      z_adler32_parallel
+#  define adler32_ssse3         z_adler32_ssse3
 #  define adler32_z             z_adler32_z
+#  define compare256_avx2       z_compare256_avx2
+#  define compare256_neon       z_compare256_neon
+#  define compare256_sse2       z_compare256_sse2
 #  ifndef Z_SOLO
 #    define compress              z_compress
 #    define compress2             z_compress2
 #    define compressBound         z_compressBound
+#    define compressParallel      z_compressParallel
+#    define compressParallelBound z_compressParallelBound
 #  endif
 #  define crc32                 z_crc32
+#  define crc32_base            z_crc32_base
 #  define crc32_combine         z_crc32_combine
 #  define crc32_combine64       z_crc32_combine64
+#  define crc32_copy            z_crc32_copy
+#  define crc32_parallel        z_crc32_parallel
+#  define crc32_pclmul          z_crc32_pclmul
+#  define crc32_vpclmul         z_crc32_vpclmul
 #  define crc32_z               z_crc32_z
+#  define crc32c_base           z_crc32c_base
+#  define crc32c_combine        z_crc32c_combine
+#  define crc32c_combine64      z_crc32c_combine64
+#  define crc32c_sse42          z_crc32c_sse42
+#  define crc32c_z              z_crc32c_z
 #  define deflate               z_deflate
 #  define deflateBound          z_deflateBound
 #  define deflateCopy           z_deflateCopy
@@ -55,6 +82,7 @@
 #  define deflateResetKeep      z_deflateResetKeep
 #  define deflateSetDictionary  z_deflateSetDictionary
 #  define deflateSetHeader      z_deflateSetHeader
+#  define deflateSplit          z_deflateSplit
 #  define deflateTune           z_deflateTune
 #  define deflate_copyright     z_deflate_copyright
 #  define get_crc_table         z_get_crc_table
@@ -94,6 +122,7 @@
 #    define gzsetparams           z_gzsetparams
 #    define gztell                z_gztell
 #    define gztell64              z_gztell64
+#    define gzthreads             z_gzthreads
 #    define gzungetc              z_gzungetc
 #    define gzvprintf             z_gzvprintf
 #    define gzwrite               z_gzwrite
@@ -103,6 +132,7 @@
 #  define inflateBackEnd        z_inflateBackEnd
 #  define inflateBackInit       z_inflateBackInit
 #  define inflateBackInit_      z_inflateBackInit_
+#  define inflateBuffer         z_inflateBuffer
 #  define inflateCodesUsed      z_inflateCodesUsed
 #  define inflateCopy           z_inflateCopy
 #  define inflateEnd            z_inflateEnd
@@ -112,7 +142,9 @@
 #  define inflateInit2          z_inflateInit2
 #  define inflateInit2_         z_inflateInit2_
 #  define inflateInit_          z_inflateInit_
+#  define inflateKeepOutput     z_inflateKeepOutput
 #  define inflateMark           z_inflateMark
+#  define inflateParallel       z_inflateParallel
 #  define inflatePrime          z_inflatePrime
 #  define inflateReset          z_inflateReset
 #  define inflateReset2         z_inflateReset2
@@ -120,16 +152,28 @@
 #  define inflateSetDictionary  z_inflateSetDictionary
 #  define inflateSync           z_inflateSync
 #  define inflateSyncPoint      z_inflateSyncPoint
+#  define inflateTune           z_inflateTune
 #  define inflateUndermine      z_inflateUndermine
 #  define inflateValidate       z_inflateValidate
 #  define inflate_copyright     z_inflate_copyright
 #  define inflate_fast          z_inflate_fast
+#  define inflate_pairs         z_inflate_pairs
 #  define inflate_table         z_inflate_table
+#  define slide_hash_avx2       z_slide_hash_avx2
+#  define slide_hash_c          z_slide_hash_c
+#  define slide_hash_neon       z_slide_hash_neon
+#  define slide_hash_sse2       z_slide_hash_sse2
 #  ifndef Z_SOLO
 #    define uncompress            z_uncompress
 #    define uncompress2           z_uncompress2
 #  endif
 #  define zError                z_zError
+#  define z_cpu_features        z_z_cpu_features
+#  define z_lock_free           z_z_lock_free
+#  define z_lock_init           z_z_lock_init
+#  define z_once                z_z_once
+#  define z_run                 z_z_run
+#  define z_threads             z_z_threads
 #  ifndef Z_SOLO
 #    define zcalloc               z_zcalloc
 #    define zcfree                z_zcfree
@@ -273,8 +317,9 @@
 /* The memory requirements for deflate are (in bytes):
             (1 << (windowBits+2)) +  (1 << (memLevel+9))
  that is: 128K for windowBits=15  +  128K for memLevel = 8  (default values)
- plus a few kilobytes for small objects. For example, if you want to reduce
- the default memory requirements from 256K to 128K, compile with
+ plus a few kilobytes for small objects, and about 600K more at levels 10 to
+ 12. For example, if you want to reduce the default memory requirements from
+ 256K to 128K, compile with
      make CFLAGS="-O -DMAX_WBITS=14 -DMAX_MEM_LEVEL=7"
  Of course this will generally degrade compression (there's no free lunch).
 
@@ -190,6 +190,7 @@ typedef gz_header FAR *gz_headerp;
 #define Z_NO_COMPRESSION         0
 #define Z_BEST_SPEED             1
 #define Z_BEST_COMPRESSION       9
+#define Z_OPTIMAL_COMPRESSION   12
 #define Z_DEFAULT_COMPRESSION  (-1)
 /* compression levels */
 
@@ -197,6 +198,7 @@ typedef gz_header FAR *gz_headerp;
 #define Z_HUFFMAN_ONLY        2
 #define Z_RLE                 3
 #define Z_FIXED               4
+#define Z_QUICK               5
 #define Z_DEFAULT_STRATEGY    0
 /* compression strategy; see deflateInit2() below for details */
 
@@ -232,11 +234,16 @@ ZEXTERN int ZEXPORT deflateInit OF((z_streamp strm, int level));
    zalloc and zfree are set to Z_NULL, deflateInit updates them to use default
    allocation functions.
 
-     The compression level must be Z_DEFAULT_COMPRESSION, or between 0 and 9:
-   1 gives best speed, 9 gives best compression, 0 gives no compression at all
-   (the input data is simply copied a block at a time).  Z_DEFAULT_COMPRESSION
-   requests a default compromise between speed and compression (currently
-   equivalent to level 6).
+     The compression level must be Z_DEFAULT_COMPRESSION, or between 0 and 12:
+   1 gives best speed, 9 gives best compression in the usual time, 0 gives no
+   compression at all (the input data is simply copied a block at a time).
+   Z_DEFAULT_COMPRESSION requests a default compromise between speed and
+   compression (currently equivalent to level 6).  Levels 10 through 12
+   (Z_OPTIMAL_COMPRESSION) choose the matches and literals that take the fewest
+   bits with the codes that will be used, instead of taking the longest matches.
+   That compresses several percent better than level 9, but is five to twenty
+   times slower and uses about 600K more memory.  The output is ordinary deflate
+   data that any inflate can decompress.
 
      deflateInit returns Z_OK if success, Z_MEM_ERROR if there was not enough
    memory, Z_STREAM_ERROR if level is not a valid compression level, or
@@ -597,7 +604,13 @@ ZEXTERN int ZEXPORT deflateInit2 OF((z_streamp strm,
    strategy parameter only affects the compression ratio but not the
    correctness of the compressed output even if it is not set appropriately.
    Z_FIXED prevents the use of dynamic Huffman codes, allowing for a simpler
-   decoder for special applications.
+   decoder for special applications.  Z_QUICK trades some compression for
+   speed: it looks for a match at only one earlier string per position and
+   codes the data with the fixed Huffman codes as it goes, which is nearly
+   twice as fast as level 1 at any level other than zero, for output about a
+   fifth larger.  With Z_QUICK, deflate() keeps the current block open until a flush
+   or the end of the stream, and never falls back to stored blocks, so
+   incompressible data can expand by as much as deflateBound() allows.
 
      deflateInit2 returns Z_OK if success, Z_MEM_ERROR if there was not enough
    memory, Z_STREAM_ERROR if any parameter is invalid (such as an invalid
@@ -757,6 +770,29 @@ ZEXTERN int ZEXPORT deflateTune OF((z_streamp strm,
    returns Z_OK on success, or Z_STREAM_ERROR for an invalid deflate stream.
  */
 
+ZEXTERN int ZEXPORT deflateSplit OF((z_streamp strm,
+                                     int parts));
+/*
+     Allow deflate to send the data for which it would have sent one block
+   as up to parts blocks instead, each with its own Huffman codes, where the
+   statistics of the data change enough within the block for that to make
+   the compressed data smaller.  This helps mostly on mixed data, such as text
+   interleaved with binary tables.  The blocks are chosen by estimating the
+   entropy of pieces of the data before it is sent.  That costs little when
+   the data is uniform, but can add a fifth to the compression time at the
+   default level, and half at level 1, when the data is mixed.  parts must be
+   in the range 1..16, where 1, the default, turns splitting off.  The
+   compressed data remains standard deflate data.  Splitting is not done for
+   level 0, Z_FIXED, or for blocks of fewer than 2048 symbols, which are never
+   produced with a memLevel less than 6.
+
+     deflateSplit() can be called after deflateInit() or deflateInit2(), and
+   the setting is retained by deflateReset().  It returns Z_OK on success,
+   Z_STREAM_ERROR if the stream state was inconsistent or parts was out of
+   range, or Z_MEM_ERROR if there was not enough memory for the about 10K of
+   work space it needs.
+*/
+
 ZEXTERN uLong ZEXPORT deflateBound OF((z_streamp strm,
                                        uLong sourceLen));
 /*
@@ -917,8 +953,9 @@ ZEXTERN int ZEXPORT inflateGetDictionary OF((z_streamp strm,
    Z_NULL, then only the dictionary length is returned, and nothing is copied.
    Similary, if dictLength is Z_NULL, then it is not set.
 
-     inflateGetDictionary returns Z_OK on success, or Z_STREAM_ERROR if the
-   stream state is inconsistent.
+     inflateGetDictionary returns Z_OK on success, Z_MEM_ERROR if there was not
+   enough memory to copy output kept by inflateKeepOutput() to the window, or
+   Z_STREAM_ERROR if the stream state is inconsistent.
 */
 
 ZEXTERN int ZEXPORT inflateSync OF((z_streamp strm));
@@ -1001,6 +1038,54 @@ ZEXTERN int ZEXPORT inflatePrime OF((z_streamp strm,
    stream state was inconsistent.
 */
 
+ZEXTERN int ZEXPORT inflateTune OF((z_streamp strm,
+                                    int lenbits,
+                                    int distbits,
+                                    int tables));
+/*
+     Set how inflate() builds its decoding tables for dynamic blocks.  lenbits
+   and distbits are the number of bits of a literal/length code and of a
+   distance code that are decoded with one lookup, in the ranges 9..11 and
+   6..8 respectively.  The defaults are 9 and 6.  Larger tables can speed up
+   decoding of long blocks, but take longer to build.  tables is the number of
+   sets of decoding tables, in the range 0..16, that are kept and reused for a
+   later block with the same code lengths.  That saves building them again
+   for a stream with many small dynamic blocks that repeat their codes.  If
+   lenbits or distbits is larger than the default, then at least one set is
+   kept.  Each set takes up to about 11K bytes, allocated with zalloc.  The
+   sets are freed by inflateEnd(), or by another inflateTune() call with the
+   default bits and tables zero.  The settings are kept by inflateReset().
+
+     inflateTune() can be called after inflateInit(), inflateInit2(), or
+   inflateReset(), before the first call of inflate().  It does not apply to
+   inflateBack().  inflateTune returns Z_OK if success, Z_MEM_ERROR if there
+   was not enough memory, or Z_STREAM_ERROR if the source stream state was
+   inconsistent, inflate() was already called, or a parameter is invalid.
+*/
+
+ZEXTERN int ZEXPORT inflateKeepOutput OF((z_streamp strm,
+                                          int keep));
+/*
+     If keep is true, inflate() does not copy the end of its output to its
+   window, but refers back to that output in place for the matches of the
+   next call, as long as that call continues the output where the last call
+   ended, as it does when decompressing into one large buffer.  This saves a
+   copy of up to the window size for each call of inflate(), and the window
+   is not even allocated if the output is always continued.  In return, the
+   application must not change the last window size bytes of output (32K
+   bytes for windowBits 15) until the next call of inflate(),
+   inflateGetDictionary(), inflateSetDictionary(), inflateCopy(),
+   inflateKeepOutput(), or inflateEnd() on the stream, or until
+   inflateReset().  If the next call of inflate() provides output elsewhere,
+   then the kept output is first copied to the window.  The setting is kept
+   by inflateReset().  keep zero restores the usual behavior.
+
+     inflateKeepOutput() does not apply to inflateBack().  inflateKeepOutput
+   returns Z_OK if success, Z_MEM_ERROR if there was not enough memory to
+   copy the kept output to the window, or Z_STREAM_ERROR if the source stream
+   state was inconsistent.
+*/
+
 ZEXTERN long ZEXPORT inflateMark OF((z_streamp strm));
 /*
      This function returns two values, one in the lower 16 bits of the return
@@ -1173,6 +1258,43 @@ ZEXTERN int ZEXPORT inflateBackEnd OF((z_streamp strm));
    state was inconsistent.
 */
 
+ZEXTERN int ZEXPORT inflateParallel OF((const Bytef *source,
+                                        z_size_t *sourceLen,
+                                        int windowBits,
+                                        out_func out, void FAR *out_desc,
+                                        int threads));
+/*
+     Decompresses the source buffer using several threads at once, delivering
+   the uncompressed data in order by calling out(out_desc, buf, len) as
+   inflateBack() does.  out() returns zero on success, or non-zero to stop.
+   Upon entry, *sourceLen is the length of the source.  windowBits has the
+   same meaning as for inflateInit2(), so the source can be a zlib stream, a
+   gzip stream, either one, or raw deflate data.  If a gzip stream is
+   followed by another gzip stream, that one is decompressed as well, and so
+   on.  Any data after the last stream is ignored.  Upon exit, *sourceLen is
+   the number of source bytes used by the streams decompressed completely.
+   threads is the most threads to use, or zero or less to use one per
+   processor.
+
+     The deflate data of a stream is cut into chunks of 1M compressed bytes,
+   and each thread guesses where a block starts in its chunk, then decodes
+   from there without knowing the preceding output.  Matches that refer back
+   before the chunk are resolved once the output before it is known.  A
+   wrong guess only costs time, so the result is always the same as from
+   inflate().  Data that is not compressed with dynamic or stored blocks
+   does not decode in parallel, nor does data that expands by more than
+   about 16 times.  Each thread may use up to 64M of memory for its decoded
+   chunk.  If zlib was built without thread support, if there is only one
+   thread, or if the source is less than 2M, all of the work is done in the
+   calling thread with inflate().
+
+     inflateParallel returns Z_OK on success, Z_DATA_ERROR if the input data
+   was corrupted or incomplete, including a zlib stream that needs a
+   dictionary, Z_BUF_ERROR if out() returned non-zero, Z_MEM_ERROR if there
+   was not enough memory, or Z_STREAM_ERROR if windowBits is invalid or out
+   is Z_NULL.  The data already delivered before an error is correct.
+*/
+
 ZEXTERN uLong ZEXPORT zlibCompileFlags OF((void));
 /* Return flags indicating compile-time options.
 
@@ -1203,7 +1325,9 @@ ZEXTERN uLong ZEXPORT zlibCompileFlags OF((void));
     Operation variations (changes in library functionality):
      20: PKZIP_BUG_WORKAROUND -- slightly more permissive inflate
      21: FASTEST -- deflate algorithm with only one, lowest compression level
-     22,23: 0 (reserved)
+     22: CRC_HASH -- deflate hashes with the CRC-32C instruction if available
+                     (not set if the hash could not be compiled in)
+     23: INFLATE_MULTISYM -- inflate decodes pairs of short literals at once
 
     The sprintf variant used by gzprintf (zero is best):
      24: 0 = vs*, 1 = s* -- 1 means limited to 20 arguments after the format
@@ -1264,6 +1388,49 @@ ZEXTERN uLong ZEXPORT compressBound OF((uLong sourceLen));
    compress() or compress2() call to allocate the destination buffer.
 */
 
+ZEXTERN int ZEXPORT compressParallel OF((Bytef *dest, uLongf *destLen,
+                                         const Bytef *source, uLong sourceLen,
+                                         int level, int windowBits,
+                                         int threads, uLong chunkSize));
+/*
+     Compresses the source buffer into the destination buffer like compress2(),
+   but using several threads at once.  The source is cut into chunks of
+   chunkSize bytes (the last one may be shorter), which are compressed
+   separately and then joined into a single stream.  Each chunk is given the
+   data before it as a dictionary, so the compression lost at the cuts is
+   small for chunks of 64K or more.  chunkSize zero selects the default of
+   128K; larger values are limited to 1G.
+
+     level has the same meaning as in deflateInit, so it can be from 0 to
+   Z_OPTIMAL_COMPRESSION (12), or Z_DEFAULT_COMPRESSION.  windowBits has the
+   same meaning as in deflateInit2(), so the result can be a zlib stream, a
+   gzip stream (with no file name, a modification time of zero, and no header
+   crc), or raw deflate data.  threads is the most threads to use, or zero or less to
+   use one per processor.  No more threads are used than there are chunks.
+   The compressed data depends only on the source, level, windowBits, and
+   chunkSize, and not on the number of threads.  If zlib was built without
+   thread support, all of the work is done in the calling thread.
+
+     Upon entry, destLen is the total size of the destination buffer, which
+   must be at least the value returned by compressParallelBound(sourceLen,
+   windowBits, chunkSize).  Upon exit, destLen is the actual size of the
+   compressed data.
+
+     compressParallel returns Z_OK if success, Z_MEM_ERROR if there was not
+   enough memory, Z_BUF_ERROR if there was not enough room in the output
+   buffer, or Z_STREAM_ERROR if the level or windowBits parameter is invalid.
+*/
+
+ZEXTERN uLong ZEXPORT compressParallelBound OF((uLong sourceLen,
+                                                int windowBits,
+                                                uLong chunkSize));
+/*
+     compressParallelBound() returns an upper bound on the compressed size
+   after compressParallel() on sourceLen bytes with the given windowBits and
+   chunkSize.  The bound is tight for windowBits 15, 31, and -15, and much
+   looser for smaller windows.
+*/
+
 ZEXTERN int ZEXPORT uncompress OF((Bytef *dest,   uLongf *destLen,
                                    const Bytef *source, uLong sourceLen));
 /*
@@ -1290,6 +1457,26 @@ ZEXTERN int ZEXPORT uncompress2 OF((Bytef *dest,   uLongf *destLen,
    source bytes consumed.
 */
 
+ZEXTERN int ZEXPORT inflateBuffer OF((Bytef *dest,   uLongf *destLen,
+                                      const Bytef *source, uLong *sourceLen,
+                                      int windowBits));
+/*
+     Same as uncompress2, except that windowBits has the same meaning as for
+   inflateInit2(), so the source can be a zlib stream, a gzip stream, either
+   one, or raw deflate data.  uncompress2() is inflateBuffer() with windowBits
+   MAX_WBITS.
+
+     Since the source and the destination are both entirely in memory, the
+   data is decoded straight from one to the other in one pass, without the
+   sliding window, and without the stopping and resuming that inflate()
+   provides.  A zlib stream that needs a dictionary is reported as
+   Z_DATA_ERROR.  inflateBuffer returns Z_STREAM_ERROR if windowBits is
+   invalid, or otherwise the same as uncompress().  If the data does not
+   decode in full, it is decoded again with inflate(), so that the return
+   value, *destLen, and *sourceLen for every error are the same as for
+   uncompress() before inflateBuffer(), at the cost of a second pass.
+*/
+
                         /* gzip file access functions */
 
 /*
@@ -1308,10 +1495,11 @@ ZEXTERN gzFile ZEXPORT gzopen OF((const char *path, const char *mode));
    compressing and writing.  The mode parameter is as in fopen ("rb" or "wb")
    but can also include a compression level ("wb9") or a strategy: 'f' for
    filtered data as in "wb6f", 'h' for Huffman-only compression as in "wb1h",
-   'R' for run-length encoding as in "wb1R", or 'F' for fixed code compression
-   as in "wb9F".  (See the description of deflateInit2 for more information
-   about the strategy parameter.)  'T' will request transparent writing or
-   appending with no compression and not using the gzip format.
+   'R' for run-length encoding as in "wb1R", 'F' for fixed code compression
+   as in "wb9F", or 'Q' for quick compression as in "wb1Q".  (See the
+   description of deflateInit2 for more information about the strategy
+   parameter.)  'T' will request transparent writing or appending with no
+   compression and not using the gzip format.
 
      "a" can be used instead of "w" to request that the gzip stream that will
    be written be appended to the file.  "+" will result in an error, since
@@ -1378,6 +1566,29 @@ ZEXTERN int ZEXPORT gzbuffer OF((gzFile file, unsigned size));
    too late.
 */
 
+ZEXTERN int ZEXPORT gzthreads OF((gzFile file, int threads));
+/*
+     Set the most threads that gzread() and the other reading functions use
+   for file to decompress gzip members.  threads zero or less uses one per
+   processor.  The default is one thread.  This function must be called after
+   gzopen() or gzdopen(), and before any other calls that read the file.
+
+     With more than one thread, when a gzip member starts, the reading
+   functions load up to 1M of compressed data per thread, look for the headers
+   of the members that follow, and decompress the members in that data on the
+   threads at once, each member in full, before delivering the output in
+   order.  This is worthwhile only for files with many members, such as those
+   written in BGZF format or concatenated from several gzip files.  A member
+   whose compressed data does not fit in what was loaded continues to be
+   decompressed as usual.  The data read is the same as with one thread,
+   except that when there is an error, more of the data before it may be read
+   before the error is reported.  If zlib was built without thread support,
+   there is only the one thread.
+
+     gzthreads() returns 0 on success, or -1 on failure, such as being called
+   too late or for a file not opened for reading.
+*/
+
 ZEXTERN int ZEXPORT gzsetparams OF((gzFile file, int level, int strategy));
 /*
      Dynamically update the compression level and strategy for file.  See the
@@ -1772,6 +1983,52 @@ ZEXTERN uLong ZEXPORT crc32_combine_op OF((uLong crc1, uLong crc2, uLong op));
    crc32_combine() if the generated op is used more than once.
 */
 
+ZEXTERN uLong ZEXPORT crc32c_z OF((uLong crc, const Bytef *buf,
+                                   z_size_t len));
+/*
+     Update a running CRC-32C with the bytes buf[0..len-1] and return the
+   updated CRC-32C.  CRC-32C uses the Castagnoli polynomial, as in iSCSI, SCTP,
+   and ext4, and otherwise works the same as crc32_z(), including the initial
+   value returned for a Z_NULL buf.  The SSE4.2 crc32 instruction is used if
+   the processor has it, as are the ARMv8 crc32c instructions if zlib is
+   compiled for a processor that has them.  The check value of the nine bytes
+   "123456789" is 0xe3069283.
+*/
+
+/*
+ZEXTERN uLong ZEXPORT crc32c_combine OF((uLong crc1, uLong crc2,
+                                         z_off_t len2));
+
+     Same as crc32_combine(), but for CRC-32C check values.
+*/
+
+ZEXTERN uLong ZEXPORT crc32_copy OF((uLong crc, Bytef *dst, const Bytef *src,
+                                     z_size_t len));
+ZEXTERN uLong ZEXPORT adler32_copy OF((uLong adler, Bytef *dst,
+                                       const Bytef *src, z_size_t len));
+/*
+     Copy len bytes from src to dst, which must not overlap, and return crc or
+   adler updated with those bytes, the same as from crc32_z() or adler32_z().
+   The bytes are checked and copied a few thousand at a time, so src is read
+   from memory only once instead of twice for a copy followed by a check.  If
+   src is Z_NULL, nothing is copied and the required initial value is
+   returned.
+*/
+
+ZEXTERN uLong ZEXPORT crc32_parallel OF((uLong crc, const Bytef *buf,
+                                         z_size_t len, int threads));
+ZEXTERN uLong ZEXPORT adler32_parallel OF((uLong adler, const Bytef *buf,
+                                           z_size_t len, int threads));
+/*
+     Same as crc32_z() and adler32_z(), but using several threads at once for
+   a large buffer.  The buffer is cut into pieces whose check values are
+   computed separately and then combined, so the result is the same whatever
+   the number of threads.  threads is the most threads to use, or zero or less
+   to use one per processor.  Pieces are at least 1M, so buffers shorter than
+   2M, and all buffers if zlib was built without thread support, are checked
+   in the calling thread.
+*/
+
 
                         /* various hacks, don't look :) */
 
@@ -1860,6 +2117,7 @@ ZEXTERN int ZEXPORT gzgetc_ OF((gzFile file));  /* backward compatibility */
    ZEXTERN uLong ZEXPORT adler32_combine64 OF((uLong, uLong, z_off64_t));
    ZEXTERN uLong ZEXPORT crc32_combine64 OF((uLong, uLong, z_off64_t));
    ZEXTERN uLong ZEXPORT crc32_combine_gen64 OF((z_off64_t));
+   ZEXTERN uLong ZEXPORT crc32c_combine64 OF((uLong, uLong, z_off64_t));
 #endif
 
 #if !defined(ZLIB_INTERNAL) && defined(Z_WANT64)
@@ -1871,6 +2129,7 @@ ZEXTERN int ZEXPORT gzgetc_ OF((gzFile file));  /* backward compatibility */
 #    define z_adler32_combine z_adler32_combine64
 #    define z_crc32_combine z_crc32_combine64
 #    define z_crc32_combine_gen z_crc32_combine_gen64
+#    define z_crc32c_combine z_crc32c_combine64
 #  else
 #    define gzopen gzopen64
 #    define gzseek gzseek64
@@ -1879,6 +2138,7 @@ ZEXTERN int ZEXPORT gzgetc_ OF((gzFile file));  /* backward compatibility */
 #    define adler32_combine adler32_combine64
 #    define crc32_combine crc32_combine64
 #    define crc32_combine_gen crc32_combine_gen64
+#    define crc32c_combine crc32c_combine64
 #  endif
 #  ifndef Z_LARGE64
      ZEXTERN gzFile ZEXPORT gzopen64 OF((const char *, const char *));
@@ -1888,6 +2148,7 @@ ZEXTERN int ZEXPORT gzgetc_ OF((gzFile file));  /* backward compatibility */
      ZEXTERN uLong ZEXPORT adler32_combine64 OF((uLong, uLong, z_off_t));
      ZEXTERN uLong ZEXPORT crc32_combine64 OF((uLong, uLong, z_off_t));
      ZEXTERN uLong ZEXPORT crc32_combine_gen64 OF((z_off_t));
+     ZEXTERN uLong ZEXPORT crc32c_combine64 OF((uLong, uLong, z_off_t));
 #  endif
 #else
    ZEXTERN gzFile ZEXPORT gzopen OF((const char *, const char *));
@@ -1897,6 +2158,7 @@ ZEXTERN int ZEXPORT gzgetc_ OF((gzFile file));  /* backward compatibility */
    ZEXTERN uLong ZEXPORT adler32_combine OF((uLong, uLong, z_off_t));
    ZEXTERN uLong ZEXPORT crc32_combine OF((uLong, uLong, z_off_t));
    ZEXTERN uLong ZEXPORT crc32_combine_gen OF((z_off_t));
+   ZEXTERN uLong ZEXPORT crc32c_combine OF((uLong, uLong, z_off_t));
 #endif
 
 #else /* Z_SOLO */
@@ -1904,6 +2166,7 @@ ZEXTERN int ZEXPORT gzgetc_ OF((gzFile file));  /* backward compatibility */
    ZEXTERN uLong ZEXPORT adler32_combine OF((uLong, uLong, z_off_t));
    ZEXTERN uLong ZEXPORT crc32_combine OF((uLong, uLong, z_off_t));
    ZEXTERN uLong ZEXPORT crc32_combine_gen OF((z_off_t));
+   ZEXTERN uLong ZEXPORT crc32c_combine OF((uLong, uLong, z_off_t));
 
 #endif /* !Z_SOLO */
 
@@ -0,0 +1,102 @@
+/* zthread.c -- run work in parallel for the parallel routines
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+#include "zthread.h"
+
+#ifdef Z_THREADS
+#  include <unistd.h>
+
+/* ===========================================================================
+ * Initialize a lock. Return 0 on success, or -1 if the resources for it could
+ * not be had.
+ */
+int ZLIB_INTERNAL z_lock_init(lock)
+    z_lock *lock;
+{
+    if (pthread_mutex_init(&lock->mutex, NULL))
+        return -1;
+    if (pthread_cond_init(&lock->cond, NULL)) {
+        pthread_mutex_destroy(&lock->mutex);
+        return -1;
+    }
+    return 0;
+}
+
+/* ===========================================================================
+ * Release the resources of a lock that no thread is using.
+ */
+void ZLIB_INTERNAL z_lock_free(lock)
+    z_lock *lock;
+{
+    pthread_cond_destroy(&lock->cond);
+    pthread_mutex_destroy(&lock->mutex);
+}
+#endif
+
+/* ===========================================================================
+ */
+int ZLIB_INTERNAL z_threads(threads)
+    int threads;
+{
+#ifdef Z_THREADS
+    if (threads <= 0) {
+#  ifdef _SC_NPROCESSORS_ONLN
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+        threads = n < 1 ? 1 : n > Z_MAX_THREADS ? Z_MAX_THREADS : (int)n;
+#  else
+        threads = 1;
+#  endif
+    }
+    return threads > Z_MAX_THREADS ? Z_MAX_THREADS : threads;
+#else
+    (void)threads;
+    return 1;
+#endif
+}
+
+#ifdef Z_THREADS
+/* pthread_create() wants a function that takes and returns a void pointer */
+typedef struct {
+    void (*work) OF((voidpf));
+    voidpf arg;
+} z_job;
+
+local void *z_start OF((void *job));
+local void *z_start(job)
+    void *job;
+{
+    ((z_job *)job)->work(((z_job *)job)->arg);
+    return NULL;
+}
+#endif
+
+/* ===========================================================================
+ */
+int ZLIB_INTERNAL z_run(threads, work, arg)
+    int threads;
+    void (*work) OF((voidpf));
+    voidpf arg;
+{
+#ifdef Z_THREADS
+    pthread_t id[Z_MAX_THREADS - 1];
+    z_job job;
+    int n, k;
+
+    job.work = work;
+    job.arg = arg;
+    threads = z_threads(threads);
+    for (n = 0; n < threads - 1; n++)
+        if (pthread_create(id + n, NULL, z_start, &job))
+            break;
+    work(arg);
+    for (k = 0; k < n; k++)
+        pthread_join(id[k], NULL);
+    return n + 1;
+#else
+    (void)threads;
+    work(arg);
+    return 1;
+#endif
+}
@@ -0,0 +1,68 @@
+/* zthread.h -- internal threads interface for the parallel routines
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* WARNING: this file should *not* be used by applications. It is
+   part of the implementation of the compression library and is
+   subject to change. Applications should only use zlib.h.
+ */
+
+#ifndef ZTHREAD_H
+#define ZTHREAD_H
+
+#include "zutil.h"
+
+/* define HAVE_PTHREAD when compiling (configure and cmake do this when they
+   find POSIX threads) to let the parallel routines use more than one thread.
+   Without it they run everything in the calling thread, which gives the same
+   results, just no faster. */
+#if defined(HAVE_PTHREAD) && !defined(Z_SOLO)
+#  include <pthread.h>
+#  define Z_THREADS
+#endif
+
+#define Z_MAX_THREADS 256   /* most threads that z_run() will use */
+
+/* A mutex with one condition variable. z_wait() releases the lock, waits for
+   a z_wake() from another thread, and reacquires the lock before returning.
+   Without Z_THREADS these do nothing, since there is only the one thread. */
+#ifdef Z_THREADS
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} z_lock;
+
+int ZLIB_INTERNAL z_lock_init OF((z_lock *lock));
+void ZLIB_INTERNAL z_lock_free OF((z_lock *lock));
+#  define z_acquire(lock) pthread_mutex_lock(&(lock)->mutex)
+#  define z_release(lock) pthread_mutex_unlock(&(lock)->mutex)
+#  define z_wait(lock) pthread_cond_wait(&(lock)->cond, &(lock)->mutex)
+#  define z_wake(lock) pthread_cond_broadcast(&(lock)->cond)
+#else
+typedef int z_lock;
+
+#  ifdef Z_PREFIX_SET
+#    undef z_lock_init
+#    undef z_lock_free
+#  endif
+#  define z_lock_init(lock) 0
+#  define z_lock_free(lock) ((void)0)
+#  define z_acquire(lock) ((void)0)
+#  define z_release(lock) ((void)0)
+#  define z_wait(lock) ((void)0)
+#  define z_wake(lock) ((void)0)
+#endif
+
+/* Return the number of threads to use for a request of threads, where zero
+   or less means one per processor, limited to 1..Z_MAX_THREADS. */
+int ZLIB_INTERNAL z_threads OF((int threads));
+
+/* Run work(arg) in threads threads at once, the calling thread being one of
+   them, and return when they have all returned. If fewer threads can be
+   started, the work is shared by the ones that could be. Return the number of
+   threads that ran, which is at least one. work() must be written so that it
+   finishes whatever the number of threads. */
+int ZLIB_INTERNAL z_run OF((int threads, void (*work)(voidpf arg),
+                            voidpf arg));
+
+#endif /* ZTHREAD_H */
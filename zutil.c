@@ -85,6 +85,12 @@ uLong ZEXPORT zlibCompileFlags()
 #ifdef FASTEST
     flags += 1L << 21;
 #endif
+#ifdef USE_CRC_HASH
+    flags += 1L << 22;
+#endif
+#ifdef INFLATE_MULTISYM
+    flags += 1L << 23;
+#endif
 #if defined(STDC) || defined(Z_HAVE_STDARG_H)
 #  ifdef NO_vsnprintf
     flags += 1L << 25;
@@ -136,6 +142,190 @@ const char * ZEXPORT zError(err)
     return ERR_MSG(err);
 }
 
+#if defined(Z_X86_SIMD) || defined(Z_ARM_SIMD)
+
+#ifdef Z_X86_SIMD
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+
+/* Put the eax, ebx, ecx, and edx results of cpuid for leaf and sub in reg. */
+local void cpuid OF((unsigned leaf, unsigned sub, unsigned reg[4]));
+local void cpuid(leaf, sub, reg)
+    unsigned leaf;
+    unsigned sub;
+    unsigned reg[4];
+{
+#  ifdef _MSC_VER
+    int r[4];
+
+    __cpuidex(r, (int)leaf, (int)sub);
+    reg[0] = (unsigned)r[0];
+    reg[1] = (unsigned)r[1];
+    reg[2] = (unsigned)r[2];
+    reg[3] = (unsigned)r[3];
+#  else
+    __cpuid_count(leaf, sub, reg[0], reg[1], reg[2], reg[3]);
+#  endif
+}
+
+/* Return the low 32 bits of the XCR0 register: the register state that the
+   operating system saves and restores on a context switch. Only call this if
+   cpuid reports OSXSAVE. */
+local unsigned xcr0 OF((void));
+local unsigned xcr0()
+{
+#  ifdef _MSC_VER
+    return (unsigned)_xgetbv(0);
+#  else
+    unsigned eax, edx;
+
+    __asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+#  endif
+}
+#endif /* Z_X86_SIMD */
+
+/* Return the Z_CPU_* flags for the processor features that the SIMD code can
+   use. */
+local unsigned cpu_query OF((void));
+local unsigned cpu_query()
+{
+    unsigned have = 0;
+
+#ifdef Z_X86_SIMD
+    {
+        unsigned reg[4], max, os;
+
+        have |= Z_CPU_SSE2;             /* part of the x86-64 baseline */
+        cpuid(0, 0, reg);
+        max = reg[0];
+        if (max >= 1) {
+            cpuid(1, 0, reg);
+            if (reg[2] & (1U << 9))
+                have |= Z_CPU_SSSE3;
+            if (reg[2] & (1U << 20))
+                have |= Z_CPU_SSE42;
+            if ((reg[2] & (1U << 1)) && (reg[2] & (1U << 19)))
+                have |= Z_CPU_PCLMUL;
+            /* AVX2 needs the OS to preserve the xmm and ymm registers, and
+               AVX-512 also the opmask and zmm registers */
+            os = reg[2] & (1U << 27) ? xcr0() : 0;
+            if (max >= 7 && (os & 6) == 6) {
+                cpuid(7, 0, reg);
+                if (reg[1] & (1U << 5))
+                    have |= Z_CPU_AVX2;
+                if ((os & 0xe6) == 0xe6 && (reg[1] & (1U << 16)) &&
+                    (reg[2] & (1U << 10)) && (have & Z_CPU_PCLMUL))
+                    have |= Z_CPU_VPCLMUL;
+            }
+        }
+    }
+#endif
+#ifdef Z_ARM_SIMD
+    have |= Z_CPU_NEON;                 /* part of the aarch64 baseline */
+#endif
+    return have;
+}
+
+#endif /* Z_X86_SIMD || Z_ARM_SIMD */
+
+/* ===========================================================================
+ * Run init() exactly once for state. If atomics are available, then threads
+ * that arrive while another is running init() wait for it to finish.
+ */
+#if defined(__STDC__) && __STDC_VERSION__ >= 201112L && \
+    !defined(__STDC_NO_ATOMICS__)
+
+void ZLIB_INTERNAL z_once(state, init)
+    z_once_t *state;
+    void (*init)(void);
+{
+    if (!atomic_load(&state->done)) {
+        if (atomic_flag_test_and_set(&state->begun))
+            while (!atomic_load(&state->done))
+                ;
+        else {
+            init();
+            atomic_store(&state->done, 1);
+        }
+    }
+}
+
+#else   /* no atomics */
+
+/* Without C11 atomics, use the compiler's atomic operations to test and set
+   begun, and to make what init() wrote visible to any thread that sees done
+   set. Failing those, test and set is not atomic, and the first call must
+   return before any other thread makes one, as noted in zutil.h. */
+#if defined(__clang__) || (defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#  define test_and_set(flag) __atomic_exchange_n(flag, 1, __ATOMIC_ACQ_REL)
+#  define load_done(state) __atomic_load_n(&(state)->done, __ATOMIC_ACQUIRE)
+#  define set_done(state) __atomic_store_n(&(state)->done, 1, __ATOMIC_RELEASE)
+#elif defined(_MSC_VER)
+#  include <intrin.h>
+#  define test_and_set(flag) _InterlockedExchange(flag, 1)
+#  define load_done(state) _InterlockedCompareExchange(&(state)->done, 0, 0)
+#  define set_done(state) _InterlockedExchange(&(state)->done, 1)
+#else
+#  define load_done(state) ((state)->done)
+#  define set_done(state) ((state)->done = 1)
+
+/* Test and set. Alas, not atomic, but tries to minimize the period of
+   vulnerability. */
+local long test_and_set OF((long volatile *));
+local long test_and_set(flag)
+    long volatile *flag;
+{
+    long was;
+
+    was = *flag;
+    *flag = 1;
+    return was;
+}
+#endif
+
+void ZLIB_INTERNAL z_once(state, init)
+    z_once_t *state;
+    void (*init)(void);
+{
+    if (!load_done(state)) {
+        if (test_and_set(&state->begun))
+            while (!load_done(state))
+                ;
+        else {
+            init();
+            set_done(state);
+        }
+    }
+}
+
+#endif
+
+#if defined(Z_X86_SIMD) || defined(Z_ARM_SIMD)
+local unsigned features;
+local z_once_t features_made = Z_ONCE_INIT;
+
+local void features_init OF((void));
+local void features_init()
+{
+    features = cpu_query();
+}
+
+/* ===========================================================================
+ * Return the Z_CPU_* flags for the processor features that the SIMD code can
+ * use, querying the processor the first time through.
+ */
+unsigned ZLIB_INTERNAL z_cpu_features()
+{
+    z_once(&features_made, features_init);
+    return features;
+}
+#endif
+
 #if defined(_WIN32_WCE) && _WIN32_WCE < 0x800
     /* The older Microsoft C Run-Time Library for Windows CE doesn't have
      * errno.  We define it as a global variable to simplify porting.
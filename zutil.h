@@ -193,6 +193,8 @@ extern z_const char * const z_errmsg[10]; /* indexed by 2-zlib_error */
     (!defined(_LARGEFILE64_SOURCE) || _LFS64_LARGEFILE-0 == 0)
     ZEXTERN uLong ZEXPORT adler32_combine64 OF((uLong, uLong, z_off_t));
     ZEXTERN uLong ZEXPORT crc32_combine64 OF((uLong, uLong, z_off_t));
+    ZEXTERN uLong ZEXPORT crc32_combine_gen64 OF((z_off_t));
+    ZEXTERN uLong ZEXPORT crc32c_combine64 OF((uLong, uLong, z_off_t));
 #endif
 
         /* common defaults */
@@ -271,4 +273,161 @@ extern z_const char * const z_errmsg[10]; /* indexed by 2-zlib_error */
 #define ZSWAP32(q) ((((q) >> 24) & 0xff) + (((q) >> 8) & 0xff00) + \
                     (((q) & 0xff00) << 8) + (((q) & 0xff) << 24))
 
+        /* SIMD support */
+
+/* Z_X86_SIMD is defined for x86-64 targets when the compiler provides the
+   Intel intrinsics and can compile individual functions for instruction sets
+   beyond the baseline SSE2, which are then only called after checking the
+   processor at run time. Z_ARM_SIMD is defined for aarch64 targets, where
+   NEON is always available. Compile with -DNO_SIMD to use only portable C.
+ */
+#ifndef NO_SIMD
+#  if defined(__x86_64__) && (defined(__clang__) || __GNUC__ > 4 || \
+                              (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#    define Z_X86_SIMD
+#    define Z_TARGET(isa) __attribute__((target(isa)))
+#  elif defined(_M_X64) && defined(_MSC_VER) && _MSC_VER >= 1800
+#    define Z_X86_SIMD
+#    define Z_TARGET(isa)
+#  elif (defined(__aarch64__) && defined(__ARM_NEON)) || \
+        (defined(_M_ARM64) && defined(_MSC_VER))
+#    define Z_ARM_SIMD
+#  endif
+#endif
+
+/* Z_X86_AVX512 is defined in addition when the compiler also knows the
+   AVX-512 and VPCLMULQDQ intrinsics. */
+#ifdef Z_X86_SIMD
+#  if (defined(__clang__) && __clang_major__ >= 6) || \
+      (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 8) || \
+      (defined(_MSC_VER) && _MSC_VER >= 1920)
+#    define Z_X86_AVX512
+#  endif
+#endif
+
+/* define CRC_HASH when compiling to have deflate hash with the CRC-32C
+   instruction. USE_CRC_HASH is then defined where that can be compiled in,
+   which is also what zlibCompileFlags() reports. */
+#if defined(CRC_HASH) && !defined(UNALIGNED_OK) && (defined(Z_X86_SIMD) || \
+    (defined(Z_ARM_SIMD) && defined(__ARM_FEATURE_CRC32)))
+#  define USE_CRC_HASH
+#endif
+
+#if defined(Z_X86_SIMD) || defined(Z_ARM_SIMD)
+/* Processor features reported by z_cpu_features() */
+#  define Z_CPU_SSE2    0x0001  /* x86: SSE2 (always present on x86-64) */
+#  define Z_CPU_AVX2    0x0002  /* x86: AVX2, with OS support for ymm state */
+#  define Z_CPU_SSE42   0x0004  /* x86: SSE4.2, for the crc32 instruction */
+#  define Z_CPU_PCLMUL  0x0008  /* x86: PCLMULQDQ and SSE4.1 */
+#  define Z_CPU_VPCLMUL 0x0010  /* x86: VPCLMULQDQ and AVX-512F, with OS
+                                   support for zmm state */
+#  define Z_CPU_SSSE3   0x0020  /* x86: SSSE3 */
+#  define Z_CPU_NEON    0x0100  /* ARM: Advanced SIMD (always on aarch64) */
+
+   unsigned ZLIB_INTERNAL z_cpu_features OF((void));
+
+/* Count trailing zeros of a non-zero 32-bit or 64-bit value */
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#    pragma intrinsic(_BitScanForward, _BitScanForward64)
+     local __inline unsigned z_ctz32(unsigned long x) {
+         unsigned long n;
+         _BitScanForward(&n, x);
+         return (unsigned)n;
+     }
+     local __inline unsigned z_ctz64(unsigned __int64 x) {
+         unsigned long n;
+         _BitScanForward64(&n, x);
+         return (unsigned)n;
+     }
+#  else
+#    define z_ctz32(x) ((unsigned)__builtin_ctz(x))
+#    define z_ctz64(x) ((unsigned)__builtin_ctzll(x))
+#  endif
+#endif
+
+        /* one-time initialization */
+
+/* z_once() runs init() exactly once, even if several threads call it at the
+   same time, for a state initialized with Z_ONCE_INIT. That needs C11
+   atomics, or else the atomic operations of gcc, clang, or MSVC. Without any
+   of those, the first call of z_once() for a state must return before any
+   other thread may make one. */
+#if defined(__STDC__) && __STDC_VERSION__ >= 201112L && \
+    !defined(__STDC_NO_ATOMICS__)
+#  include <stdatomic.h>
+   typedef struct {
+       atomic_flag begun;
+       atomic_int done;
+   } z_once_t;
+#  define Z_ONCE_INIT {ATOMIC_FLAG_INIT, 0}
+#else
+   typedef struct {
+       volatile long begun;
+       volatile long done;
+   } z_once_t;
+#  define Z_ONCE_INIT {0, 0}
+#endif
+
+void ZLIB_INTERNAL z_once OF((z_once_t *state, void (*init)(void)));
+
+        /* run-time dispatch */
+
+/* A routine that has more than one version chooses the fastest one that the
+   processor can run in the module that defines them, using z_cpu_features(),
+   so that linking one module does not bring in the others. The _base versions
+   are the ones that need no run-time check, and are what the others fall back
+   to for what they don't handle. */
+
+        /* in crc32.c and adler32.c */
+/* Bytes at a time that crc32_copy() and adler32_copy() check and then copy,
+   few enough that the copy reads them back from the L1 cache */
+#define Z_COPY_CHUNK 8192
+
+unsigned long ZLIB_INTERNAL crc32_base OF((unsigned long crc,
+                                           const unsigned char FAR *buf,
+                                           z_size_t len));
+unsigned long ZLIB_INTERNAL crc32c_base OF((unsigned long crc,
+                                            const unsigned char FAR *buf,
+                                            z_size_t len));
+uLong ZLIB_INTERNAL adler32_base OF((uLong adler, const Bytef *buf,
+                                     z_size_t len));
+#ifdef Z_X86_SIMD
+unsigned long ZLIB_INTERNAL crc32_pclmul OF((unsigned long crc,
+                                             const unsigned char FAR *buf,
+                                             z_size_t len));
+#  ifdef Z_X86_AVX512
+unsigned long ZLIB_INTERNAL crc32_vpclmul OF((unsigned long crc,
+                                              const unsigned char FAR *buf,
+                                              z_size_t len));
+#  endif
+unsigned long ZLIB_INTERNAL crc32c_sse42 OF((unsigned long crc,
+                                             const unsigned char FAR *buf,
+                                             z_size_t len));
+uLong ZLIB_INTERNAL adler32_ssse3 OF((uLong adler, const Bytef *buf,
+                                      z_size_t len));
+uLong ZLIB_INTERNAL adler32_avx2 OF((uLong adler, const Bytef *buf,
+                                     z_size_t len));
+#endif
+#ifdef Z_ARM_SIMD
+uLong ZLIB_INTERNAL adler32_neon OF((uLong adler, const Bytef *buf,
+                                     z_size_t len));
+#endif
+
+        /* in deflate.c */
+void ZLIB_INTERNAL slide_hash_c OF((ushf *table, unsigned n, uInt wsize));
+#ifdef Z_X86_SIMD
+void ZLIB_INTERNAL slide_hash_sse2 OF((ushf *table, unsigned n, uInt wsize));
+void ZLIB_INTERNAL slide_hash_avx2 OF((ushf *table, unsigned n, uInt wsize));
+unsigned ZLIB_INTERNAL compare256_sse2 OF((const Bytef *scan,
+                                           const Bytef *match));
+unsigned ZLIB_INTERNAL compare256_avx2 OF((const Bytef *scan,
+                                           const Bytef *match));
+#endif
+#ifdef Z_ARM_SIMD
+void ZLIB_INTERNAL slide_hash_neon OF((ushf *table, unsigned n, uInt wsize));
+unsigned ZLIB_INTERNAL compare256_neon OF((const Bytef *scan,
+                                           const Bytef *match));
+#endif
+
 #endif /* ZUTIL_H */